@@ -0,0 +1,500 @@
+// Benchmarks for the CPU hot paths (no GL context needed). Prints JSON:
+//   artichoke_bench [--min-time <s>] [--max-joints <n>] [--filter <text>] [--workers <n>] [--output <file>]
+
+#include <cmath>
+#include <chrono>
+#include <cstdio>
+#include <memory>
+#include <string>
+#include <vector>
+#include <cstdlib>
+#include <cstring>
+#include <algorithm>
+#include <filesystem>
+#include <functional>
+
+#include <glm/glm.hpp>
+#include <glm/gtc/quaternion.hpp>
+#include <glm/gtc/matrix_transform.hpp>
+
+#include "Main.hpp"
+#include "Math.hpp"
+#include "JobSystem.hpp"
+#include "Kinematics.hpp"
+#include "ChainGeometry.hpp"
+#include "FrameArena.hpp"
+#include "MemoryTracker.hpp"
+#include "SceneFile.hpp"
+#include "SceneText.hpp"
+#include "JointSeries.hpp"
+#include "Animation.hpp"
+#include "AnimationCompression.hpp"
+#include "PoseBlend.hpp"
+
+
+/* Scene */
+
+struct Scene
+{
+    glm::vec3 root_pos{ 0.0f };
+    glm::quat root_quat{ 1, 0, 0, 0 };
+    std::vector<Joint> joints;
+    std::vector<Tendon> tendons;
+    std::pmr::vector<glm::vec3> tendon_positions;
+    ChainVertices vertices;
+    glm::mat4 view_proj{ 1.0f };
+    std::vector<glm::vec2> screen;
+    glm::mat4 zoom_view_proj{ 1.0f };
+    ChainBounds bounds;
+};
+
+// A gently coiling chain, so every joint has a non-trivial rotation
+static Scene make_scene(size_t count)
+{
+    Scene scene;
+    scene.root_quat = Math::axis_angle_quat(glm::vec3(0, 1, 0), 45.0f);
+    scene.joints.resize(count);
+
+    for (size_t i = 0; i < count; ++i) {
+        Joint& joint = scene.joints[i];
+        joint.local_rot = Math::axis_angle_quat(glm::vec3(1, (i % 3) - 1.0f, 0.5f), 3.0f + (i % 7));
+        joint.length = i + 1 < count ? 10.0f + (i % 5) : 0.0f;
+    }
+    Kinematics::forward_kinematics(scene.joints, scene.root_pos, scene.root_quat);
+
+    // One tendon every fourth bone
+    for (size_t i = 0; i + 1 < count; i += 4) {
+        scene.tendons.push_back({ i, 0.5f, glm::vec2(5.0f, -3.0f), glm::vec3(0, 0, 1) });
+    }
+
+    // Fit the chain into a 1280x720 view
+    glm::vec3 lo(1e30f), hi(-1e30f);
+    for (const auto& joint : scene.joints) {
+        lo = glm::min(lo, joint.pos);
+        hi = glm::max(hi, joint.pos);
+    }
+    scene.view_proj = glm::ortho(lo.x - 1.0f, hi.x + 1.0f, lo.y - 1.0f, hi.y + 1.0f, -1e6f, 1e6f);
+    ChainGeometry::project(scene.joints, scene.view_proj, glm::vec2(1280.0f, 720.0f), scene.screen);
+
+    // Zoomed in on a tenth of the chain's extent around its center
+    glm::vec3 center = 0.5f * (lo + hi), half = 0.05f * (hi - lo) + glm::vec3(1.0f);
+    scene.zoom_view_proj = glm::ortho(center.x - half.x, center.x + half.x, center.y - half.y, center.y + half.y, -1e6f, 1e6f);
+    return scene;
+}
+
+// Four keys of the scene's pose, each joint turned further about its own axis at every key, with squad between them
+static AnimationClip make_clip(const Scene& scene)
+{
+    AnimationClip clip(scene.joints.size());
+    std::vector<Joint> pose = scene.joints;
+    for (int key = 0; key < 4; ++key) {
+        for (size_t i = 0; i < pose.size(); ++i) {
+            pose[i].local_rot = scene.joints[i].local_rot * Math::axis_angle_quat(glm::vec3(1, i % 3, 0), 10.0f * key);
+        }
+        clip.set_pose_key(key * 0.5f, scene.root_pos, scene.root_quat, pose);
+    }
+    clip.set_interpolation(Interpolation::Squad);
+    return clip;
+}
+
+// A recording of the scene swaying, compressed to a tenth of a bone; as many frames as keep the
+// input near 40 MB, so the largest chains stay within memory
+static CompressedClip make_compressed(const Scene& scene)
+{
+    size_t frames = std::clamp<size_t>((40 << 20) / (scene.joints.size() * (sizeof(glm::quat) + sizeof(float))), 8, 600);
+    AnimationCompressor compressor(1.0f / 60.0f);
+    std::vector<Joint> pose = scene.joints;
+    for (size_t f = 0; f < frames; ++f) {
+        for (size_t i = 0; i < pose.size(); ++i) {
+            float angle = 5.0f * std::sin(0.05f * f + 0.1f * (i % 64));
+            pose[i].local_rot = scene.joints[i].local_rot * Math::axis_angle_quat(glm::vec3(0, 1, 0), angle);
+        }
+        compressor.add_frame(scene.root_pos, scene.root_quat, pose);
+    }
+
+    CompressionReport report;
+    CompressedClip clip = compressor.compress(1.0f, report);
+    std::fprintf(stderr, "Compressed %zu joints x %zu frames: %.1f:1, max error %.3f\n", scene.joints.size(), frames, report.ratio(), report.worst_error());
+    return clip;
+}
+
+// Eight poses of the scene and a tree over them: two blends, one masked to the tips, averaged with
+// a third pose, then a difference of two poses and a fourth pose as additive layers
+struct BlendSetup
+{
+    std::vector<std::vector<glm::quat>> poses;
+    std::vector<std::span<const glm::quat>> inputs;
+    BlendTree tree;
+    BlendScratch scratch;
+    std::vector<Joint> joints;
+
+    explicit BlendSetup(size_t joint_count) : tree{ joint_count } {}
+};
+
+static std::unique_ptr<BlendSetup> make_blend(const Scene& scene)
+{
+    size_t count = scene.joints.size();
+    auto blend = std::make_unique<BlendSetup>(count);
+    blend->poses.resize(8, std::vector<glm::quat>(count));
+    for (size_t k = 0; k < blend->poses.size(); ++k) {
+        for (size_t i = 0; i < count; ++i) {
+            blend->poses[k][i] = scene.joints[i].local_rot * Math::axis_angle_quat(glm::vec3(1, k % 3, i % 2), 5.0f * (k + 1));
+        }
+        blend->inputs.emplace_back(blend->poses[k]);
+    }
+
+    std::vector<float> tips(count);
+    for (size_t i = 0; i < count; ++i) {
+        tips[i] = (i % 64) / 63.0f;
+    }
+
+    BlendTree& tree = blend->tree;
+    uint32_t layers[8];
+    for (uint32_t k = 0; k < 8; ++k) {
+        layers[k] = tree.input(k);
+    }
+    uint32_t mask = tree.add_mask(tips);
+    const uint32_t children[] = { tree.blend(layers[0], layers[1], 0.5f), tree.blend(layers[2], layers[3], 0.3f, mask), layers[4] };
+    const float weights[] = { 1.0f, 0.5f, 0.25f };
+    uint32_t posed = tree.add(tree.average(children, weights), tree.difference(layers[5], layers[6]), 0.5f, mask);
+    tree.add(posed, layers[7], 0.2f);
+
+    blend->joints = scene.joints;
+    return blend;
+}
+
+// Saves the scene in both formats and reads it back; both must reproduce it exactly
+static bool check_round_trip(const Scene& scene, const std::string& binary_path, const std::string& text_path)
+{
+    auto same = [&](const glm::vec3& root_pos, const glm::quat& root_quat, std::span<const Joint> joints, std::span<const Tendon> tendons) {
+        return root_pos == scene.root_pos && root_quat == scene.root_quat &&
+            joints.size() == scene.joints.size() && std::memcmp(joints.data(), scene.joints.data(), joints.size_bytes()) == 0 &&
+            tendons.size() == scene.tendons.size() && std::memcmp(tendons.data(), scene.tendons.data(), tendons.size_bytes()) == 0;
+    };
+
+    SceneWriter binary_writer;
+    SceneTextWriter text_writer;
+    if (!binary_writer.open(binary_path) || !binary_writer.write_chain(scene.root_pos, scene.root_quat, scene.joints, scene.tendons) || !binary_writer.finish()) { return false; }
+    if (!text_writer.open(text_path) || !text_writer.write_chain(scene.root_pos, scene.root_quat, scene.joints, scene.tendons) || !text_writer.finish()) { return false; }
+
+    SceneReader binary_reader;
+    if (!binary_reader.open(binary_path) || binary_reader.chain_count() != 1) { return false; }
+    SceneChainView view = binary_reader.chain(0);
+    if (!same(view.root_pos, view.root_quat, view.joints, view.tendons)) {
+        std::fprintf(stderr, "%s does not reproduce the scene\n", binary_path.c_str());
+        return false;
+    }
+
+    size_t chains = 0;
+    bool text_same = true;
+    SceneTextReader text_reader;
+    bool read = text_reader.read(text_path, [&](SceneChain&& chain) {
+        ++chains;
+        text_same = text_same && same(chain.root_pos, chain.root_quat, chain.joints, chain.tendons);
+    });
+    if (!read || chains != 1 || !text_same) {
+        std::fprintf(stderr, "%s does not reproduce the scene\n", text_path.c_str());
+        return false;
+    }
+    return true;
+}
+
+
+/* Runner */
+
+struct Result
+{
+    std::string name;
+    MemoryTag tag;
+    size_t joints;
+    uint64_t iterations;
+    double ns_per_iter;
+    double allocs_per_iter;
+    double bytes_per_iter;
+    int64_t peak_bytes;         // Heap growth above the starting point while timing
+    int64_t retained_bytes;     // Still allocated afterwards
+};
+
+struct Settings
+{
+    double min_time = 0.1;
+    size_t max_joints = 1000000;
+    std::string filter;
+    int workers = -1;
+    const char* output = nullptr;
+};
+
+static Result run(const char* name, MemoryTag tag, size_t joints, double min_time, const std::function<void()>& body)
+{
+    using Clock = std::chrono::steady_clock;
+    MemoryTracker::Scope memory(tag);
+
+    // Warm up caches and scratch buffers
+    body();
+
+    // Median of five batches, each at least min_time / 5 long
+    std::vector<double> batches;
+    batches.reserve(5);
+    uint64_t iterations = 0, allocs = 0, bytes = 0;
+    double batch_time = min_time / 5.0;
+
+    MemoryTracker::Snapshot start_memory = MemoryTracker::snapshot();
+    MemoryTracker::reset_peak();
+
+    for (int batch = 0; batch < 5; ++batch) {
+        MemoryTracker::Snapshot before = MemoryTracker::snapshot();
+        uint64_t count = 0;
+
+        auto start = Clock::now();
+        double elapsed = 0.0;
+        do {
+            body();
+            ++count;
+            elapsed = std::chrono::duration<double>(Clock::now() - start).count();
+        } while (elapsed < batch_time);
+
+        batches.push_back(elapsed * 1e9 / count);
+        iterations += count;
+        MemoryTracker::Snapshot after = MemoryTracker::snapshot();
+        allocs += after.allocations - before.allocations;
+        bytes += after.bytes - before.bytes;
+    }
+
+    MemoryTracker::Snapshot end_memory = MemoryTracker::snapshot();
+
+    std::nth_element(batches.begin(), batches.begin() + 2, batches.end());
+    return { name, tag, joints, iterations, batches[2], double(allocs) / iterations, double(bytes) / iterations,
+        end_memory.peak_bytes - start_memory.live_bytes, end_memory.live_bytes - start_memory.live_bytes };
+}
+
+static Settings parse(int argc, char** argv)
+{
+    Settings settings;
+    for (int i = 1; i < argc; ++i) {
+        std::string arg = argv[i];
+        auto value = [&]() -> const char* {
+            if (i + 1 >= argc) {
+                std::fprintf(stderr, "Missing value for %s\n", arg.c_str());
+                std::exit(1);
+            }
+            return argv[++i];
+        };
+
+        if (arg == "--min-time") { settings.min_time = std::max(0.001, std::atof(value())); }
+        else if (arg == "--max-joints") { settings.max_joints = std::strtoull(value(), nullptr, 10); }
+        else if (arg == "--filter") { settings.filter = value(); }
+        else if (arg == "--workers") { settings.workers = std::max(0, std::atoi(value())); }
+        else if (arg == "--output") { settings.output = value(); }
+        else {
+            std::fprintf(stderr, "Usage: %s [--min-time <s>] [--max-joints <n>] [--filter <text>] [--workers <n>] [--output <file>]\n", argv[0]);
+            std::exit(arg == "--help" ? 0 : 1);
+        }
+    }
+    return settings;
+}
+
+int main(int argc, char** argv)
+{
+    Settings settings = parse(argc, argv);
+    JobSystem::configure(settings.workers);
+
+    const size_t sizes[] = { 5, 64, 1000, 10000, 100000, 1000000 };
+    std::vector<Result> results;
+
+    std::filesystem::path temp = std::filesystem::temp_directory_path();
+    std::string binary_path = (temp / "artichoke_bench.artscn").string();
+    std::string text_path = (temp / "artichoke_bench.txt").string();
+    std::string series_path = (temp / "artichoke_bench.series").string();
+
+    for (size_t size : sizes) {
+        if (size > settings.max_joints) break;
+
+        Scene scene = make_scene(size);
+        bool round_trip_checked = false;
+        std::unique_ptr<JointSeriesWriter> series;
+        double series_time = 0.0;
+        std::unique_ptr<AnimationClip> clip;
+        AnimationCursor cursor;
+        float clip_time = 0.0f;
+        std::unique_ptr<CompressedClip> compressed;
+        AnimationCursor compressed_cursor;
+        float compressed_time = 0.0f;
+        std::unique_ptr<BlendSetup> blend;
+        glm::vec2 display_size(1280.0f, 720.0f);
+        glm::vec2 mouse(640.0f, 360.0f);
+        volatile float sink = 0.0f;
+
+        struct Case
+        {
+            const char* name;
+            MemoryTag tag;
+            std::function<void()> body;
+        };
+
+        const Case cases[] = {
+            { "forward_kinematics", MemoryTag::Kinematics, [&] {
+                Kinematics::forward_kinematics(scene.joints, scene.root_pos, scene.root_quat);
+            } },
+            { "forward_kinematics_parallel", MemoryTag::Kinematics, [&] {
+                Kinematics::forward_kinematics_parallel(scene.joints, scene.root_pos, scene.root_quat);
+            } },
+            { "rotate_joints", MemoryTag::Kinematics, [&] {
+                Kinematics::rotate_joints(scene.joints, scene.root_quat);
+            } },
+            { "compute_frame_quat", MemoryTag::Kinematics, [&] {
+                float sum = 0.0f;
+                for (size_t i = 0; i + 1 < scene.joints.size(); ++i) {
+                    sum += Math::compute_frame_quat(scene.joints[i].pos, scene.joints[i + 1].pos).w;
+                }
+                sink = sum;
+            } },
+            { "tendon_positions", MemoryTag::Rendering, [&] {
+                ChainGeometry::tendon_positions(scene.joints, scene.tendons, scene.tendon_positions);
+            } },
+            { "pick_joint", MemoryTag::Rendering, [&] {
+                sink = static_cast<float>(ChainGeometry::pick(scene.joints, scene.view_proj, display_size, mouse, 15.0f));
+            } },
+            { "pick_joint_projected", MemoryTag::Rendering, [&] {
+                // Hover picking while neither the camera nor the pose changes
+                sink = static_cast<float>(ChainGeometry::pick(scene.screen, mouse, 15.0f));
+            } },
+            { "build_vertices", MemoryTag::Rendering, [&] {
+                ChainGeometry::build(scene.joints, scene.tendon_positions, scene.vertices);
+            } },
+            { "build_vertices_culled", MemoryTag::Rendering, [&] {
+                // Chain::render's culling path with the zoomed-in view
+                FrameArena& arena = FrameArena::frame();
+                {
+                    FrameArena::Scope scope(arena);
+                    std::pmr::vector<JointRange> ranges(&arena);
+                    ChainVertices vertices(&arena);
+                    ChainGeometry::bounds(scene.joints, ChainGeometry::axis_length, scene.bounds);
+                    ChainGeometry::visible(scene.bounds, scene.joints.size(), Frustum::from_view_proj(scene.zoom_view_proj), ranges);
+                    ChainGeometry::build(scene.joints, ranges, {}, vertices);
+                    sink = static_cast<float>(vertices.joint_main.size());
+                }
+                arena.reset();
+            } },
+            { "build_vertices_lod", MemoryTag::Rendering, [&] {
+                // Whole chain in view with screen-space level of detail
+                FrameArena& arena = FrameArena::frame();
+                {
+                    FrameArena::Scope scope(arena);
+                    JointRange all{ 0, scene.joints.size() };
+                    ChainLod lod;
+                    lod.view_proj = scene.view_proj;
+                    lod.viewport = display_size;
+                    ChainVertices vertices(&arena);
+                    ChainGeometry::build(scene.joints, { &all, 1 }, {}, lod, vertices);
+                    sink = static_cast<float>(vertices.joint_main.size());
+                }
+                arena.reset();
+            } },
+            { "chain_render_cpu", MemoryTag::Rendering, [&] {
+                // CPU side of Chain::render: arena-backed batches, released at the end of the frame
+                FrameArena& arena = FrameArena::frame();
+                {
+                    FrameArena::Scope scope(arena);
+                    std::pmr::vector<glm::vec3> tendon_positions(&arena);
+                    ChainVertices vertices(&arena);
+                    ChainGeometry::tendon_positions(scene.joints, scene.tendons, tendon_positions);
+                    ChainGeometry::build(scene.joints, tendon_positions, vertices);
+                }
+                arena.reset();
+            } },
+            { "scene_binary_save", MemoryTag::IO, [&] {
+                SceneWriter writer;
+                writer.open(binary_path);
+                writer.write_chain(scene.root_pos, scene.root_quat, scene.joints, scene.tendons);
+                writer.finish();
+            } },
+            { "scene_binary_load", MemoryTag::IO, [&] {
+                SceneReader reader;
+                reader.open(binary_path);
+                sink = reader.chain(0).joints.back().length;
+            } },
+            { "scene_text_save", MemoryTag::IO, [&] {
+                SceneTextWriter writer;
+                writer.open(text_path);
+                writer.write_chain(scene.root_pos, scene.root_quat, scene.joints, scene.tendons);
+                writer.finish();
+            } },
+            { "scene_text_load", MemoryTag::IO, [&] {
+                SceneTextReader reader;
+                reader.read(text_path, [&](SceneChain&& chain) { sink = chain.joints.back().length; });
+            } },
+            { "joint_series_write", MemoryTag::IO, [&] {
+                // Sustained rate: the writer's queue is bounded and sampling waits while it is full
+                if (!series) {
+                    series = std::make_unique<JointSeriesWriter>(series_path, true);
+                    series->start();
+                }
+                series->sample(series_time, scene.joints, scene.tendons);
+                series_time += 0.001;
+            } },
+            { "animation_sample", MemoryTag::Kinematics, [&] {
+                // Playback at 60 fps, so the cursor moves on from the key it was at
+                if (!clip) { clip = std::make_unique<AnimationClip>(make_clip(scene)); }
+                clip->sample(clip_time, cursor);
+                clip_time = std::fmod(clip_time + 1.0f / 60.0f, clip->duration());
+                sink = cursor.rotations.back().w;
+            } },
+            { "compressed_sample", MemoryTag::Kinematics, [&] {
+                // Playback at 60 fps of a recording compressed with the default key reduction
+                if (!compressed) { compressed = std::make_unique<CompressedClip>(make_compressed(scene)); }
+                compressed->sample(compressed_time, compressed_cursor);
+                compressed_time = std::fmod(compressed_time + 1.0f / 60.0f, std::max(compressed->duration(), 1.0f / 60.0f));
+                sink = compressed_cursor.rotations.back().w;
+            } },
+            { "pose_blend", MemoryTag::Kinematics, [&] {
+                // Eight layers into the local rotations, as FK takes them
+                if (!blend) { blend = make_blend(scene); }
+                blend->tree.evaluate(blend->inputs, blend->scratch, std::span<Joint>(blend->joints));
+                sink = blend->joints.back().local_rot.w;
+            } },
+        };
+
+        for (const Case& c : cases) {
+            if (!settings.filter.empty() && std::strstr(c.name, settings.filter.c_str()) == nullptr) continue;
+
+            // Scene file cases read the files written by the check
+            if (std::strncmp(c.name, "scene_", 6) == 0 && !round_trip_checked) {
+                if (!check_round_trip(scene, binary_path, text_path)) {
+                    std::fprintf(stderr, "Scene round trip failed at %zu joints\n", size);
+                    return 1;
+                }
+                round_trip_checked = true;
+            }
+            results.push_back(run(c.name, c.tag, size, settings.min_time, c.body));
+            std::fprintf(stderr, "%-28s %8zu joints %12.1f ns/iter\n", c.name, size, results.back().ns_per_iter);
+        }
+        series.reset();
+        clip.reset();
+        compressed.reset();
+        blend.reset();
+    }
+
+    std::filesystem::remove(binary_path);
+    std::filesystem::remove(text_path);
+    std::filesystem::remove(series_path);
+
+    std::FILE* out = settings.output ? std::fopen(settings.output, "w") : stdout;
+    if (!out) {
+        std::fprintf(stderr, "Failed to open %s\n", settings.output);
+        return 1;
+    }
+
+    std::fprintf(out, "{\n  \"workers\": %zu,\n  \"memory_tracking\": %s,\n  \"benchmarks\": [", 
+        JobSystem::instance().worker_count(), MemoryTracker::enabled ? "true" : "false");
+    for (size_t i = 0; i < results.size(); ++i) {
+        const Result& r = results[i];
+        std::fprintf(out, "%s\n    {\"name\": \"%s\", \"subsystem\": \"%s\", \"joints\": %zu, \"iterations\": %llu, \"ns_per_iter\": %.1f, "
+            "\"ns_per_joint\": %.3f, \"allocs_per_iter\": %.3f, \"bytes_per_iter\": %.1f, \"peak_bytes\": %lld, \"retained_bytes\": %lld}",
+            i ? "," : "", r.name.c_str(), MemoryTracker::tag_name(r.tag), r.joints, static_cast<unsigned long long>(r.iterations), r.ns_per_iter,
+            r.ns_per_iter / r.joints, r.allocs_per_iter, r.bytes_per_iter, static_cast<long long>(r.peak_bytes), static_cast<long long>(r.retained_bytes));
+    }
+    std::fprintf(out, "\n  ]\n}\n");
+
+    if (out != stdout) { std::fclose(out); }
+    return 0;
+}
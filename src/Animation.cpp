@@ -0,0 +1,384 @@
+#include "Animation.hpp"
+
+#include <cmath>
+#include <algorithm>
+
+#include "Math.hpp"
+#include "AnimationSeek.hpp"
+
+
+namespace
+{
+    // Logarithm of a unit quaternion and exponential of a pure one, as vectors
+    glm::vec3 log_unit(const glm::quat& q)
+    {
+        glm::vec3 v(q.x, q.y, q.z);
+        float s = glm::length(v);
+        return s < 1e-7f ? glm::vec3(0.0f) : v * (std::atan2(s, q.w) / s);
+    }
+
+    glm::quat exp_pure(const glm::vec3& v)
+    {
+        float angle = glm::length(v);
+        if (angle < 1e-7f) { return glm::quat(1.0f, v.x, v.y, v.z); }
+        glm::vec3 axis = v * (std::sin(angle) / angle);
+        return glm::quat(std::cos(angle), axis.x, axis.y, axis.z);
+    }
+}
+
+
+AnimationClip::AnimationClip(size_t joint_count) :
+    rotation_tracks_(joint_count + 1, Track{ 0, 0, Interpolation::Slerp }), length_tracks_(joint_count, Track{ 0, 0, Interpolation::Slerp })
+{
+}
+
+bool AnimationClip::empty() const
+{
+    return rotation_times_.empty() && length_times_.empty() && root_pos_times_.empty();
+}
+
+void AnimationClip::set_rotation_key(size_t joint, float time, const glm::quat& value)
+{
+    grow(joint + 1);
+    size_t key = insert_key(rotation_tracks_, joint, rotation_times_, rotation_keys_, time);
+    rotation_keys_[key].value = glm::normalize(value);
+    update_controls(joint);
+    update_duration();
+}
+
+void AnimationClip::set_length_key(size_t joint, float time, float value)
+{
+    grow(joint + 1);
+    length_keys_[insert_key(length_tracks_, joint, length_times_, length_keys_, time)] = value;
+    update_duration();
+}
+
+void AnimationClip::set_root_key(float time, const glm::vec3& pos, const glm::quat& rot)
+{
+    size_t root = joint_count();
+    size_t key = insert_key(rotation_tracks_, root, rotation_times_, rotation_keys_, time);
+    rotation_keys_[key].value = glm::normalize(rot);
+    update_controls(root);
+    root_pos_keys_[insert_key(root_pos_track_, 0, root_pos_times_, root_pos_keys_, time)] = pos;
+    update_duration();
+}
+
+void AnimationClip::set_pose_key(float time, const glm::vec3& root_pos, const glm::quat& root_quat, std::span<const Joint> joints)
+{
+    grow(joints.size());
+    size_t root = joint_count();
+
+    key_tracks(rotation_tracks_, rotation_times_, rotation_keys_, time, [&](size_t track, RotationKey& key) {
+        if (track < joints.size()) { key.value = glm::normalize(joints[track].local_rot); }
+        else if (track == root) { key.value = glm::normalize(root_quat); }
+        else { return false; }
+        return true;
+    });
+    key_tracks(length_tracks_, length_times_, length_keys_, time, [&](size_t track, float& key) {
+        if (track >= joints.size()) { return false; }
+        key = joints[track].length;
+        return true;
+    });
+    key_tracks(root_pos_track_, root_pos_times_, root_pos_keys_, time, [&](size_t, glm::vec3& key) {
+        key = root_pos;
+        return true;
+    });
+
+    for (size_t track = 0; track < rotation_tracks_.size(); ++track) {
+        update_controls(track);
+    }
+    update_duration();
+}
+
+void AnimationClip::remove_keys(float time)
+{
+    remove_keys(rotation_tracks_, rotation_times_, rotation_keys_, time);
+    remove_keys(length_tracks_, length_times_, length_keys_, time);
+    remove_keys(root_pos_track_, root_pos_times_, root_pos_keys_, time);
+
+    for (size_t track = 0; track < rotation_tracks_.size(); ++track) {
+        update_controls(track);
+    }
+    update_duration();
+}
+
+void AnimationClip::set_interpolation(size_t track, Interpolation interpolation)
+{
+    rotation_tracks_[track].interpolation = interpolation;
+}
+
+void AnimationClip::set_interpolation(Interpolation interpolation)
+{
+    for (Track& track : rotation_tracks_) {
+        track.interpolation = interpolation;
+    }
+}
+
+void AnimationClip::key_times(std::vector<float>& out) const
+{
+    out.clear();
+    out.insert(out.end(), rotation_times_.begin(), rotation_times_.end());
+    out.insert(out.end(), length_times_.begin(), length_times_.end());
+    out.insert(out.end(), root_pos_times_.begin(), root_pos_times_.end());
+    std::sort(out.begin(), out.end());
+    out.erase(std::unique(out.begin(), out.end()), out.end());
+}
+
+void AnimationClip::sample(float time, AnimationCursor& cursor) const
+{
+    size_t joints = joint_count();
+    size_t tracks = rotation_tracks_.size();
+    cursor.rotations.resize(joints);
+    cursor.lengths.resize(joints);
+    cursor.rotation_keys.resize(tracks);
+    cursor.length_keys.resize(joints);
+    cursor.a.resize(tracks);
+    cursor.b.resize(tracks);
+    cursor.sa.resize(tracks);
+    cursor.sb.resize(tracks);
+    cursor.out.resize(tracks);
+    cursor.t.resize(tracks);
+    cursor.targets.resize(tracks);
+
+    // Rotations: the segment of every track is gathered, then interpolated in one batch per interpolation
+    for (Interpolation kind : { Interpolation::Slerp, Interpolation::Squad }) {
+        size_t count = 0;
+        for (size_t track = 0; track < tracks; ++track) {
+            const Track& range = rotation_tracks_[track];
+            if (range.count == 0 || range.interpolation != kind) continue;
+
+            float t = 0.0f;
+            uint32_t key = seek_key(rotation_times_.data() + range.first, range.count, time, cursor.rotation_keys[track], t);
+            const RotationKey& a = rotation_keys_[range.first + key];
+            const RotationKey& b = rotation_keys_[range.first + std::min(key + 1, range.count - 1)];
+
+            // Both ends on the same side, with the control point following its key
+            float flip = glm::dot(a.value, b.value) < 0.0f ? -1.0f : 1.0f;
+            cursor.a[count] = a.value;
+            cursor.b[count] = b.value * flip;
+            if (kind == Interpolation::Squad) {
+                cursor.sa[count] = a.control;
+                cursor.sb[count] = b.control * flip;
+            }
+            cursor.t[count] = t;
+            cursor.targets[count] = static_cast<uint32_t>(track);
+            ++count;
+        }
+        if (count == 0) continue;
+
+        std::span<glm::quat> out(cursor.out.data(), count);
+        if (kind == Interpolation::Slerp) {
+            Math::slerp({ cursor.a.data(), count }, { cursor.b.data(), count }, { cursor.t.data(), count }, out);
+        }
+        else {
+            Math::squad({ cursor.a.data(), count }, { cursor.b.data(), count }, { cursor.sa.data(), count }, { cursor.sb.data(), count },
+                { cursor.t.data(), count }, out);
+        }
+
+        for (size_t i = 0; i < count; ++i) {
+            uint32_t target = cursor.targets[i];
+            if (target < joints) { cursor.rotations[target] = out[i]; }
+            else { cursor.root_quat = out[i]; }
+        }
+    }
+
+    for (size_t joint = 0; joint < joints; ++joint) {
+        const Track& range = length_tracks_[joint];
+        if (range.count == 0) continue;
+
+        float t = 0.0f;
+        uint32_t key = seek_key(length_times_.data() + range.first, range.count, time, cursor.length_keys[joint], t);
+        const float* keys = length_keys_.data() + range.first;
+        cursor.lengths[joint] = keys[key] + (keys[std::min(key + 1, range.count - 1)] - keys[key]) * t;
+    }
+
+    const Track& range = root_pos_track_[0];
+    if (range.count > 0) {
+        float t = 0.0f;
+        uint32_t key = seek_key(root_pos_times_.data(), range.count, time, cursor.root_pos_key, t);
+        cursor.root_pos = glm::mix(root_pos_keys_[key], root_pos_keys_[std::min(key + 1, range.count - 1)], t);
+    }
+}
+
+void AnimationClip::apply(const AnimationCursor& cursor, glm::vec3& root_pos, glm::quat& root_quat, std::span<Joint> joints) const
+{
+    size_t count = std::min(joints.size(), std::min(joint_count(), cursor.rotations.size()));
+    for (size_t i = 0; i < count; ++i) {
+        if (rotation_tracks_[i].count > 0) { joints[i].local_rot = cursor.rotations[i]; }
+        if (length_tracks_[i].count > 0) { joints[i].length = cursor.lengths[i]; }
+    }
+    if (rotation_tracks_.back().count > 0) { root_quat = cursor.root_quat; }
+    if (root_pos_track_[0].count > 0) { root_pos = cursor.root_pos; }
+}
+
+template <typename T>
+size_t AnimationClip::insert_key(std::vector<Track>& tracks, size_t track, std::vector<float>& times, std::vector<T>& values, float time)
+{
+    Track& range = tracks[track];
+    auto begin = times.begin() + range.first;
+    auto end = begin + range.count;
+    auto at = std::lower_bound(begin, end, time);
+    size_t index = static_cast<size_t>(at - times.begin());
+    if (at != end && *at == time) { return index; }
+
+    times.insert(at, time);
+    values.insert(values.begin() + index, T{});
+    ++range.count;
+    for (size_t i = track + 1; i < tracks.size(); ++i) {
+        ++tracks[i].first;
+    }
+    return index;
+}
+
+template <typename T, typename Value>
+void AnimationClip::key_tracks(std::vector<Track>& tracks, std::vector<float>& times, std::vector<T>& values, float time, Value value)
+{
+    std::vector<float> new_times;
+    std::vector<T> new_values;
+    new_times.reserve(times.size() + tracks.size());
+    new_values.reserve(values.size() + tracks.size());
+
+    for (size_t track = 0; track < tracks.size(); ++track) {
+        Track& range = tracks[track];
+        auto begin = times.begin() + range.first;
+        auto end = begin + range.count;
+        auto at = std::lower_bound(begin, end, time);
+        size_t split = static_cast<size_t>(at - times.begin());
+        size_t rest = split;
+
+        uint32_t first = static_cast<uint32_t>(new_times.size());
+        new_times.insert(new_times.end(), begin, at);
+        new_values.insert(new_values.end(), values.begin() + range.first, values.begin() + split);
+
+        // A key at the same time is replaced
+        T key{};
+        if (value(track, key)) {
+            new_times.push_back(time);
+            new_values.push_back(key);
+            if (at != end && *at == time) { ++rest; }
+        }
+        new_times.insert(new_times.end(), times.begin() + rest, end);
+        new_values.insert(new_values.end(), values.begin() + rest, values.begin() + range.first + range.count);
+
+        range.first = first;
+        range.count = static_cast<uint32_t>(new_times.size() - first);
+    }
+
+    times = std::move(new_times);
+    values = std::move(new_values);
+}
+
+template <typename T>
+void AnimationClip::remove_keys(std::vector<Track>& tracks, std::vector<float>& times, std::vector<T>& values, float time)
+{
+    size_t write = 0;
+    for (Track& range : tracks) {
+        uint32_t first = static_cast<uint32_t>(write);
+        for (size_t read = range.first; read < range.first + range.count; ++read) {
+            if (times[read] == time) continue;
+            times[write] = times[read];
+            values[write] = values[read];
+            ++write;
+        }
+        range.first = first;
+        range.count = static_cast<uint32_t>(write - first);
+    }
+    times.resize(write);
+    values.resize(write);
+}
+
+void AnimationClip::grow(size_t joint_count)
+{
+    size_t joints = this->joint_count();
+    if (joint_count <= joints) return;
+
+    // New joint tracks go before the root's, empty and with its interpolation
+    Track root = rotation_tracks_.back();
+    rotation_tracks_.insert(rotation_tracks_.end() - 1, joint_count - joints, Track{ root.first, 0, root.interpolation });
+    length_tracks_.resize(joint_count, Track{ static_cast<uint32_t>(length_times_.size()), 0, Interpolation::Slerp });
+}
+
+void AnimationClip::update_controls(size_t track)
+{
+    const Track& range = rotation_tracks_[track];
+    RotationKey* keys = rotation_keys_.data() + range.first;
+
+    // s_i = q_i exp(-(log(q_i^-1 q_i+1) + log(q_i^-1 q_i-1)) / 4), with the neighbours on q_i's side
+    for (uint32_t i = 0; i < range.count; ++i) {
+        const glm::quat& q = keys[i].value;
+        glm::quat prev = keys[i > 0 ? i - 1 : 0].value;
+        glm::quat next = keys[std::min(i + 1, range.count - 1)].value;
+        if (glm::dot(q, prev) < 0.0f) { prev = -prev; }
+        if (glm::dot(q, next) < 0.0f) { next = -next; }
+
+        glm::quat inverse = glm::conjugate(q);
+        keys[i].control = glm::normalize(q * exp_pure(-0.25f * (log_unit(inverse * next) + log_unit(inverse * prev))));
+    }
+}
+
+void AnimationClip::update_duration()
+{
+    duration_ = 0.0f;
+    auto last = [&](const std::vector<Track>& tracks, const std::vector<float>& times) {
+        for (const Track& range : tracks) {
+            if (range.count > 0) { duration_ = std::max(duration_, times[range.first + range.count - 1]); }
+        }
+    };
+    last(rotation_tracks_, rotation_times_);
+    last(length_tracks_, length_times_);
+    last(root_pos_track_, root_pos_times_);
+}
+
+
+void AnimationTimeline::scrub(float time)
+{
+    time_ = std::max(time, 0.0f);
+    pending_ = true;
+}
+
+void AnimationTimeline::set_playing(bool playing)
+{
+    // Playing from the end starts over
+    if (playing && !playing_ && time_ >= clip_.duration()) { time_ = 0.0f; }
+    playing_ = playing && clip_.duration() > 0.0f;
+}
+
+void AnimationTimeline::key(const glm::vec3& root_pos, const glm::quat& root_quat, std::span<const Joint> joints)
+{
+    clip_.set_pose_key(time_, root_pos, root_quat, joints);
+}
+
+void AnimationTimeline::remove_key()
+{
+    clip_.remove_keys(time_);
+    pending_ = true;
+}
+
+void AnimationTimeline::advance(double seconds)
+{
+    if (!playing_) return;
+
+    float duration = clip_.duration();
+    time_ += static_cast<float>(seconds);
+    if (time_ >= duration) {
+        if (loop_ && duration > 0.0f) {
+            time_ = std::fmod(time_, duration);
+        }
+        else {
+            time_ = duration;
+            playing_ = false;
+        }
+    }
+    pending_ = true;
+}
+
+bool AnimationTimeline::take_pose(glm::vec3& root_pos, glm::quat& root_quat, std::span<Joint> joints)
+{
+    if (!pending_) return false;
+    pending_ = false;
+    if (clip_.empty()) return false;
+
+    clip_.sample(time_, cursor_);
+    clip_.apply(cursor_, root_pos, root_quat, joints);
+    return true;
+}
@@ -0,0 +1,161 @@
+#pragma once
+
+#include <span>
+#include <vector>
+#include <cstdint>
+
+#include <glm/glm.hpp>
+#include <glm/gtc/quaternion.hpp>
+
+#include "Main.hpp"
+
+
+// Interpolation between the rotation keys of a track; lengths and root positions are linear
+enum class Interpolation : uint8_t
+{
+    Slerp,
+    Squad                   // Smooth through the keys, with control points from their neighbours
+};
+
+
+// Pose sampled from a clip, and the key each track was at, so that playing forward continues
+// from there instead of searching. One per playing instance of a clip; sampling resizes its
+// buffers, which keep their capacity, so only the first sample allocates.
+struct AnimationCursor
+{
+    std::vector<glm::quat> rotations;       // Per joint
+    std::vector<float> lengths;
+    glm::vec3 root_pos{ 0.0f };
+    glm::quat root_quat{ 1, 0, 0, 0 };
+
+    std::vector<uint32_t> rotation_keys;    // Per rotation track, the root last
+    std::vector<uint32_t> length_keys;
+    uint32_t root_pos_key{ 0 };
+
+    // Rotation segments of a sample, gathered per interpolation for the batch kernels
+    std::vector<glm::quat> a, b, sa, sb, out;
+    std::vector<float> t;
+    std::vector<uint32_t> targets;
+
+    // Compressed clips keep each track's segment decoded in a and b until its key changes
+    std::vector<uint32_t> decoded_keys;
+};
+
+
+// Keyframed tracks for a chain: a local rotation and a bone length per joint, plus the root
+// position and rotation. The keys of all tracks of a kind share one array of times and one
+// of values, each track a contiguous run in time order, so sampling reads them sequentially.
+// Tracks without keys leave their part of the pose as it is.
+class AnimationClip
+{
+public:
+    AnimationClip() = default;
+    explicit AnimationClip(size_t joint_count);
+
+    size_t joint_count() const { return length_tracks_.size(); }
+    float duration() const { return duration_; }
+    bool empty() const;
+
+    // Keys are kept in time order; a key at the time of an existing one replaces it
+    void set_rotation_key(size_t joint, float time, const glm::quat& value);
+    void set_length_key(size_t joint, float time, float value);
+    void set_root_key(float time, const glm::vec3& pos, const glm::quat& rot);
+
+    // Keys every track, adding tracks for joints the clip does not have yet
+    void set_pose_key(float time, const glm::vec3& root_pos, const glm::quat& root_quat, std::span<const Joint> joints);
+    void remove_keys(float time);
+
+    // Per rotation track; the root's is joint_count()
+    void set_interpolation(size_t track, Interpolation interpolation);
+    void set_interpolation(Interpolation interpolation);
+    Interpolation interpolation(size_t track) const { return rotation_tracks_[track].interpolation; }
+
+    // Distinct key times over all tracks, in order
+    void key_times(std::vector<float>& out) const;
+
+    // Samples every track at the given time into the cursor
+    void sample(float time, AnimationCursor& cursor) const;
+
+    // Writes the sampled values of tracks with keys into the pose; joints beyond the clip are left as they are
+    void apply(const AnimationCursor& cursor, glm::vec3& root_pos, glm::quat& root_quat, std::span<Joint> joints) const;
+
+private:
+    struct Track
+    {
+        uint32_t first;
+        uint32_t count;
+        Interpolation interpolation;
+    };
+
+    struct RotationKey
+    {
+        glm::quat value;
+        glm::quat control;          // Squad control point
+    };
+
+    // Index of the key at the time within the track, inserting one if there is none
+    template <typename T>
+    static size_t insert_key(std::vector<Track>& tracks, size_t track, std::vector<float>& times, std::vector<T>& values, float time);
+
+    // Keys a time in all tracks of a kind in one pass; value(track, out) is false for tracks to leave out
+    template <typename T, typename Value>
+    static void key_tracks(std::vector<Track>& tracks, std::vector<float>& times, std::vector<T>& values, float time, Value value);
+
+    template <typename T>
+    static void remove_keys(std::vector<Track>& tracks, std::vector<float>& times, std::vector<T>& values, float time);
+
+    void grow(size_t joint_count);
+    void update_controls(size_t track);
+    void update_duration();
+
+private:
+    std::vector<Track> rotation_tracks_{ Track{ 0, 0, Interpolation::Slerp } };
+    std::vector<float> rotation_times_;
+    std::vector<RotationKey> rotation_keys_;
+
+    std::vector<Track> length_tracks_;
+    std::vector<float> length_times_;
+    std::vector<float> length_keys_;
+
+    std::vector<Track> root_pos_track_{ Track{ 0, 0, Interpolation::Slerp } };
+    std::vector<float> root_pos_times_;
+    std::vector<glm::vec3> root_pos_keys_;
+
+    float duration_{ 0.0f };
+};
+
+
+// The edited chain's clip with a playhead, as the overlay's timeline edits it
+class AnimationTimeline
+{
+public:
+    AnimationClip& clip() { return clip_; }
+    const AnimationClip& clip() const { return clip_; }
+    float time() const { return time_; }
+    bool playing() const { return playing_; }
+
+    void scrub(float time);
+    void set_playing(bool playing);
+    void set_loop(bool loop) { loop_ = loop; }
+    bool loop() const { return loop_; }
+
+    // Keys the pose at the playhead, or removes the keys there
+    void key(const glm::vec3& root_pos, const glm::quat& root_quat, std::span<const Joint> joints);
+    void remove_key();
+    void changed() { pending_ = true; }
+    bool pending() const { return pending_; }
+
+    // Moves the playhead while playing; stops at the end unless looping
+    void advance(double seconds);
+
+    // True once after the playhead or the keys changed, with the clip's pose applied to the given one
+    bool take_pose(glm::vec3& root_pos, glm::quat& root_quat, std::span<Joint> joints);
+
+private:
+    AnimationClip clip_;
+    AnimationCursor cursor_;
+    float time_{ 0.0f };
+    bool playing_{ false };
+    bool loop_{ true };
+    bool pending_{ false };
+};
@@ -0,0 +1,396 @@
+#include "AnimationCompression.hpp"
+
+#include <cmath>
+#include <cfloat>
+#include <algorithm>
+
+#include <glm/gtc/constants.hpp>
+
+#include "Math.hpp"
+#include "Kinematics.hpp"
+#include "AnimationSeek.hpp"
+
+
+namespace
+{
+    constexpr float quat_steps = 32767.0f;      // 15 bits per smallest-three component
+    constexpr float value_steps = 65535.0f;     // 16 bits per length or position component
+    constexpr uint32_t max_span = 64;           // Frames from one kept key to the next
+    constexpr int max_passes = 8;               // Halving the bounds; the last pass keeps every key
+
+    // The three smallest components of a unit quaternion, in x, y, z, w order, signed so that the
+    // largest is positive; returns the index of the largest
+    uint32_t smallest_three(const glm::quat& q, glm::vec3& out)
+    {
+        float c[4] = { q.x, q.y, q.z, q.w };
+        uint32_t largest = 0;
+        for (uint32_t i = 1; i < 4; ++i) {
+            if (std::abs(c[i]) > std::abs(c[largest])) { largest = i; }
+        }
+        float sign = c[largest] < 0.0f ? -1.0f : 1.0f;
+        for (uint32_t i = 0, k = 0; i < 4; ++i) {
+            if (i != largest) { out[k++] = c[i] * sign; }
+        }
+        return largest;
+    }
+
+    uint32_t quantize(float value, float min, float scale, float steps)
+    {
+        return scale > 0.0f ? static_cast<uint32_t>(std::clamp(std::round((value - min) / scale), 0.0f, steps)) : 0;
+    }
+
+    // Greedy key reduction: from each kept frame, the next key is the farthest frame within max_span
+    // that fits(key, next) accepts for every frame in between. The span doubles while it fits and is
+    // then bisected, so a span costs a logarithmic number of checks.
+    template <typename Fits>
+    void reduce(uint32_t frames, Fits fits, std::vector<uint32_t>& kept)
+    {
+        kept.assign(1, 0);
+        uint32_t key = 0;
+        while (key + 1 < frames) {
+            uint32_t limit = std::min(frames - 1, key + max_span);
+            uint32_t good = key + 1;
+            uint32_t bad = limit + 1;
+            for (uint32_t next = key + 2; next <= limit; next = std::min(key + 2 * (next - key), limit)) {
+                if (!fits(key, next)) {
+                    bad = next;
+                    break;
+                }
+                good = next;
+                if (next == limit) break;
+            }
+            while (bad - good > 1) {
+                uint32_t middle = good + (bad - good) / 2;
+                if (fits(key, middle)) { good = middle; }
+                else { bad = middle; }
+            }
+            kept.push_back(good);
+            key = good;
+        }
+    }
+
+}
+
+
+float CompressionReport::worst_error() const
+{
+    return max_error.empty() ? 0.0f : *std::max_element(max_error.begin(), max_error.end());
+}
+
+size_t CompressionReport::worst_joint() const
+{
+    return max_error.empty() ? 0 : static_cast<size_t>(std::max_element(max_error.begin(), max_error.end()) - max_error.begin());
+}
+
+
+size_t CompressedClip::bytes() const
+{
+    return (rotation_tracks_.size() + length_tracks_.size() + 1) * sizeof(Track) +
+        rotation_frames_.size() * sizeof(uint32_t) + rotation_keys_.size() * sizeof(PackedQuat) +
+        length_frames_.size() * sizeof(uint32_t) + length_keys_.size() * sizeof(uint16_t) +
+        root_pos_frames_.size() * sizeof(uint32_t) + root_pos_keys_.size() * sizeof(PackedVec3);
+}
+
+glm::quat CompressedClip::decode(const Track& track, const PackedQuat& packed) const
+{
+    uint64_t bits = packed.bits[0] | (uint64_t(packed.bits[1]) << 16) | (uint64_t(packed.bits[2]) << 32);
+    uint32_t largest = static_cast<uint32_t>(bits & 3);
+
+    glm::vec3 small;
+    for (int k = 0; k < 3; ++k) {
+        small[k] = track.min[k] + static_cast<float>((bits >> (2 + 15 * k)) & 0x7fff) * track.scale[k];
+    }
+
+    float c[4];
+    c[largest] = std::sqrt(std::max(0.0f, 1.0f - glm::dot(small, small)));
+    for (uint32_t i = 0, k = 0; i < 4; ++i) {
+        if (i != largest) { c[i] = small[k++]; }
+    }
+    return glm::normalize(glm::quat(c[3], c[0], c[1], c[2]));
+}
+
+void CompressedClip::sample(float time, AnimationCursor& cursor) const
+{
+    size_t joints = joint_count();
+    size_t tracks = rotation_tracks_.size();
+    if (frame_count_ == 0) return;
+
+    cursor.rotations.resize(joints);
+    cursor.lengths.resize(joints);
+    cursor.rotation_keys.resize(tracks);
+    cursor.length_keys.resize(joints);
+    cursor.a.resize(tracks);
+    cursor.b.resize(tracks);
+    cursor.out.resize(tracks);
+    cursor.t.resize(tracks);
+    cursor.decoded_keys.resize(tracks, UINT32_MAX);
+
+    float position = std::clamp(time / frame_time_, 0.0f, static_cast<float>(frame_count_ - 1));
+
+    // Every track has a key at the first frame, so every track has a segment; playback decodes a
+    // track's keys once per segment
+    for (size_t track = 0; track < tracks; ++track) {
+        const Track& range = rotation_tracks_[track];
+        float t = 0.0f;
+        uint32_t key = seek_key(rotation_frames_.data() + range.first, range.count, position, cursor.rotation_keys[track], t);
+        if (cursor.decoded_keys[track] != key) {
+            cursor.a[track] = decode(range, rotation_keys_[range.first + key]);
+            cursor.b[track] = decode(range, rotation_keys_[range.first + std::min(key + 1, range.count - 1)]);
+            cursor.decoded_keys[track] = key;
+        }
+        cursor.t[track] = t;
+    }
+    Math::slerp(cursor.a, cursor.b, cursor.t, cursor.out);
+    std::copy(cursor.out.begin(), cursor.out.begin() + joints, cursor.rotations.begin());
+    cursor.root_quat = cursor.out[joints];
+
+    for (size_t joint = 0; joint < joints; ++joint) {
+        const Track& range = length_tracks_[joint];
+        float t = 0.0f;
+        uint32_t key = seek_key(length_frames_.data() + range.first, range.count, position, cursor.length_keys[joint], t);
+        const uint16_t* keys = length_keys_.data() + range.first;
+        float a = keys[key];
+        float b = keys[std::min(key + 1, range.count - 1)];
+        cursor.lengths[joint] = range.min.x + (a + (b - a) * t) * range.scale.x;
+    }
+
+    const Track& range = root_pos_track_;
+    float t = 0.0f;
+    uint32_t key = seek_key(root_pos_frames_.data(), range.count, position, cursor.root_pos_key, t);
+    const PackedVec3& a = root_pos_keys_[key];
+    const PackedVec3& b = root_pos_keys_[std::min(key + 1, range.count - 1)];
+    for (int k = 0; k < 3; ++k) {
+        cursor.root_pos[k] = range.min[k] + (a.bits[k] + (float(b.bits[k]) - a.bits[k]) * t) * range.scale[k];
+    }
+}
+
+void CompressedClip::apply(const AnimationCursor& cursor, glm::vec3& root_pos, glm::quat& root_quat, std::span<Joint> joints) const
+{
+    size_t count = std::min(joints.size(), std::min(joint_count(), cursor.rotations.size()));
+    for (size_t i = 0; i < count; ++i) {
+        joints[i].local_rot = cursor.rotations[i];
+        joints[i].length = cursor.lengths[i];
+    }
+    root_pos = cursor.root_pos;
+    root_quat = cursor.root_quat;
+}
+
+
+void AnimationCompressor::add_frame(const glm::vec3& root_pos, const glm::quat& root_quat, std::span<const Joint> joints)
+{
+    if (frames_ == 0) { joints_ = joints.size(); }
+
+    // Joints past the first frame's count are left out; missing ones hold their previous value
+    size_t tracks = joints_ + 1;
+    size_t previous = rotations_.size();
+    rotations_.resize(previous + tracks, glm::quat(1, 0, 0, 0));
+    lengths_.resize(lengths_.size() + joints_, 0.0f);
+    for (size_t i = 0; i < joints_; ++i) {
+        if (i < joints.size()) {
+            rotations_[previous + i] = glm::normalize(joints[i].local_rot);
+            lengths_[frames_ * joints_ + i] = joints[i].length;
+        }
+        else if (frames_ > 0) {
+            rotations_[previous + i] = rotations_[previous - tracks + i];
+            lengths_[frames_ * joints_ + i] = lengths_[(frames_ - 1) * joints_ + i];
+        }
+    }
+    rotations_[previous + joints_] = glm::normalize(root_quat);
+    root_positions_.push_back(root_pos);
+    ++frames_;
+}
+
+CompressedClip AnimationCompressor::compress(float tolerance, CompressionReport& report) const
+{
+    CompressedClip clip;
+    report = CompressionReport{};
+    report.frames = frames_;
+    if (frames_ == 0) return clip;
+
+    // Reach of each rotation track: the most bone length it swings in any frame; the root's swings the whole chain
+    std::vector<float> reach(joints_ + 1, 0.0f);
+    for (size_t f = 0; f < frames_; ++f) {
+        float sum = 0.0f;
+        for (size_t i = joints_; i-- > 0;) {
+            if (i + 1 < joints_) { sum += lengths_[f * joints_ + i]; }
+            reach[i] = std::max(reach[i], sum);
+        }
+    }
+    reach[joints_] = joints_ > 0 ? reach[0] : 0.0f;
+
+    // Errors of the joints add up along the chain, so the bounds are halved until the FK check holds
+    float bound = tolerance;
+    for (int pass = 0; pass < max_passes; ++pass) {
+        build(clip, pass + 1 < max_passes ? bound : 0.0f, reach);
+        measure(clip, report);
+        if (report.worst_error() <= tolerance) break;
+        bound *= 0.5f;
+    }
+
+    report.raw_bytes = frames_ * (joints_ * (sizeof(glm::quat) + sizeof(float)) + sizeof(glm::quat) + sizeof(glm::vec3));
+    report.compressed_bytes = clip.bytes();
+    report.keys = clip.key_count();
+    return clip;
+}
+
+void AnimationCompressor::build(CompressedClip& clip, float tolerance, std::span<const float> reach) const
+{
+    using Track = CompressedClip::Track;
+    uint32_t frames = static_cast<uint32_t>(frames_);
+    size_t tracks = joints_ + 1;
+
+    clip = CompressedClip{};
+    clip.frame_time_ = frame_time_;
+    clip.frame_count_ = frames;
+
+    std::vector<uint32_t> kept;
+    std::vector<glm::quat> raw(frames), decoded(frames);
+    std::vector<CompressedClip::PackedQuat> packed(frames);
+    std::vector<glm::quat> a(max_span), b(max_span), out(max_span);
+    std::vector<float> t(max_span);
+
+    for (size_t track = 0; track < tracks; ++track) {
+        Track range{ static_cast<uint32_t>(clip.rotation_frames_.size()), 0, glm::vec3(0.0f), glm::vec3(0.0f) };
+
+        // Range of the smallest three over the track
+        glm::vec3 lo(1.0f), hi(-1.0f);
+        for (uint32_t f = 0; f < frames; ++f) {
+            raw[f] = rotations_[f * tracks + track];
+            glm::vec3 small;
+            smallest_three(raw[f], small);
+            lo = glm::min(lo, small);
+            hi = glm::max(hi, small);
+        }
+        range.min = lo;
+        range.scale = (hi - lo) / quat_steps;
+
+        for (uint32_t f = 0; f < frames; ++f) {
+            glm::vec3 small;
+            uint64_t bits = smallest_three(raw[f], small);
+            for (int k = 0; k < 3; ++k) {
+                bits |= uint64_t(quantize(small[k], range.min[k], range.scale[k], quat_steps)) << (2 + 15 * k);
+            }
+            packed[f] = { { static_cast<uint16_t>(bits), static_cast<uint16_t>(bits >> 16), static_cast<uint16_t>(bits >> 32) } };
+            decoded[f] = clip.decode(range, packed[f]);
+        }
+
+        // Frames between two keys are slerped as the decoder will, in one batch per candidate span. The
+        // angle is compared through the chord between the quaternions, which keeps its precision for the
+        // small angles that long chains need, where the dot product rounds to 1.
+        float angle = std::min(tolerance / std::max(reach[track], 1e-6f), glm::pi<float>());
+        float max_chord = 2.0f * std::sin(0.25f * angle);
+        reduce(frames, [&](uint32_t key, uint32_t next) {
+            uint32_t count = next - key - 1;
+            for (uint32_t i = 0; i < count; ++i) {
+                a[i] = decoded[key];
+                b[i] = decoded[next];
+                t[i] = static_cast<float>(i + 1) / (next - key);
+            }
+            Math::slerp({ a.data(), count }, { b.data(), count }, { t.data(), count }, { out.data(), count });
+            for (uint32_t i = 0; i < count; ++i) {
+                const glm::quat& q = raw[key + 1 + i];
+                glm::quat near = glm::dot(out[i], q) < 0.0f ? -q : q;
+                if (glm::length(out[i] - near) > max_chord) return false;
+            }
+            return true;
+        }, kept);
+
+        for (uint32_t f : kept) {
+            clip.rotation_frames_.push_back(f);
+            clip.rotation_keys_.push_back(packed[f]);
+        }
+        range.count = static_cast<uint32_t>(kept.size());
+        clip.rotation_tracks_.push_back(range);
+    }
+
+    std::vector<float> lengths(frames);
+    std::vector<uint16_t> quantized(frames);
+    for (size_t joint = 0; joint < joints_; ++joint) {
+        Track range{ static_cast<uint32_t>(clip.length_frames_.size()), 0, glm::vec3(0.0f), glm::vec3(0.0f) };
+        float lo = FLT_MAX, hi = -FLT_MAX;
+        for (uint32_t f = 0; f < frames; ++f) {
+            lengths[f] = lengths_[f * joints_ + joint];
+            lo = std::min(lo, lengths[f]);
+            hi = std::max(hi, lengths[f]);
+        }
+        range.min.x = lo;
+        range.scale.x = (hi - lo) / value_steps;
+        for (uint32_t f = 0; f < frames; ++f) {
+            quantized[f] = static_cast<uint16_t>(quantize(lengths[f], lo, range.scale.x, value_steps));
+        }
+
+        reduce(frames, [&](uint32_t key, uint32_t next) {
+            float a = range.min.x + quantized[key] * range.scale.x;
+            float b = range.min.x + quantized[next] * range.scale.x;
+            for (uint32_t f = key + 1; f < next; ++f) {
+                float value = a + (b - a) * (static_cast<float>(f - key) / (next - key));
+                if (std::abs(value - lengths[f]) > tolerance) return false;
+            }
+            return true;
+        }, kept);
+
+        for (uint32_t f : kept) {
+            clip.length_frames_.push_back(f);
+            clip.length_keys_.push_back(quantized[f]);
+        }
+        range.count = static_cast<uint32_t>(kept.size());
+        clip.length_tracks_.push_back(range);
+    }
+
+    // Root position, one range per axis
+    Track& range = clip.root_pos_track_;
+    glm::vec3 lo(FLT_MAX), hi(-FLT_MAX);
+    for (const glm::vec3& pos : root_positions_) {
+        lo = glm::min(lo, pos);
+        hi = glm::max(hi, pos);
+    }
+    range.min = lo;
+    range.scale = (hi - lo) / value_steps;
+
+    std::vector<CompressedClip::PackedVec3> positions(frames);
+    std::vector<glm::vec3> decoded_positions(frames);
+    for (uint32_t f = 0; f < frames; ++f) {
+        for (int k = 0; k < 3; ++k) {
+            positions[f].bits[k] = static_cast<uint16_t>(quantize(root_positions_[f][k], lo[k], range.scale[k], value_steps));
+            decoded_positions[f][k] = lo[k] + positions[f].bits[k] * range.scale[k];
+        }
+    }
+    reduce(frames, [&](uint32_t key, uint32_t next) {
+        for (uint32_t f = key + 1; f < next; ++f) {
+            glm::vec3 value = glm::mix(decoded_positions[key], decoded_positions[next], static_cast<float>(f - key) / (next - key));
+            if (glm::length(value - root_positions_[f]) > tolerance) return false;
+        }
+        return true;
+    }, kept);
+    for (uint32_t f : kept) {
+        clip.root_pos_frames_.push_back(f);
+        clip.root_pos_keys_.push_back(positions[f]);
+    }
+    range.count = static_cast<uint32_t>(kept.size());
+}
+
+void AnimationCompressor::measure(const CompressedClip& clip, CompressionReport& report) const
+{
+    size_t tracks = joints_ + 1;
+    report.max_error.assign(joints_, 0.0f);
+
+    std::vector<Joint> original(joints_), restored(joints_);
+    AnimationCursor cursor;
+    for (size_t f = 0; f < frames_; ++f) {
+        for (size_t i = 0; i < joints_; ++i) {
+            original[i].local_rot = rotations_[f * tracks + i];
+            original[i].length = lengths_[f * joints_ + i];
+        }
+        Kinematics::forward_kinematics(original, root_positions_[f], rotations_[f * tracks + joints_]);
+
+        glm::vec3 root_pos;
+        glm::quat root_quat;
+        clip.sample(static_cast<float>(f * static_cast<double>(frame_time_)), cursor);
+        clip.apply(cursor, root_pos, root_quat, restored);
+        Kinematics::forward_kinematics(restored, root_pos, root_quat);
+
+        for (size_t i = 0; i < joints_; ++i) {
+            report.max_error[i] = std::max(report.max_error[i], glm::length(restored[i].pos - original[i].pos));
+        }
+    }
+}
@@ -0,0 +1,120 @@
+#pragma once
+
+#include <span>
+#include <vector>
+#include <cstdint>
+
+#include <glm/glm.hpp>
+#include <glm/gtc/quaternion.hpp>
+
+#include "Main.hpp"
+#include "Animation.hpp"
+
+
+// Outcome of a compression: sizes, and the largest world-space distance of each joint from its
+// position in the input over all frames, both posed by FK
+struct CompressionReport
+{
+    size_t raw_bytes{ 0 };          // Floats per joint per frame
+    size_t compressed_bytes{ 0 };
+    size_t frames{ 0 };
+    size_t keys{ 0 };               // Kept over all tracks
+    std::vector<float> max_error;   // Per joint
+
+    float ratio() const { return compressed_bytes ? static_cast<float>(raw_bytes) / compressed_bytes : 0.0f; }
+    float worst_error() const;
+    size_t worst_joint() const;
+};
+
+
+// Uniformly sampled tracks with the keys that interpolation can stand in for removed, and the rest
+// quantized against their track's range: rotations in smallest-three form in 48 bits, lengths and
+// root positions in 16 bits per component. Key frames are in frame numbers; the keys of all
+// tracks of a kind share flat arrays, a contiguous run per track, as in AnimationClip.
+class CompressedClip
+{
+public:
+    size_t joint_count() const { return length_tracks_.size(); }
+    float duration() const { return frame_count_ > 1 ? (frame_count_ - 1) * frame_time_ : 0.0f; }
+    size_t key_count() const { return rotation_frames_.size() + length_frames_.size() + root_pos_frames_.size(); }
+    size_t bytes() const;
+
+    // Samples every track into the cursor's rotations, lengths and root transform; rotations are
+    // decoded per segment and interpolated in one batch
+    void sample(float time, AnimationCursor& cursor) const;
+
+    // Writes the sampled pose; joints beyond the clip are left as they are
+    void apply(const AnimationCursor& cursor, glm::vec3& root_pos, glm::quat& root_quat, std::span<Joint> joints) const;
+
+private:
+    friend class AnimationCompressor;
+
+    // Quantization range of a track, per component (lengths use x only)
+    struct Track
+    {
+        uint32_t first;
+        uint32_t count;
+        glm::vec3 min;
+        glm::vec3 scale;            // Range per quantization step
+    };
+
+    // Index of the largest component in the low 2 bits, then the other three in 15 bits each
+    struct PackedQuat
+    {
+        uint16_t bits[3];
+    };
+
+    struct PackedVec3
+    {
+        uint16_t bits[3];
+    };
+
+    glm::quat decode(const Track& track, const PackedQuat& packed) const;
+
+private:
+    float frame_time_{ 0.0f };
+    uint32_t frame_count_{ 0 };
+
+    std::vector<Track> rotation_tracks_;    // Per joint, the root last
+    std::vector<uint32_t> rotation_frames_;
+    std::vector<PackedQuat> rotation_keys_;
+
+    std::vector<Track> length_tracks_;
+    std::vector<uint32_t> length_frames_;
+    std::vector<uint16_t> length_keys_;
+
+    Track root_pos_track_{};
+    std::vector<uint32_t> root_pos_frames_;
+    std::vector<PackedVec3> root_pos_keys_;
+};
+
+
+// Collects poses at a fixed frame rate and compresses them. Keys are dropped while the joints'
+// world positions stay within the tolerance: each track starts from an error bound derived from
+// the reach of the bones it moves, and the result is checked through FK over every frame, with the
+// bounds tightened until it holds or every key is kept.
+class AnimationCompressor
+{
+public:
+    explicit AnimationCompressor(float frame_time) : frame_time_{ frame_time } {}
+
+    // Appends the next frame; every frame has the joint count of the first
+    void add_frame(const glm::vec3& root_pos, const glm::quat& root_quat, std::span<const Joint> joints);
+    size_t frame_count() const { return frames_; }
+
+    CompressedClip compress(float tolerance, CompressionReport& report) const;
+
+private:
+    void build(CompressedClip& clip, float tolerance, std::span<const float> reach) const;
+    void measure(const CompressedClip& clip, CompressionReport& report) const;
+
+private:
+    float frame_time_;
+    size_t joints_{ 0 };
+    size_t frames_{ 0 };
+
+    // Frame by frame: local rotations with the root rotation last, lengths, root positions
+    std::vector<glm::quat> rotations_;
+    std::vector<float> lengths_;
+    std::vector<glm::vec3> root_positions_;
+};
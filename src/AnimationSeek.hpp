@@ -0,0 +1,36 @@
+#pragma once
+
+#include <cstdint>
+#include <algorithm>
+
+
+// Key at or before the position among a track's key positions (times, or frame numbers), continuing
+// from the cursor's key when playing forward; t is the position towards the next key. Shared by the
+// raw and the compressed clip.
+template <typename Key>
+uint32_t seek_key(const Key* keys, uint32_t count, float position, uint32_t& key, float& t)
+{
+    constexpr uint32_t max_steps = 4;
+    auto before = [](float p, Key k) { return p < k; };
+
+    if (key >= count || keys[key] > position) {
+        key = static_cast<uint32_t>(std::upper_bound(keys, keys + count, position, before) - keys);
+        key = key > 0 ? key - 1 : 0;
+    }
+    else {
+        // Sequential playback moves a key at a time; a jump forward searches the rest
+        for (uint32_t steps = 0; key + 1 < count && keys[key + 1] <= position; ++steps) {
+            if (steps == max_steps) {
+                key = static_cast<uint32_t>(std::upper_bound(keys + key, keys + count, position, before) - keys) - 1;
+                break;
+            }
+            ++key;
+        }
+    }
+
+    t = 0.0f;
+    if (key + 1 < count && position > keys[key]) {
+        t = std::min((position - keys[key]) / static_cast<float>(keys[key + 1] - keys[key]), 1.0f);
+    }
+    return key;
+}
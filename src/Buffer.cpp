@@ -1,8 +1,40 @@
 #include "Buffer.hpp"
 
+#include <algorithm>
+
+
+Buffer::Buffer(const char* label) : label_{ label }
+{
+    registry_index_ = registry().size();
+    registry().push_back(this);
+}
 
 Buffer::~Buffer() {
     destroy();
+
+    // Swap-remove, so tearing down large scenes stays linear
+    std::vector<Buffer*>& buffers = registry();
+    buffers[registry_index_] = buffers.back();
+    buffers[registry_index_]->registry_index_ = registry_index_;
+    buffers.pop_back();
+}
+
+std::vector<Buffer*>& Buffer::registry()
+{
+    static std::vector<Buffer*> buffers;
+    return buffers;
+}
+
+const std::vector<Buffer*>& Buffer::instances()
+{
+    return registry();
+}
+
+void Buffer::track_bytes(size_t vbo_bytes, size_t ebo_bytes)
+{
+    vbo_bytes_ = vbo_bytes;
+    ebo_bytes_ = ebo_bytes;
+    peak_bytes_ = std::max(peak_bytes_, gpu_bytes());
 }
 
 void Buffer::create()
@@ -26,6 +58,7 @@ void Buffer::create(const void* data, size_t vertex_count, size_t vertex_stride,
     glBindVertexArray(vao_);
     glBindBuffer(GL_ARRAY_BUFFER, vbo_);
     glBufferData(GL_ARRAY_BUFFER, vertex_count * vertex_stride, data, usage);
+    track_bytes(vertex_count * vertex_stride, 0);
 
     // Attribute setup is expected to be done by the user after this call
     glBindVertexArray(0);
@@ -38,6 +71,7 @@ void Buffer::set_index_data(const void* index_data, size_t index_size, GLenum us
     glBindVertexArray(vao_);
     glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, ebo_);
     glBufferData(GL_ELEMENT_ARRAY_BUFFER, index_size, index_data, usage);
+    track_bytes(vbo_bytes_, index_size);
     glBindVertexArray(0);
     glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, 0);
 }
@@ -58,6 +92,7 @@ void Buffer::destroy() {
     if (vao_) { glDeleteVertexArrays(1, &vao_); }
     vbo_ = 0;
     vao_ = 0;
+    track_bytes(0, 0);
 }
 
 void Buffer::set_attribute(GLuint index, GLint size, GLenum type, GLboolean normalized, GLsizei stride, const void* pointer) {
@@ -68,6 +103,7 @@ void Buffer::set_attribute(GLuint index, GLint size, GLenum type, GLboolean norm
 void Buffer::update_data(const void* data, size_t size, GLenum usage) {
     glBindBuffer(GL_ARRAY_BUFFER, vbo_);
     glBufferData(GL_ARRAY_BUFFER, size, data, usage);
+    track_bytes(size, ebo_bytes_);
 }
 
 void Buffer::draw(GLenum mode, GLsizei count) const {
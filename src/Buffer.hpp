@@ -12,9 +12,13 @@
 class Buffer
 {
 public:
-    Buffer() = default;
+    // The label groups buffers in the memory report
+    explicit Buffer(const char* label = "Buffer");
     ~Buffer();
 
+    Buffer(const Buffer&) = delete;
+    Buffer& operator=(const Buffer&) = delete;
+
     // Create empty VAO/VBO
     void create();
 
@@ -37,6 +41,14 @@ public:
     void draw(GLenum mode, GLsizei count) const;
     static void set_vertex_attributes();
 
+    // GPU memory of the vertex and index data, and its peak (dynamic buffers are re-specified per batch)
+    const char* label() const { return label_; }
+    size_t gpu_bytes() const { return vbo_bytes_ + ebo_bytes_; }
+    size_t peak_gpu_bytes() const { return peak_bytes_; }
+
+    // All live buffers (render thread)
+    static const std::vector<Buffer*>& instances();
+
     GLuint vao() const { return vao_; }
     GLuint vbo() const { return vbo_; }
     GLuint ebo() const { return ebo_; }
@@ -45,4 +57,13 @@ private:
     GLuint vao_ = 0;
     GLuint vbo_ = 0;
     GLuint ebo_ = 0;
+
+    const char* label_;
+    size_t vbo_bytes_ = 0;
+    size_t ebo_bytes_ = 0;
+    size_t peak_bytes_ = 0;
+    size_t registry_index_ = 0;
+
+    void track_bytes(size_t vbo_bytes, size_t ebo_bytes);
+    static std::vector<Buffer*>& registry();
 };
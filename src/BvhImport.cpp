@@ -0,0 +1,399 @@
+#include "BvhImport.hpp"
+
+#include <cstdio>
+#include <cctype>
+#include <charconv>
+#include <cstring>
+#include <algorithm>
+#include <string_view>
+
+#include "Kinematics.hpp"
+#include "Trace.hpp"
+#include "MemoryTracker.hpp"
+
+
+namespace
+{
+    constexpr size_t block_size = 1 << 20;
+    constexpr size_t batch_frames = 64;
+    constexpr int max_depth = 1024;
+    constexpr float mean_bone_length = 100.0f;
+
+    float channel(const float* values, int index)
+    {
+        return index >= 0 ? values[index] : 0.0f;
+    }
+}
+
+
+// Blank-separated tokens of a file, read in fixed-size blocks
+class BvhStream::Tokens
+{
+public:
+    explicit Tokens(FILE* file) : file_{ file }, buffer_(block_size) {}
+    ~Tokens() { std::fclose(file_); }
+
+    // Next token; empty at the end of the file
+    std::string_view next()
+    {
+        for (;;) {
+            while (pos_ < end_ && std::isspace(static_cast<unsigned char>(buffer_[pos_]))) {
+                if (buffer_[pos_] == '\n') { ++line_; }
+                ++pos_;
+            }
+            if (pos_ < end_) { break; }
+            if (!fill(pos_)) { return {}; }
+        }
+
+        // A token running into the end of the block continues in the next one
+        size_t start = pos_;
+        for (;;) {
+            while (pos_ < end_ && !std::isspace(static_cast<unsigned char>(buffer_[pos_]))) { ++pos_; }
+            if (pos_ < end_ || eof_) { break; }
+            size_t length = pos_ - start;
+            if (!fill(start)) { break; }
+            start = 0;
+            pos_ = length;
+        }
+        return { buffer_.data() + start, pos_ - start };
+    }
+
+    bool expect(const char* token) { return next() == token; }
+
+    template <typename T>
+    bool number(T& value) { return parse(next(), value); }
+
+    template <typename T>
+    static bool parse(std::string_view token, T& value)
+    {
+        if (!token.empty() && token.front() == '+') { token.remove_prefix(1); }
+        auto [ptr, ec] = std::from_chars(token.data(), token.data() + token.size(), value);
+        return ec == std::errc() && ptr == token.data() + token.size() && !token.empty();
+    }
+
+    size_t line() const { return line_; }
+
+private:
+    // Keeps the bytes from keep on, moved to the front, and reads more after them
+    bool fill(size_t keep)
+    {
+        if (eof_) { return false; }
+
+        size_t kept = end_ - keep;
+        std::memmove(buffer_.data(), buffer_.data() + keep, kept);
+        if (kept == buffer_.size()) { buffer_.resize(buffer_.size() * 2); }
+
+        size_t read = std::fread(buffer_.data() + kept, 1, buffer_.size() - kept, file_);
+        eof_ = read < buffer_.size() - kept;
+        pos_ = 0;
+        end_ = kept + read;
+        return read > 0;
+    }
+
+private:
+    FILE* file_;
+    std::vector<char> buffer_;
+    size_t pos_{ 0 };
+    size_t end_{ 0 };
+    size_t line_{ 1 };
+    bool eof_{ false };
+};
+
+
+BvhStream::BvhStream() = default;
+
+BvhStream::~BvhStream()
+{
+    close();
+}
+
+bool BvhStream::open(const std::string& path, size_t ring_frames)
+{
+    close();
+    path_ = path;
+
+    FILE* file = std::fopen(path.c_str(), "rb");
+    if (!file) {
+        std::fprintf(stderr, "Cannot open %s\n", path.c_str());
+        return false;
+    }
+    tokens_ = std::make_unique<Tokens>(file);
+
+    if (!tokens_->expect("HIERARCHY")) { return fail("expected HIERARCHY"); }
+    std::string_view token = tokens_->next();
+    if (token != "ROOT") { return fail("expected ROOT"); }
+    while (token == "ROOT") {
+        if (!parse_joint(-1, 0)) { return false; }
+        token = tokens_->next();
+    }
+
+    if (token != "MOTION") { return fail("expected MOTION"); }
+    if (!tokens_->expect("Frames:") || !tokens_->number(frame_count_)) { return fail("expected Frames: <count>"); }
+    if (!tokens_->expect("Frame") || !tokens_->expect("Time:") || !tokens_->number(frame_time_) || !(frame_time_ > 0.0)) {
+        return fail("expected Frame Time: <seconds>");
+    }
+    if (channel_count_ == 0) { return fail("no channels"); }
+    if (!build_chain()) { return false; }
+
+    ring_.assign(std::max<size_t>(ring_frames, 1), rest_);
+    values_.resize(batch_frames * channel_count_);
+    degrees_.assign(chain_nodes_.size(), std::vector<glm::vec3>(batch_frames));
+    rotations_.assign(chain_nodes_.size(), std::vector<glm::quat>(batch_frames));
+
+    thread_ = std::thread(&BvhStream::read_frames, this);
+    return true;
+}
+
+void BvhStream::close()
+{
+    if (thread_.joinable()) {
+        stop_ = true;
+        { std::lock_guard<std::mutex> lock(mutex_); }
+        space_.notify_one();
+        thread_.join();
+    }
+
+    tokens_.reset();
+    nodes_.clear();
+    chain_nodes_.clear();
+    ring_.clear();
+    channel_count_ = 0;
+    frame_count_ = 0;
+    head_ = 0;
+    tail_ = 0;
+    done_ = false;
+    stop_ = false;
+}
+
+const BvhFrame* BvhStream::front() const
+{
+    uint64_t head = head_.load(std::memory_order_relaxed);
+    return head == tail_.load(std::memory_order_acquire) ? nullptr : &ring_[head % ring_.size()];
+}
+
+void BvhStream::pop()
+{
+    head_.store(head_.load(std::memory_order_relaxed) + 1, std::memory_order_release);
+    { std::lock_guard<std::mutex> lock(mutex_); }
+    space_.notify_one();
+}
+
+bool BvhStream::finished() const
+{
+    return done_.load(std::memory_order_acquire) && head_.load(std::memory_order_relaxed) == tail_.load(std::memory_order_acquire);
+}
+
+bool BvhStream::parse_joint(int parent, int depth)
+{
+    if (depth > max_depth) { return fail("hierarchy too deep"); }
+
+    Node node{ parent, glm::vec3(0.0f), channel_count_, { -1, -1, -1 }, { -1, -1, -1 }, EulerOrder::XYZ };
+    int index = static_cast<int>(nodes_.size());
+
+    // Names may contain blanks; they run up to the opening brace
+    std::string_view token = tokens_->next();
+    while (!token.empty() && token != "{") { token = tokens_->next(); }
+    if (token != "{") { return fail("expected {"); }
+    nodes_.push_back(node);
+
+    for (;;) {
+        token = tokens_->next();
+        if (token == "OFFSET") {
+            glm::vec3 offset;
+            if (!tokens_->number(offset.x) || !tokens_->number(offset.y) || !tokens_->number(offset.z)) { return fail("expected OFFSET x y z"); }
+            nodes_[index].offset = offset;
+        }
+        else if (token == "CHANNELS") {
+            if (!parse_channels(nodes_[index])) { return false; }
+        }
+        else if (token == "JOINT") {
+            if (!parse_joint(index, depth + 1)) { return false; }
+        }
+        else if (token == "End") {
+            if (!tokens_->expect("Site") || !parse_joint(index, depth + 1)) { return false; }
+        }
+        else if (token == "}") {
+            return true;
+        }
+        else {
+            return fail(token.empty() ? "unexpected end of the hierarchy" : "unexpected token in the hierarchy");
+        }
+    }
+}
+
+bool BvhStream::parse_channels(Node& node)
+{
+    uint32_t count = 0;
+    if (!tokens_->number(count) || count > 64) { return fail("expected CHANNELS <count>"); }
+
+    node.channel = channel_count_;
+    int axes[3] = { -1, -1, -1 };
+    int rotations = 0;
+    for (uint32_t i = 0; i < count; ++i) {
+        std::string_view name = tokens_->next();
+        int channel = static_cast<int>(channel_count_ + i);
+        if (name.size() != 9 || name[0] < 'X' || name[0] > 'Z') { return fail("unknown channel"); }
+
+        int axis = name[0] - 'X';
+        if (name.substr(1) == "position") {
+            node.position[axis] = channel;
+        }
+        else if (name.substr(1) == "rotation") {
+            if (std::find(axes, axes + rotations, axis) != axes + rotations) { return fail("repeated rotation channel"); }
+            axes[rotations] = axis;
+            node.rotation[rotations++] = channel;
+        }
+        else {
+            return fail("unknown channel");
+        }
+    }
+    channel_count_ += count;
+
+    // Axes without a channel keep a zero angle, after the listed ones
+    for (int axis = 0; axis < 3 && rotations < 3; ++axis) {
+        if (std::find(axes, axes + rotations, axis) == axes + rotations) { axes[rotations++] = axis; }
+    }
+
+    static const EulerOrder orders[3][3] = {
+        { EulerOrder::XYZ, EulerOrder::XYZ, EulerOrder::XZY },
+        { EulerOrder::YXZ, EulerOrder::YXZ, EulerOrder::YZX },
+        { EulerOrder::ZXY, EulerOrder::ZYX, EulerOrder::ZYX },
+    };
+    node.order = orders[axes[0]][axes[1]];
+    return true;
+}
+
+bool BvhStream::build_chain()
+{
+    // Follow the deepest child from the first root; nodes are in depth-first order
+    std::vector<int> height(nodes_.size(), 1);
+    for (size_t i = nodes_.size(); i-- > 1;) {
+        if (nodes_[i].parent >= 0) { height[nodes_[i].parent] = std::max(height[nodes_[i].parent], height[i] + 1); }
+    }
+
+    chain_nodes_.clear();
+    for (int node = 0; node >= 0;) {
+        chain_nodes_.push_back(node);
+        int next = -1;
+        for (size_t i = node + 1; i < nodes_.size() && next < 0; ++i) {
+            if (nodes_[i].parent == node && height[i] == height[node] - 1) { next = static_cast<int>(i); }
+        }
+        node = next;
+    }
+    if (chain_nodes_.size() < 2) { return fail("hierarchy without a bone"); }
+
+    // Scale to the usual bone length of the viewer
+    size_t count = chain_nodes_.size();
+    float total = 0.0f;
+    size_t bones = 0;
+    for (size_t i = 1; i < count; ++i) {
+        float length = glm::length(nodes_[chain_nodes_[i]].offset);
+        if (length > 0.0f) { total += length; ++bones; }
+    }
+    scale_ = bones > 0 ? mean_bone_length * bones / total : 1.0f;
+
+    rest_rot_.assign(count, glm::quat(1, 0, 0, 0));
+    rest_inverse_.assign(count, glm::quat(1, 0, 0, 0));
+    rest_.joints.assign(count, { glm::vec3(0.0f), glm::quat(1, 0, 0, 0), glm::quat(1, 0, 0, 0), 0.0f });
+    for (size_t i = 0; i < count; ++i) {
+        glm::vec3 offset = i + 1 < count ? nodes_[chain_nodes_[i + 1]].offset : glm::vec3(0.0f);
+        float length = glm::length(offset);
+
+        // Bones of zero length keep the parent's rest rotation
+        if (length > 0.0f) { rest_rot_[i] = Math::compute_frame_quat_from_dir(offset / length); }
+        else if (i > 0) { rest_rot_[i] = rest_rot_[i - 1]; }
+        rest_inverse_[i] = glm::inverse(rest_rot_[i]);
+
+        rest_.joints[i].length = length * scale_;
+        if (i > 0) { rest_.joints[i].local_rot = rest_inverse_[i - 1] * rest_rot_[i]; }
+    }
+
+    rest_.root_pos = nodes_[chain_nodes_[0]].offset * scale_;
+    rest_.root_quat = rest_rot_[0];
+    Kinematics::forward_kinematics(rest_.joints, rest_.root_pos, rest_.root_quat);
+    return true;
+}
+
+bool BvhStream::fail(const char* reason)
+{
+    std::fprintf(stderr, "%s:%zu: %s\n", path_.c_str(), tokens_ ? tokens_->line() : 0, reason);
+    return false;
+}
+
+void BvhStream::read_frames()
+{
+    Trace::set_thread_name("BVH reader");
+    MemoryTracker::Scope memory(MemoryTag::IO);
+
+    uint64_t read = 0;
+    bool more = true;
+    while (more && !stop_) {
+        Trace::Scope trace("BVH frames");
+
+        // A batch of frames, up to the declared count or the end of the file
+        size_t frames = 0;
+        while (frames < batch_frames && read + frames < frame_count_) {
+            float* values = &values_[frames * channel_count_];
+            std::string_view first = tokens_->next();
+            if (first.empty()) {
+                std::fprintf(stderr, "%s: ends after %llu of %llu frames\n", path_.c_str(),
+                    static_cast<unsigned long long>(read + frames), static_cast<unsigned long long>(frame_count_));
+                more = false;
+                break;
+            }
+
+            bool ok = Tokens::parse(first, values[0]);
+            for (uint32_t c = 1; c < channel_count_ && ok; ++c) { ok = tokens_->number(values[c]); }
+            if (!ok) {
+                fail("expected a channel value");
+                more = false;
+                frames = 0;
+                break;
+            }
+            ++frames;
+        }
+        if (read + frames >= frame_count_) { more = false; }
+
+        // Euler angles of each chain joint, converted for the whole batch at once
+        for (size_t i = 0; i < chain_nodes_.size(); ++i) {
+            const Node& node = nodes_[chain_nodes_[i]];
+            for (size_t f = 0; f < frames; ++f) {
+                const float* values = &values_[f * channel_count_];
+                degrees_[i][f] = glm::vec3(channel(values, node.rotation[0]), channel(values, node.rotation[1]), channel(values, node.rotation[2]));
+            }
+            Math::euler_to_quat(node.order, std::span(degrees_[i]).first(frames), std::span(rotations_[i]).first(frames));
+        }
+
+        for (size_t f = 0; f < frames; ++f) {
+            if (!emit(f)) { more = false; break; }
+        }
+        read += frames;
+    }
+
+    done_.store(true, std::memory_order_release);
+}
+
+bool BvhStream::emit(size_t frame)
+{
+    // Waits for the render thread to free a slot
+    uint64_t tail = tail_.load(std::memory_order_relaxed);
+    {
+        std::unique_lock<std::mutex> lock(mutex_);
+        space_.wait(lock, [&] { return tail - head_.load(std::memory_order_acquire) < ring_.size() || stop_; });
+    }
+    if (stop_) { return false; }
+
+    const float* values = &values_[frame * channel_count_];
+    const Node& root = nodes_[chain_nodes_[0]];
+    BvhFrame& out = ring_[tail % ring_.size()];
+
+    glm::vec3 position(channel(values, root.position[0]), channel(values, root.position[1]), channel(values, root.position[2]));
+    out.root_pos = (root.offset + position) * scale_;
+    out.root_quat = rotations_[0][frame] * rest_rot_[0];
+    for (size_t i = 1; i < chain_nodes_.size(); ++i) {
+        out.joints[i].local_rot = rest_inverse_[i - 1] * rotations_[i][frame] * rest_rot_[i];
+    }
+
+    tail_.store(tail + 1, std::memory_order_release);
+    return true;
+}
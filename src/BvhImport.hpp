@@ -0,0 +1,110 @@
+#pragma once
+
+#include <mutex>
+#include <atomic>
+#include <memory>
+#include <string>
+#include <thread>
+#include <vector>
+#include <cstdint>
+#include <condition_variable>
+
+#include <glm/glm.hpp>
+#include <glm/gtc/quaternion.hpp>
+
+#include "Main.hpp"
+#include "Math.hpp"
+
+
+// Pose of the imported chain in one frame of a capture
+struct BvhFrame
+{
+    glm::vec3 root_pos{ 0.0f };
+    glm::quat root_quat{ 1, 0, 0, 0 };
+    std::vector<Joint> joints;          // Local rotations and bone lengths
+};
+
+
+// BVH motion capture import. The HIERARCHY section is parsed on open and its longest branch
+// from the root becomes the chain; other branches are skipped, as a chain cannot fork.
+// MOTION frames are then read incrementally on a background thread into a bounded ring, so
+// captures of any size play back in constant memory.
+//
+// Each chain joint gets a fixed rest rotation that points its +Z axis at the next joint, so
+// a frame's local rotation is rest(parent)^-1 * channels * rest(joint). Offsets are scaled to
+// a mean bone length of 100.
+class BvhStream
+{
+public:
+    BvhStream();
+    ~BvhStream();
+
+    // Parses the hierarchy and starts reading frames; false with an error on stderr if the file is invalid
+    bool open(const std::string& path, size_t ring_frames = 256);
+    void close();
+
+    // The chain with all channels at zero, positions included
+    const BvhFrame& rest_pose() const { return rest_; }
+
+    double frame_time() const { return frame_time_; }
+    uint64_t frame_count() const { return frame_count_; }      // As declared by the file
+
+    // Render thread: the oldest buffered frame, or null while the reader has none ready
+    const BvhFrame* front() const;
+    void pop();
+
+    // True once every frame was handed out, or reading stopped at an error
+    bool finished() const;
+
+private:
+    class Tokens;
+
+    struct Node
+    {
+        int parent;
+        glm::vec3 offset;
+        uint32_t channel;               // First channel of the node in a frame
+        int position[3];                // Channels of the X, Y and Z position; -1 if absent
+        int rotation[3];                // Channels of the rotation in order; -1 for axes without one
+        EulerOrder order;
+    };
+
+    bool parse_joint(int parent, int depth);
+    bool parse_channels(Node& node);
+    bool build_chain();
+    bool fail(const char* reason);
+
+    // Reader thread: parses batches of frames and hands them to the ring one by one
+    void read_frames();
+    bool emit(size_t frame);
+
+private:
+    std::string path_;
+    std::unique_ptr<Tokens> tokens_;
+    std::vector<Node> nodes_;
+    uint32_t channel_count_{ 0 };
+    uint64_t frame_count_{ 0 };
+    double frame_time_{ 0.0 };
+
+    // Chain joints as nodes, with their rest rotations; the last one may be an end site
+    std::vector<int> chain_nodes_;
+    std::vector<glm::quat> rest_rot_;
+    std::vector<glm::quat> rest_inverse_;
+    float scale_{ 1.0f };
+    BvhFrame rest_;
+
+    // Reader scratch: channel values of a batch of frames, and per joint its angles and rotations
+    std::vector<float> values_;
+    std::vector<std::vector<glm::vec3>> degrees_;
+    std::vector<std::vector<glm::quat>> rotations_;
+
+    // Single-producer, single-consumer ring of frames
+    std::vector<BvhFrame> ring_;
+    std::atomic<uint64_t> head_{ 0 };   // Next frame to hand out
+    std::atomic<uint64_t> tail_{ 0 };   // Next frame to fill
+    std::atomic<bool> done_{ false };
+    std::atomic<bool> stop_{ false };
+    std::mutex mutex_;
+    std::condition_variable space_;
+    std::thread thread_;
+};
@@ -48,14 +48,14 @@ void Camera::update(const Input& input, int active_joint)
             angle = target_angle = ta;
             pitch = target_pitch = tp;
             animating = false;
-            distance = 600.0f;
+            distance = home_distance;
             pan_offset_2d = glm::vec2(0.0f);
         }
         else {
             angle = target_angle = glm::quarter_pi<float>();
             pitch = target_pitch = glm::asin(1.0f / std::sqrt(3.0f));
             animating = false;
-            distance = 600.0f;
+            distance = home_distance;
             pan_offset = glm::vec3(0.0f);
         }
         last_plane = view_plane;
@@ -89,7 +89,7 @@ void Camera::update(const Input& input, int active_joint)
         if (input.mouse_down(1) && view_plane == ViewPlane::XYZ) {
             glm::vec2 delta = input.mouse_delta();
             distance += delta.y * 2.0f;
-            distance = glm::clamp(distance, 100.0f, 2000.0f);
+            distance = glm::clamp(distance, 100.0f, std::max(2000.0f, home_distance * 2.0f));
         }
         // Pan with middle mouse button (all views)
         if (input.mouse_down(2)) {
@@ -114,20 +114,77 @@ void Camera::update(const Input& input, int active_joint)
         // Zoom with mouse wheel (disable in 2D views and when a joint is selected)
         if (input.mouse_wheel() != 0.0f && view_plane == ViewPlane::XYZ && active_joint < 0) {
             distance -= input.mouse_wheel() * 40.0f;
-            distance = glm::clamp(distance, 100.0f, 2000.0f);
+            distance = glm::clamp(distance, 100.0f, std::max(2000.0f, home_distance * 2.0f));
         }
     }
 }
 
-glm::mat4 Camera::get_view() const
+void Camera::set_viewport(int width, int height)
+{
+    viewport_width_ = std::max(width, 1);
+    viewport_height_ = std::max(height, 1);
+}
+
+const glm::mat4& Camera::get_view() const
+{
+    refresh();
+    return view_;
+}
+
+const glm::mat4& Camera::get_proj() const
+{
+    refresh();
+    return proj_;
+}
+
+const glm::mat4& Camera::get_view_proj() const
+{
+    refresh();
+    return view_proj_;
+}
+
+const glm::mat4& Camera::get_inverse_view_proj() const
+{
+    refresh();
+    return inverse_view_proj_;
+}
+
+uint64_t Camera::version() const
+{
+    refresh();
+    return version_;
+}
+
+Camera::State Camera::state() const
+{
+    return { target, pan_offset, pan_offset_2d, distance, angle, pitch, view_plane, perspective_, viewport_width_, viewport_height_ };
+}
+
+void Camera::refresh() const
+{
+    // The public fields are edited directly (overlay, input), so changes are detected by comparison
+    State current = state();
+    if (cached_ && current == cached_state_) { return; }
+
+    view_ = compute_view();
+    proj_ = compute_proj();
+    view_proj_ = proj_ * view_;
+    inverse_view_proj_ = glm::inverse(view_proj_);
+
+    cached_state_ = current;
+    cached_ = true;
+    ++version_;
+}
+
+glm::mat4 Camera::compute_view() const
 {
     glm::vec3 up(0, 1, 0);
     glm::vec3 camPos, center;
     glm::vec3 pan3d(0.0f);
 
     const float margin_px = 16.0f;
-    float win_w = static_cast<float>(WINDOW_WIDTH);
-    float win_h = static_cast<float>(WINDOW_HEIGHT);
+    float win_w = static_cast<float>(viewport_width_);
+    float win_h = static_cast<float>(viewport_height_);
     float aspect = win_w / win_h;
     float ortho_half_height = distance * 0.5f;
     float ortho_half_width = ortho_half_height * aspect;
@@ -185,9 +242,11 @@ glm::mat4 Camera::get_view() const
     return glm::lookAt(camPos, center, up);
 }
 
-glm::mat4 Camera::get_proj(float aspect) const
+glm::mat4 Camera::compute_proj() const
 {
+    float aspect = static_cast<float>(viewport_width_) / viewport_height_;
     float orthoHalfSize = distance * 0.5f;
+    float depth = std::max(4000.0f, distance * 4.0f);
     switch (view_plane) {
         case ViewPlane::XY:
         case ViewPlane::YZ:
@@ -195,21 +254,34 @@ glm::mat4 Camera::get_proj(float aspect) const
             return glm::ortho(
                 -orthoHalfSize * aspect, orthoHalfSize * aspect,
                 -orthoHalfSize, orthoHalfSize,
-                -4000.0f, 4000.0f
+                -depth, depth
             );
         case ViewPlane::XYZ:
         default:
             if (perspective_) {
-                return glm::perspective(glm::radians(45.0f), aspect, 0.1f, 4000.0f);
+                return glm::perspective(glm::radians(45.0f), aspect, 0.1f, depth);
             }
             return glm::ortho(
                 -orthoHalfSize * aspect, orthoHalfSize * aspect,
                 -orthoHalfSize, orthoHalfSize,
-                -4000.0f, 4000.0f
+                -depth, depth
             );
     }
 }
 
+void Camera::fit(const glm::vec3& lo, const glm::vec3& hi)
+{
+    // The chain origin sits in the lower corner of the view, so the box is framed from lo
+    glm::vec3 extent = hi - lo;
+    float size = std::max({ extent.x, extent.y, extent.z });
+
+    target = lo;
+    home_distance = std::max(600.0f, size * 1.25f);
+    distance = home_distance;
+    pan_offset = glm::vec3(0.0f);
+    pan_offset_2d = glm::vec2(0.0f);
+}
+
 glm::vec3 Camera::get_eye() const {
     return target + pan_offset +
         glm::vec3(
@@ -3,6 +3,8 @@
 #include <imgui.h>
 #include <glm/glm.hpp>
 
+#include <cstdint>
+
 #include "Main.hpp"
 #include "Input.hpp"
 
@@ -14,16 +16,31 @@ public:
 
     void update(const Input& input, int active_joint);
 
-    glm::mat4 get_view() const;
-    glm::mat4 get_proj(float aspect) const;
+    // Viewport in pixels; sets the aspect ratio and the 2D view margins
+    void set_viewport(int width, int height);
+    int viewport_width() const { return viewport_width_; }
+    int viewport_height() const { return viewport_height_; }
+
+    // Cached; recomputed only when the camera state or the viewport changed since the last call
+    const glm::mat4& get_view() const;
+    const glm::mat4& get_proj() const;
+    const glm::mat4& get_view_proj() const;
+    const glm::mat4& get_inverse_view_proj() const;
     glm::vec3 get_eye() const;
 
+    // Incremented whenever the matrices change, so downstream caches can key off it
+    uint64_t version() const;
+
+    // Frames the box between lo and hi; view resets return to this distance
+    void fit(const glm::vec3& lo, const glm::vec3& hi);
+
 public:
     bool perspective_{ false };
 
     glm::vec3 target = glm::vec3(0);
     glm::vec3 pan_offset = glm::vec3(0);
     float distance = 400.0f;
+    float home_distance = 600.0f;
     float angle = 0.0f;
     float pitch = 0.0f;
 
@@ -36,4 +53,35 @@ public:
     bool animating = false;
     float animation_speed = 12.0f; // Higher = faster
     ViewPlane last_plane = ViewPlane::XYZ;
+
+private:
+    // Everything the matrices depend on
+    struct State
+    {
+        glm::vec3 target, pan_offset;
+        glm::vec2 pan_offset_2d;
+        float distance, angle, pitch;
+        ViewPlane view_plane;
+        bool perspective;
+        int viewport_width, viewport_height;
+
+        bool operator==(const State&) const = default;
+    };
+
+    State state() const;
+    void refresh() const;
+    glm::mat4 compute_view() const;
+    glm::mat4 compute_proj() const;
+
+private:
+    int viewport_width_ = static_cast<int>(WINDOW_WIDTH);
+    int viewport_height_ = static_cast<int>(WINDOW_HEIGHT);
+
+    mutable State cached_state_{};
+    mutable bool cached_{ false };
+    mutable uint64_t version_{ 0 };
+    mutable glm::mat4 view_{ 1.0f };
+    mutable glm::mat4 proj_{ 1.0f };
+    mutable glm::mat4 view_proj_{ 1.0f };
+    mutable glm::mat4 inverse_view_proj_{ 1.0f };
 };
\ No newline at end of file
@@ -2,6 +2,7 @@
 
 #include <cmath>
 #include <iostream>
+#include <random>
 #include <algorithm>
 
 #include <glm/glm.hpp>
@@ -11,64 +12,77 @@
 
 #include "Main.hpp"
 #include "Kinematics.hpp"
+#include "Trace.hpp"
+#include "ChainGeometry.hpp"
+#include "FrameArena.hpp"
 
 
-Chain::Chain(std::shared_ptr<Camera>& camera) : 
-    camera_{ camera }, shader_{}, buffer_{}, 
+Chain::Chain(std::shared_ptr<Camera>& camera, std::shared_ptr<Shader> shader, const ChainSpec& spec) : 
+    camera_{ camera }, shader_{ std::move(shader) }, buffer_{ "Chain" }, 
     selected_joint_{ -1 }, joints_{}, tendons_{},
-    root_pos_{ 0.0f }, root_quat_{ 1, 0, 0, 0 }, 
+    root_pos_{ spec.root_pos }, root_quat_{ spec.root_quat }, pose_version_{ 0 }, 
     dragging_{ false }, just_selected_{ false }, drag_start_world_{}, select_start_mouse_{}
 {
-    float bone_length = 100.0f;
-    size_t num_joints = 5;
-
-    joints_.clear();
-    glm::vec3 pos = glm::vec3(0, 0, 0);
-    glm::quat rot = glm::quat(1, 0, 0, 0);
-
-    for (size_t i = 0; i < num_joints; ++i) {
-        float t = static_cast<float>(i) / (num_joints - 1);
-        joints_.push_back({ pos, glm::quat(1, 0, 0, 0), glm::quat(1, 0, 0, 0), bone_length });
-        pos += rot * glm::vec3(0, 0, bone_length); // advance along root's +Z
-    }
+    size_t num_joints = std::max<size_t>(spec.joints, 2);
+    joints_.resize(num_joints, { glm::vec3(0.0f), glm::quat(1, 0, 0, 0), glm::quat(1, 0, 0, 0), spec.bone_length });
     
     // Set the last joint's length to 0 (no child)
-    if (!joints_.empty()) { joints_.back().length = 0.0f; }
-
-    // Root orientation: rotate 45 degrees around Y, then -45 degrees around X
-    root_quat_ = Math::axis_angle_quat(glm::vec3(0, 1, 0), 45.0f) * Math::axis_angle_quat(glm::vec3(1, 0, 0), -45.0f);
-    joints_[0].local_rot = glm::quat(1, 0, 0, 0);
-
-    for (size_t i = 1; i < joints_.size(); ++i) {
-        joints_[i].local_rot = glm::quat(1, 0, 0, 0);
+    joints_.back().length = 0.0f;
+
+    // Seeded bends away from a straight line
+    if (spec.seed != 0 && spec.bend_degrees > 0.0f) {
+        std::mt19937 rng(spec.seed);
+        std::uniform_real_distribution<float> angle(-spec.bend_degrees, spec.bend_degrees);
+        for (size_t i = 1; i < joints_.size(); ++i) {
+            float x = angle(rng), y = angle(rng);
+            joints_[i].local_rot = Math::axis_angle_quat(glm::vec3(1, 0, 0), x) * Math::axis_angle_quat(glm::vec3(0, 1, 0), y);
+        }
     }
 
-    Kinematics::forward_kinematics(joints_, root_pos_, root_quat_);
+    forward_kinematics();
     Kinematics::rotate_joints(joints_, root_quat_);
+    tendons_ = SceneGenerator::tendons(joints_, spec.tendons_per_bone);
 
-    shader_.load("res/color.vert", "res/color.frag");
     buffer_.create();
     buffer_.bind();
     buffer_.set_vertex_attributes();
     buffer_.unbind();
 }
 
-void Chain::drag_joint(const Input& input, ViewPlane view_plane, const glm::mat4& proj, const glm::mat4& view)
+Chain::Chain(std::shared_ptr<Camera>& camera, std::shared_ptr<Shader> shader, const glm::vec3& root_pos, const glm::quat& root_quat,
+    std::vector<Joint> joints, std::vector<Tendon> tendons) :
+    camera_{ camera }, shader_{ std::move(shader) }, buffer_{ "Chain" },
+    selected_joint_{ -1 }, joints_{ std::move(joints) }, tendons_{ std::move(tendons) },
+    root_pos_{ root_pos }, root_quat_{ root_quat }, pose_version_{ 0 },
+    dragging_{ false }, just_selected_{ false }, drag_start_world_{}, select_start_mouse_{}
 {
-    glm::vec2 mouse = input.mouse_pos();
-    int hovered_joint = -1;
-
-    for (size_t i = 0; i < joints_.size(); ++i) {
-        glm::vec4 p = proj * view * glm::vec4(joints_[i].pos, 1.0f);
-        if (p.w != 0.0f) { p /= p.w; }
+    buffer_.create();
+    buffer_.bind();
+    buffer_.set_vertex_attributes();
+    buffer_.unbind();
+}
 
-        float sx = (p.x * 0.5f + 0.5f) * input.display_size().x;
-        float sy = (1.0f - (p.y * 0.5f + 0.5f)) * input.display_size().y;
+void Chain::set_pose(const glm::vec3& root_pos, const glm::quat& root_quat, std::span<const Joint> joints)
+{
+    if (joints.size() != joints_.size()) {
+        joints_.resize(joints.size());
+        std::erase_if(tendons_, [&](const Tendon& tendon) { return tendon.bone_idx + 1 >= joints_.size(); });
+        if (selected_joint_ >= static_cast<int>(joints_.size())) { selected_joint_ = -1; }
+        dragging_ = false;
+    }
 
-        if (glm::distance(mouse, glm::vec2(sx, sy)) < 15.0f) {
-            hovered_joint = (int)i;
-        }
+    for (size_t i = 0; i < joints.size(); ++i) {
+        joints_[i].local_rot = joints[i].local_rot;
+        joints_[i].length = joints[i].length;
     }
+    root_pos_ = root_pos;
+    root_quat_ = root_quat;
+    forward_kinematics();
+}
+
+void Chain::drag_joint(const Input& input, ViewPlane view_plane)
+{
+    int hovered_joint = ChainGeometry::pick(screen_joints(input.display_size()), input.mouse_pos(), 15.0f);
 
     if (input.mouse_clicked(0) && !input.want_capture_mouse()) {
         if (hovered_joint >= 0) {
@@ -119,7 +133,7 @@ void Chain::drag_joint(const Input& input, ViewPlane view_plane, const glm::mat4
                 default:            { plane_point = camera_->target; break; }
             }
 
-            glm::vec3 worldPos = project_to_plane(ImVec2(mouseNow.x, mouseNow.y), view_plane, proj, view, plane_point);
+            glm::vec3 worldPos = project_to_plane(ImVec2(mouseNow.x, mouseNow.y), view_plane, plane_point);
 
             if (view_plane == ViewPlane::XY) { worldPos.z = drag_start_world_.z; }
             else if (view_plane == ViewPlane::YZ) { worldPos.x = drag_start_world_.x; }
@@ -130,6 +144,7 @@ void Chain::drag_joint(const Input& input, ViewPlane view_plane, const glm::mat4
             for (size_t i = selected_joint_; i < joints_.size(); ++i) {
                 joints_[i].pos += delta;
             }
+            ++pose_version_;
         }
     }
     else if (!input.mouse_down(0)) {
@@ -147,7 +162,7 @@ void Chain::drag_joint(const Input& input, ViewPlane view_plane, const glm::mat4
                 glm::quat new_local_rot = glm::inverse(new_root_quat) * dragged_joint_world_rot;
                 joints_[1].local_rot = new_local_rot;
 
-                Kinematics::forward_kinematics(joints_, root_pos_, root_quat_);
+                forward_kinematics();
             }
             else {
                 glm::quat new_parent_world_rot = Math::compute_frame_quat(joints_[parent].pos, joints_[selected_joint_].pos);
@@ -162,7 +177,7 @@ void Chain::drag_joint(const Input& input, ViewPlane view_plane, const glm::mat4
                 glm::quat new_dragged_local_rot = glm::inverse(new_parent_world_rot) * dragged_joint_world_rot;
                 joints_[selected_joint_].local_rot = new_dragged_local_rot;
 
-                Kinematics::forward_kinematics(joints_, root_pos_, root_quat_);
+                forward_kinematics();
             }
         }
         dragging_ = false;
@@ -254,9 +269,10 @@ void Chain::attach_tendon(glm::vec3& pt)
     float bin = glm::dot(diff, binormal);
 
     tendons_.push_back({ minIdx, t_best, glm::vec2(nor, bin), up });
+    ++pose_version_;
 }
 
-glm::vec3 Chain::project_to_plane(const ImVec2& mouse, ViewPlane view_plane, const glm::mat4& proj, const glm::mat4& view, const glm::vec3& plane_point)
+glm::vec3 Chain::project_to_plane(const ImVec2& mouse, ViewPlane view_plane, const glm::vec3& plane_point)
 {
     float win_w = ImGui::GetIO().DisplaySize.x;
     float win_h = ImGui::GetIO().DisplaySize.y;
@@ -265,7 +281,7 @@ glm::vec3 Chain::project_to_plane(const ImVec2& mouse, ViewPlane view_plane, con
     float ndc_x = 2.0f * (mouse.x / win_w) - 1.0f;
     float ndc_y = 1.0f - 2.0f * (mouse.y / win_h);
 
-    glm::mat4 inv_vp = glm::inverse(proj * view);
+    const glm::mat4& inv_vp = camera_->get_inverse_view_proj();
     glm::vec4 near_ndc(ndc_x, ndc_y, -1.0f, 1.0f);
     glm::vec4 far_ndc(ndc_x, ndc_y, 1.0f, 1.0f);
     glm::vec4 near_world = inv_vp * near_ndc; near_world /= near_world.w;
@@ -289,7 +305,7 @@ glm::vec3 Chain::project_to_plane(const ImVec2& mouse, ViewPlane view_plane, con
     return ray_origin + t * ray_dir;
 }
 
-void Chain::update_dragged_joint_from_mouse(const Input& input, ViewPlane view_plane, const glm::mat4& proj, const glm::mat4& view)
+void Chain::update_dragged_joint_from_mouse(const Input& input, ViewPlane view_plane)
 {
     if (selected_joint_ <= 0 || selected_joint_ >= (int)joints_.size()) return;
     glm::vec2 mouseNow = input.mouse_pos();
@@ -310,7 +326,7 @@ void Chain::update_dragged_joint_from_mouse(const Input& input, ViewPlane view_p
             break;
     }
 
-    glm::vec3 worldPos = project_to_plane(ImVec2(mouseNow.x, mouseNow.y), view_plane, proj, view, plane_point);
+    glm::vec3 worldPos = project_to_plane(ImVec2(mouseNow.x, mouseNow.y), view_plane, plane_point);
 
     if (view_plane == ViewPlane::XY) { worldPos.z = drag_start_world_.z; }
     else if (view_plane == ViewPlane::YZ) { worldPos.x = drag_start_world_.x; }
@@ -321,11 +337,12 @@ void Chain::update_dragged_joint_from_mouse(const Input& input, ViewPlane view_p
     for (size_t i = selected_joint_; i < joints_.size(); ++i) {
         joints_[i].pos += delta;
     }
+    ++pose_version_;
 }
 
-void Chain::update(const Input& input, ViewPlane view_plane, bool allow_add_points, const glm::mat4& proj, const glm::mat4& view)
+void Chain::update(const Input& input, ViewPlane view_plane, bool allow_add_points)
 {
-    drag_joint(input, view_plane, proj, view);
+    drag_joint(input, view_plane);
 
     if (input.mouse_clicked(1) && !input.want_capture_mouse() && selected_joint_ >= 0) {
         dragging_ = false;
@@ -347,7 +364,7 @@ void Chain::update(const Input& input, ViewPlane view_plane, bool allow_add_poin
 
             if (selected_joint_ == 0) {
                 root_quat_ = q * root_quat_;
-                Kinematics::forward_kinematics(joints_, root_pos_, root_quat_);
+                forward_kinematics();
             }
             else {
                 glm::quat parent_world_rot = joints_[selected_joint_ - 1].rot;
@@ -361,7 +378,7 @@ void Chain::update(const Input& input, ViewPlane view_plane, bool allow_add_poin
                 joint.local_rot = glm::inverse(parent_world_rot) * joint.rot;
 
                 Kinematics::update_segment_lengths(joints_);
-                Kinematics::forward_kinematics(joints_, root_pos_, root_quat_);
+                forward_kinematics();
             }
         }
         else {
@@ -371,7 +388,7 @@ void Chain::update(const Input& input, ViewPlane view_plane, bool allow_add_poin
             else if (input.key_down(ImGuiKey_Z)) { axis = glm::vec3(0, 0, 1); }
 
             if (axis != glm::vec3(0.0f)) {
-                Kinematics::forward_kinematics(joints_, root_pos_, root_quat_);
+                forward_kinematics();
                 glm::quat q = Math::axis_angle_quat(axis, delta);
                 if (selected_joint_ == 0) {
                     root_quat_ = q * root_quat_;
@@ -380,48 +397,24 @@ void Chain::update(const Input& input, ViewPlane view_plane, bool allow_add_poin
                     auto& joint = joints_[selected_joint_];
                     joint.local_rot = q * joint.local_rot;
                 }
-                Kinematics::forward_kinematics(joints_, root_pos_, root_quat_);
+                forward_kinematics();
             }
         }
 
         if (dragging_) {
-            update_dragged_joint_from_mouse(input, view_plane, proj, view);
+            update_dragged_joint_from_mouse(input, view_plane);
         }
     }
 
     if (allow_add_points && view_plane != ViewPlane::XYZ && input.mouse_clicked(0) && !input.want_capture_mouse()) {
         glm::vec2 mouse = input.mouse_pos();
-        bool on_joint = false;
-        bool on_attached = false;
-
-        for (const auto& j : joints_) {
-            glm::vec4 p = proj * view * glm::vec4(j.pos, 1.0f);
-            if (p.w != 0.0f) p /= p.w;
-            float sx = (p.x * 0.5f + 0.5f) * input.display_size().x;
-            float sy = (1.0f - (p.y * 0.5f + 0.5f)) * input.display_size().y;
-            if (glm::distance(mouse, glm::vec2(sx, sy)) < 15.0f) {
-                on_joint = true;
-                break;
-            }
-        }
-        for (const auto& ap : tendons_) {
-            Bone bone(joints_, ap.bone_idx);
-            glm::vec3 up = ap.up;
-            glm::vec3 binormal = bone.binormal(up);
-            glm::vec3 normal = bone.normal(up);
-            glm::vec3 world_pos = bone.point_at(ap.t) + ap.local_offset.x * normal + ap.local_offset.y * binormal;
-            
-            glm::vec4 p = proj * view * glm::vec4(world_pos, 1.0f);
-            if (p.w != 0.0f) p /= p.w;
-            
-            float sx = (p.x * 0.5f + 0.5f) * input.display_size().x;
-            float sy = (1.0f - (p.y * 0.5f + 0.5f)) * input.display_size().y;
-            
-            if (glm::distance(mouse, glm::vec2(sx, sy)) < 15.0f) {
-                on_attached = true;
-                break;
-            }
-        }
+        const glm::mat4& view_proj = camera_->get_view_proj();
+
+        FrameArena::Scope scope(FrameArena::frame());
+        std::pmr::vector<glm::vec3> tendon_positions(&FrameArena::frame());
+        ChainGeometry::tendon_positions(joints_, tendons_, tendon_positions);
+        bool on_joint = ChainGeometry::pick(screen_joints(input.display_size()), mouse, 15.0f) >= 0;
+        bool on_attached = ChainGeometry::pick(tendon_positions, view_proj, input.display_size(), mouse, 15.0f) >= 0;
 
         if (!on_joint && !on_attached) {
             glm::vec3 plane_point;
@@ -440,101 +433,126 @@ void Chain::update(const Input& input, ViewPlane view_plane, bool allow_add_poin
                     break;
             }
 
-            glm::vec3 world_pos = project_to_plane(ImVec2(mouse.x, mouse.y), view_plane, proj, view, plane_point);
+            glm::vec3 world_pos = project_to_plane(ImVec2(mouse.x, mouse.y), view_plane, plane_point);
             attach_tendon(world_pos);
         }
     }
 }
 
-void Chain::draw_batch(const std::vector<Vertex>& verts, GLenum mode, float size_or_width) {
+const std::vector<glm::vec2>& Chain::screen_joints(const glm::vec2& display_size)
+{
+    uint64_t camera_version = camera_->version();
+    if (screen_camera_version_ != camera_version || screen_pose_version_ != pose_version_ || 
+        screen_display_size_ != display_size || screen_joints_.size() != joints_.size()) {
+        ChainGeometry::project(joints_, camera_->get_view_proj(), display_size, screen_joints_);
+        screen_camera_version_ = camera_version;
+        screen_pose_version_ = pose_version_;
+        screen_display_size_ = display_size;
+    }
+    return screen_joints_;
+}
+
+void Chain::draw_batch(std::span<const Vertex> verts, GLenum mode, float size_or_width) {
     if (verts.empty()) { return; }
     if (mode == GL_POINTS) { glPointSize(size_or_width); }
     if (mode == GL_LINES) { glLineWidth(size_or_width); }
-    buffer_.update_data(verts.data(), verts.size() * sizeof(Vertex));
+    {
+        Trace::Scope trace("Buffer upload");
+        buffer_.update_data(verts.data(), verts.size() * sizeof(Vertex));
+    }
+    Trace::Scope trace("Draw");
     buffer_.draw(mode, (GLsizei)verts.size());
 }
 
-void Chain::render(const glm::mat4& mvp, bool tendons_only)
+void Chain::render(const glm::mat4& mvp, bool tendons_only, const std::vector<Joint>* pose, bool lod, uint64_t given_pose_version)
 {
-    glm::vec3 outline_color = glm::vec3(0, 0, 0);
-    glm::vec3 main_color = glm::vec3(0.85f, 0.85f, 0.85f);
+    // Draw the given pose (e.g. interpolated by the simulation) or the edit pose
+    const std::vector<Joint>& joints = pose ? *pose : joints_;
+
+    // Vertex batches live in the frame arena until the draw calls have copied them
+    FrameArena& arena = FrameArena::frame();
+    FrameArena::Scope scope(arena);
+
+    // Skip vertex generation and upload for parts of the chain outside the view. Boxes are
+    // padded by the joint axes and tendon offsets, the frustum by the largest point sprite.
+    float padding = ChainGeometry::axis_length;
+    for (const Tendon& tendon : tendons_) {
+        padding = std::max(padding, glm::length(tendon.local_offset));
+    }
+    glm::vec2 viewport(camera_->viewport_width(), camera_->viewport_height());
+    Frustum frustum = Frustum::from_view_proj(mvp, glm::vec2(11.0f) / viewport);
+
+    std::pmr::vector<JointRange> ranges(&arena);
+    std::pmr::vector<Tendon> tendons(&arena);
+    // The boxes only depend on the pose, so frames where only the camera moved reuse them
+    bool given = pose != nullptr;
+    uint64_t version = given ? given_pose_version : pose_version_;
+    if (version == unversioned || version != bounds_pose_version_ || given != bounds_given_pose_ || 
+        padding != bounds_padding_ || joints.size() != bounds_joint_count_) {
+        ChainGeometry::bounds(joints, padding, bounds_);
+        bounds_pose_version_ = version;
+        bounds_given_pose_ = given;
+        bounds_padding_ = padding;
+        bounds_joint_count_ = joints.size();
+    }
+    ChainGeometry::visible(bounds_, joints.size(), frustum, ranges);
+    ChainGeometry::visible(tendons_, ranges, tendons);
+
+    std::pmr::vector<glm::vec3> tendon_positions(&arena);
+    ChainVertices vertices(&arena);
+    ChainGeometry::tendon_positions(joints, tendons, tendon_positions);
+    if (lod) {
+        // Dense parts of the chain collapse to what the screen can show; the selection stays exact
+        ChainLod settings;
+        settings.view_proj = mvp;
+        settings.viewport = viewport;
+        settings.keep = selected_joint_;
+        ChainGeometry::build(joints, ranges, tendon_positions, settings, vertices, tendons_only);
+    }
+    else {
+        ChainGeometry::build(joints, ranges, tendon_positions, vertices, tendons_only);
+    }
 
-    shader_.use();
-    shader_.set_mvp(mvp);
+    size_t joints_visible = 0;
+    for (const JointRange& range : ranges) { joints_visible += range.end - range.begin; }
+    cull_stats_ = { joints.size(), joints_visible, vertices.joint_main.size(), tendons_.size(), tendons.size(), vertices.tendon_points.size() };
+    if (tendons_only) { cull_stats_.joints = cull_stats_.joints_visible = 0; }
+
+    shader_->use();
+    shader_->set_mvp(mvp);
     buffer_.bind();
     buffer_.set_vertex_attributes();
 
-    // Batch tendons
-    std::vector<Vertex> tendon_borders, tendon_points;
-    for (const auto& ap : tendons_) {
-        Bone bone(joints_, ap.bone_idx);
-        glm::vec3 up = ap.up;
-        glm::vec3 binormal = bone.binormal(up);
-        glm::vec3 normal = bone.normal(up);
-        glm::vec3 world_pos = bone.point_at(ap.t) + ap.local_offset.x * normal + ap.local_offset.y * binormal;
-
-        tendon_borders.push_back({ world_pos, glm::vec3(0.0f) });
-        tendon_points.push_back({ world_pos, glm::vec3(1.0f, 0.85f, 0.2f) });
-    }
-    draw_batch(tendon_borders, GL_POINTS, 14.0f);
-    draw_batch(tendon_points, GL_POINTS, 10.0f);
+    draw_batch(vertices.tendon_borders, GL_POINTS, 14.0f);
+    draw_batch(vertices.tendon_points, GL_POINTS, 10.0f);
 
     if (tendons_only) {
         buffer_.unbind();
-        shader_.unuse();
+        shader_->unuse();
         return;
     }
 
-    // Batch bones
-    std::vector<Vertex> bone_outline, bone_main;
-    for (size_t i = 0; i + 1 < joints_.size(); ++i) {
-        bone_outline.push_back({ joints_[i].pos, outline_color });
-        bone_outline.push_back({ joints_[i + 1].pos, outline_color });
-        bone_main.push_back({ joints_[i].pos, main_color });
-        bone_main.push_back({ joints_[i + 1].pos, main_color });
-    }
-    draw_batch(bone_outline, GL_LINES, 8.0f);
-    draw_batch(bone_main, GL_LINES, 4.0f);
-
-    // Batch joints
-    std::vector<Vertex> joint_outlines, joint_main;
-    for (const auto& j : joints_) {
-        joint_outlines.push_back({ j.pos, outline_color });
-        joint_main.push_back({ j.pos, main_color });
-    }
-    draw_batch(joint_outlines, GL_POINTS, 16.0f);
+    draw_batch(vertices.bone_outline, GL_LINES, 8.0f);
+    draw_batch(vertices.bone_main, GL_LINES, 4.0f);
+    draw_batch(vertices.joint_outlines, GL_POINTS, 16.0f);
 
     // Highlight selected joint (drawn after outlines, before main joints)
-    if (selected_joint_ >= 0 && selected_joint_ < (int)joint_main.size()) {
-        Vertex vtx = joint_main[selected_joint_];
+    if (selected_joint_ >= 0 && selected_joint_ < (int)joints.size()) {
+        Vertex vtx = { joints[selected_joint_].pos, glm::vec3(0.0f) };
 
         // Glow (largest, orange)
         vtx.color = glm::vec3(1.0f, 0.4f, 0.2f);
-        draw_batch({vtx}, GL_POINTS, 22.0f);
+        draw_batch({ &vtx, 1 }, GL_POINTS, 22.0f);
 
         // Main highlight (medium, red)
         vtx.color = glm::vec3(1.0f, 0.2f, 0.2f);
-        draw_batch({vtx}, GL_POINTS, 18.0f);
+        draw_batch({ &vtx, 1 }, GL_POINTS, 18.0f);
     }
 
     // Main joints (drawn on top, smaller)
-    draw_batch(joint_main, GL_POINTS, 12.0f);
-
-    // Batch axes
-    std::vector<Vertex> axes;
-    float axis_len = 25.0f;
-    for (size_t i = 0; i < joints_.size(); ++i) {
-        const glm::vec3& p = joints_[i].pos;
-        glm::mat3 R = glm::mat3_cast(joints_[i].rot);
-        axes.push_back({ p, glm::vec3(0.75f, 0.15f, 0.20f) });
-        axes.push_back({ p + axis_len * (R * glm::vec3(1, 0, 0)), glm::vec3(0.75f, 0.15f, 0.20f) });
-        axes.push_back({ p, glm::vec3(0.10f, 0.50f, 0.20f) });
-        axes.push_back({ p + axis_len * (R * glm::vec3(0, 1, 0)), glm::vec3(0.10f, 0.50f, 0.20f) });
-        axes.push_back({ p, glm::vec3(0.22f, 0.40f, 0.90f) });
-        axes.push_back({ p + axis_len * (R * glm::vec3(0, 0, 1)), glm::vec3(0.22f, 0.40f, 0.90f) });
-    }
-    draw_batch(axes, GL_LINES, 2.0f);
+    draw_batch(vertices.joint_main, GL_POINTS, 12.0f);
+    draw_batch(vertices.axes, GL_LINES, 2.0f);
 
     buffer_.unbind();
-    shader_.unuse();
+    shader_->unuse();
 }
@@ -1,7 +1,9 @@
 #pragma once
 
+#include <span>
 #include <vector>
 #include <memory>
+#include <cstdint>
 
 #include <glm/glm.hpp>
 #include <imgui.h>
@@ -12,38 +14,65 @@
 #include "Shader.hpp"
 #include "Buffer.hpp"
 #include "Kinematics.hpp"
+#include "ChainGeometry.hpp"
+#include "SceneGenerator.hpp"
 
 
 class Chain
 {
 public:
-    explicit Chain(std::shared_ptr<Camera>& camera);
+    // Version of a given pose that is never cached
+    static constexpr uint64_t unversioned = UINT64_MAX;
 
-    void update(const Input& input, ViewPlane view_plane, bool allow_add_points, const glm::mat4& proj, const glm::mat4& view);
-    void render(const glm::mat4& mvp, bool tendons_only = false);
+    // Chains of a scene share one shader program
+    Chain(std::shared_ptr<Camera>& camera, std::shared_ptr<Shader> shader, const ChainSpec& spec);
+
+    // Chain with a stored pose, e.g. from a scene file; positions and world rotations are taken as given
+    Chain(std::shared_ptr<Camera>& camera, std::shared_ptr<Shader> shader, const glm::vec3& root_pos, const glm::quat& root_quat,
+        std::vector<Joint> joints, std::vector<Tendon> tendons);
+
+    void update(const Input& input, ViewPlane view_plane, bool allow_add_points);
+    // A given pose's version keys the culling boxes like pose_version() does for the edit pose
+    void render(const glm::mat4& mvp, bool tendons_only = false, const std::vector<Joint>* pose = nullptr, bool lod = true,
+        uint64_t given_pose_version = unversioned);
+
+    // Counts of the last render after frustum culling and level of detail
+    const CullStats& cull_stats() const { return cull_stats_; }
 
     int active_joint() const { return selected_joint_; }
     std::vector<Joint>& joints() { return joints_; }
     const std::vector<Joint>& joints() const { return joints_; }
+    const std::vector<Tendon>& tendons() const { return tendons_; }
+    glm::vec3 root_pos() const { return root_pos_; }
     glm::quat root_quat() const { return root_quat_; }
-    void set_root_quat(const glm::quat& q) { root_quat_ = q; }
+    void set_root_quat(const glm::quat& q) { root_quat_ = q; ++pose_version_; }
     glm::quat world_rotation(size_t idx) const { return joints_[idx].rot; }
+    bool dragging() const { return dragging_; }
+
+    // Incremented whenever the pose changes
+    uint64_t pose_version() const { return pose_version_; }
 
-    void forward_kinematics() { Kinematics::forward_kinematics(joints_, root_pos_, root_quat_); }
+    void forward_kinematics() { Kinematics::forward_kinematics(joints_, root_pos_, root_quat_); ++pose_version_; }
+
+    // Takes the root transform, local rotations and lengths of a stored pose and runs FK; tendons on removed bones are dropped
+    void set_pose(const glm::vec3& root_pos, const glm::quat& root_quat, std::span<const Joint> joints);
 
 public:
     ViewPlane view_plane = ViewPlane::XY;
 
 private:
-    void drag_joint(const Input& input, ViewPlane view_plane, const glm::mat4& proj, const glm::mat4& view);
-    void update_dragged_joint_from_mouse(const Input& input, ViewPlane view_plane, const glm::mat4& proj, const glm::mat4& view);
+    void drag_joint(const Input& input, ViewPlane view_plane);
+    void update_dragged_joint_from_mouse(const Input& input, ViewPlane view_plane);
     void attach_tendon(glm::vec3& pt);
-    glm::vec3 project_to_plane(const ImVec2& mouse, ViewPlane view_plane, const glm::mat4& proj, const glm::mat4& view, const glm::vec3& plane_point);
+    glm::vec3 project_to_plane(const ImVec2& mouse, ViewPlane view_plane, const glm::vec3& plane_point);
+
+    void draw_batch(std::span<const Vertex> verts, GLenum mode, float size_or_width);
 
-    void draw_batch(const std::vector<Vertex>& verts, GLenum mode, float size_or_width);
+    // Window positions of the joints; reprojected only when the camera, the pose or the display size changed
+    const std::vector<glm::vec2>& screen_joints(const glm::vec2& display_size);
 
 private:
-    Shader shader_;
+    std::shared_ptr<Shader> shader_;
     Buffer buffer_;
     std::shared_ptr<Camera> camera_;
 
@@ -53,9 +82,22 @@ private:
 
     glm::vec3 root_pos_;
     glm::quat root_quat_;
+    uint64_t pose_version_;
 
     bool dragging_;
     bool just_selected_;
     glm::vec3 drag_start_world_;
     glm::vec2 select_start_mouse_;
+
+    ChainBounds bounds_;
+    uint64_t bounds_pose_version_{ unversioned };
+    bool bounds_given_pose_{ false };
+    float bounds_padding_{ 0.0f };
+    size_t bounds_joint_count_{ 0 };
+    CullStats cull_stats_;
+
+    std::vector<glm::vec2> screen_joints_;
+    uint64_t screen_camera_version_{ 0 };
+    uint64_t screen_pose_version_{ 0 };
+    glm::vec2 screen_display_size_{ 0.0f };
 };
@@ -0,0 +1,460 @@
+#include "ChainGeometry.hpp"
+
+#include <atomic>
+#include <cstdint>
+#include <algorithm>
+
+#include <glm/gtc/quaternion.hpp>
+
+#include "JobSystem.hpp"
+
+
+namespace
+{
+    // Items per job; below this the work runs inline
+    constexpr size_t pick_grain = 4096;
+    constexpr size_t vertex_grain = 2048;
+    constexpr size_t bounds_grain = 16;     // Leaves
+    constexpr size_t lod_block = 4096;      // Joints merged independently; fixed so the result does not depend on the worker count
+    constexpr float lod_margin = 16.0f;     // Pixels around the viewport with cells of their own
+
+    // Per visible joint of a level of detail build
+    constexpr uint8_t lod_kept = 1;         // Survived polyline merging
+    constexpr uint8_t lod_bone = 2;         // Starts a bone
+    constexpr uint8_t lod_sprite = 4;       // Represents its screen cell
+    constexpr uint8_t lod_outline = 8;
+    constexpr uint8_t lod_axes = 16;
+
+    // Consecutive joints of one visible range, with the vertices they produce
+    struct LodBlock
+    {
+        size_t out_begin;
+        size_t joint_begin;
+        size_t count;
+        size_t bones = 0, bone_outlines = 0, sprites = 0, joint_outlines = 0, axes = 0;
+    };
+
+    // Screen cells, each owned by the lowest index claiming it
+    class CellGrid
+    {
+    public:
+        CellGrid(const ChainLod& lod, std::pmr::memory_resource* resource) :
+            lod_{ lod },
+            width_{ static_cast<size_t>((lod.viewport.x + 2.0f * lod_margin) / lod.cell) + 1 },
+            height_{ static_cast<size_t>((lod.viewport.y + 2.0f * lod_margin) / lod.cell) + 1 },
+            cells_(width_ * height_, UINT32_MAX, resource)
+        {
+        }
+
+        size_t cell(const glm::vec2& screen) const
+        {
+            glm::vec2 c = glm::clamp((screen + lod_margin) / lod_.cell, glm::vec2(0.0f), glm::vec2(width_ - 1, height_ - 1));
+            return static_cast<size_t>(c.y) * width_ + static_cast<size_t>(c.x);
+        }
+
+        void claim(size_t cell, uint32_t index)
+        {
+            std::atomic_ref<uint32_t> slot(cells_[cell]);
+            uint32_t current = slot.load(std::memory_order_relaxed);
+            while (index < current && !slot.compare_exchange_weak(current, index, std::memory_order_relaxed)) {}
+        }
+
+        bool owns(size_t cell, uint32_t index) const { return cells_[cell] == index; }
+        void clear() { std::fill(cells_.begin(), cells_.end(), UINT32_MAX); }
+
+    private:
+        const ChainLod& lod_;
+        size_t width_;
+        size_t height_;
+        std::pmr::vector<uint32_t> cells_;
+    };
+
+    template <typename Screen>
+    int pick_last(size_t count, Screen screen, const glm::vec2& mouse, float radius)
+    {
+        std::atomic<int> picked{ -1 };
+
+        JobSystem::instance().parallel_for("Picking", count, pick_grain, [&](size_t begin, size_t end) {
+            // Later indices win, so scan each range backwards
+            for (size_t i = end; i-- > begin; ) {
+                if (glm::distance(mouse, screen(i)) < radius) {
+                    int current = picked.load(std::memory_order_relaxed);
+                    while ((int)i > current && !picked.compare_exchange_weak(current, (int)i, std::memory_order_relaxed)) {}
+                    break;
+                }
+            }
+        });
+
+        return picked.load();
+    }
+}
+
+
+glm::vec3 ChainGeometry::tendon_position(const std::vector<Joint>& joints, const Tendon& tendon)
+{
+    Bone bone(joints, tendon.bone_idx);
+    glm::vec3 binormal = bone.binormal(tendon.up);
+    glm::vec3 normal = bone.normal(tendon.up);
+    return bone.point_at(tendon.t) + tendon.local_offset.x * normal + tendon.local_offset.y * binormal;
+}
+
+void ChainGeometry::tendon_positions(const std::vector<Joint>& joints, std::span<const Tendon> tendons, std::pmr::vector<glm::vec3>& out)
+{
+    out.resize(tendons.size());
+
+    JobSystem::instance().parallel_for("Tendons", tendons.size(), vertex_grain, [&](size_t begin, size_t end) {
+        for (size_t i = begin; i < end; ++i) {
+            out[i] = tendon_position(joints, tendons[i]);
+        }
+    });
+}
+
+glm::vec2 ChainGeometry::project(const glm::vec3& pos, const glm::mat4& view_proj, const glm::vec2& display_size)
+{
+    glm::vec4 p = view_proj * glm::vec4(pos, 1.0f);
+    if (p.w != 0.0f) { p /= p.w; }
+
+    float sx = (p.x * 0.5f + 0.5f) * display_size.x;
+    float sy = (1.0f - (p.y * 0.5f + 0.5f)) * display_size.y;
+    return glm::vec2(sx, sy);
+}
+
+void ChainGeometry::project(const std::vector<Joint>& joints, const glm::mat4& view_proj, const glm::vec2& display_size, std::vector<glm::vec2>& out)
+{
+    out.resize(joints.size());
+
+    JobSystem::instance().parallel_for("Projection", joints.size(), vertex_grain, [&](size_t begin, size_t end) {
+        for (size_t i = begin; i < end; ++i) {
+            out[i] = project(joints[i].pos, view_proj, display_size);
+        }
+    });
+}
+
+int ChainGeometry::pick(const std::vector<Joint>& joints, const glm::mat4& view_proj, const glm::vec2& display_size, const glm::vec2& mouse, float radius)
+{
+    return pick_last(joints.size(), [&](size_t i) { return project(joints[i].pos, view_proj, display_size); }, mouse, radius);
+}
+
+int ChainGeometry::pick(std::span<const glm::vec3> points, const glm::mat4& view_proj, const glm::vec2& display_size, const glm::vec2& mouse, float radius)
+{
+    return pick_last(points.size(), [&](size_t i) { return project(points[i], view_proj, display_size); }, mouse, radius);
+}
+
+int ChainGeometry::pick(std::span<const glm::vec2> screen, const glm::vec2& mouse, float radius)
+{
+    return pick_last(screen.size(), [&](size_t i) { return screen[i]; }, mouse, radius);
+}
+
+void ChainGeometry::bounds(const std::vector<Joint>& joints, float padding, ChainBounds& out)
+{
+    size_t leaves = (joints.size() + ChainBounds::leaf_size - 1) / ChainBounds::leaf_size;
+
+    // Level sizes only change with the joint count, so the vectors are reused across frames
+    size_t levels = 0;
+    for (size_t n = leaves; n > 0; n = n > 1 ? (n + ChainBounds::fanout - 1) / ChainBounds::fanout : 0) { ++levels; }
+    out.levels.resize(levels);
+    if (levels == 0) { return; }
+    out.levels[0].resize(leaves);
+
+    JobSystem::instance().parallel_for("Bounds", leaves, bounds_grain, [&](size_t begin, size_t end) {
+        for (size_t leaf = begin; leaf < end; ++leaf) {
+            size_t first = leaf * ChainBounds::leaf_size;
+            size_t last = std::min(first + ChainBounds::leaf_size, joints.size() - 1);   // Inclusive: the next leaf's first joint ends the bone
+
+            Bounds box;
+            for (size_t i = first; i <= last; ++i) {
+                box.extend(joints[i].pos);
+            }
+            box.pad(padding);
+            out.levels[0][leaf] = box;
+        }
+    });
+
+    for (size_t level = 1; level < levels; ++level) {
+        const std::vector<Bounds>& below = out.levels[level - 1];
+        std::vector<Bounds>& boxes = out.levels[level];
+        boxes.assign((below.size() + ChainBounds::fanout - 1) / ChainBounds::fanout, Bounds{});
+        for (size_t i = 0; i < below.size(); ++i) {
+            boxes[i / ChainBounds::fanout].extend(below[i]);
+        }
+    }
+}
+
+void ChainGeometry::visible(const ChainBounds& bounds, size_t joint_count, const Frustum& frustum, std::pmr::vector<JointRange>& out)
+{
+    out.clear();
+    if (bounds.levels.empty()) { return; }
+
+    // Depth first from the root, so leaves are emitted in order
+    auto visit = [&](auto& self, size_t level, size_t index) -> void {
+        if (!frustum.intersects(bounds.levels[level][index])) { return; }
+
+        if (level == 0) {
+            size_t begin = index * ChainBounds::leaf_size;
+            size_t end = std::min(begin + ChainBounds::leaf_size, joint_count);
+            if (!out.empty() && out.back().end == begin) { out.back().end = end; }
+            else { out.push_back({ begin, end }); }
+            return;
+        }
+
+        size_t first = index * ChainBounds::fanout;
+        size_t last = std::min(first + ChainBounds::fanout, bounds.levels[level - 1].size());
+        for (size_t child = first; child < last; ++child) {
+            self(self, level - 1, child);
+        }
+    };
+    visit(visit, bounds.levels.size() - 1, 0);
+}
+
+void ChainGeometry::visible(std::span<const Tendon> tendons, std::span<const JointRange> ranges, std::pmr::vector<Tendon>& out)
+{
+    out.clear();
+    for (const Tendon& tendon : tendons) {
+        auto it = std::upper_bound(ranges.begin(), ranges.end(), tendon.bone_idx, [](size_t idx, const JointRange& range) { return idx < range.end; });
+        if (it != ranges.end() && it->begin <= tendon.bone_idx) {
+            out.push_back(tendon);
+        }
+    }
+}
+
+void ChainGeometry::build(const std::vector<Joint>& joints, std::span<const glm::vec3> tendon_positions, ChainVertices& out, bool tendons_only)
+{
+    JointRange all{ 0, joints.size() };
+    build(joints, { &all, 1 }, tendon_positions, out, tendons_only);
+}
+
+void ChainGeometry::build(const std::vector<Joint>& joints, std::span<const JointRange> ranges, std::span<const glm::vec3> tendon_positions, ChainVertices& out, bool tendons_only)
+{
+    const glm::vec3 outline_color = glm::vec3(0, 0, 0);
+    const glm::vec3 main_color = glm::vec3(0.85f, 0.85f, 0.85f);
+    const float axis_len = axis_length;
+
+    size_t count = 0;
+    if (!tendons_only) {
+        for (const JointRange& range : ranges) { count += range.end - range.begin; }
+    }
+
+    // The last joint has no bone; if drawn it is always the last one
+    bool has_last = count > 0 && ranges.back().end == joints.size();
+    size_t bones = has_last ? count - 1 : count;
+
+    // Sized up front so every job writes its own slots
+    out.tendon_borders.resize(tendon_positions.size());
+    out.tendon_points.resize(tendon_positions.size());
+    out.bone_outline.resize(bones * 2);
+    out.bone_main.resize(bones * 2);
+    out.joint_outlines.resize(count);
+    out.joint_main.resize(count);
+    out.axes.resize(count * 6);
+
+    for (size_t i = 0; i < tendon_positions.size(); ++i) {
+        out.tendon_borders[i] = { tendon_positions[i], glm::vec3(0.0f) };
+        out.tendon_points[i] = { tendon_positions[i], glm::vec3(1.0f, 0.85f, 0.2f) };
+    }
+
+    JobSystem::instance().parallel_for("Vertices", count, vertex_grain, [&](size_t begin, size_t end) {
+        // Find the range holding output slot begin; ranges are few after merging
+        size_t r = 0, offset = 0;
+        while (offset + (ranges[r].end - ranges[r].begin) <= begin) {
+            offset += ranges[r].end - ranges[r].begin;
+            ++r;
+        }
+
+        for (size_t o = begin; o < end; ++o) {
+            if (o - offset == ranges[r].end - ranges[r].begin) {
+                offset = o;
+                ++r;
+            }
+            size_t i = ranges[r].begin + (o - offset);
+            const glm::vec3& p = joints[i].pos;
+
+            if (o < bones) {
+                out.bone_outline[o * 2] = { p, outline_color };
+                out.bone_outline[o * 2 + 1] = { joints[i + 1].pos, outline_color };
+                out.bone_main[o * 2] = { p, main_color };
+                out.bone_main[o * 2 + 1] = { joints[i + 1].pos, main_color };
+            }
+
+            out.joint_outlines[o] = { p, outline_color };
+            out.joint_main[o] = { p, main_color };
+
+            glm::mat3 R = glm::mat3_cast(joints[i].rot);
+            Vertex* axes = &out.axes[o * 6];
+            axes[0] = { p, glm::vec3(0.75f, 0.15f, 0.20f) };
+            axes[1] = { p + axis_len * (R * glm::vec3(1, 0, 0)), glm::vec3(0.75f, 0.15f, 0.20f) };
+            axes[2] = { p, glm::vec3(0.10f, 0.50f, 0.20f) };
+            axes[3] = { p + axis_len * (R * glm::vec3(0, 1, 0)), glm::vec3(0.10f, 0.50f, 0.20f) };
+            axes[4] = { p, glm::vec3(0.22f, 0.40f, 0.90f) };
+            axes[5] = { p + axis_len * (R * glm::vec3(0, 0, 1)), glm::vec3(0.22f, 0.40f, 0.90f) };
+        }
+    });
+}
+
+void ChainGeometry::build(const std::vector<Joint>& joints, std::span<const JointRange> ranges, std::span<const glm::vec3> tendon_positions, const ChainLod& lod, ChainVertices& out, bool tendons_only)
+{
+    const glm::vec3 outline_color = glm::vec3(0, 0, 0);
+    const glm::vec3 main_color = glm::vec3(0.85f, 0.85f, 0.85f);
+    const glm::vec3 axis_colors[3] = { glm::vec3(0.75f, 0.15f, 0.20f), glm::vec3(0.10f, 0.50f, 0.20f), glm::vec3(0.22f, 0.40f, 0.90f) };
+
+    size_t visible = 0;
+    for (const JointRange& range : ranges) { visible += range.end - range.begin; }
+    if (visible < lod.min_joints) {
+        build(joints, ranges, tendon_positions, out, tendons_only);
+        return;
+    }
+
+    std::pmr::memory_resource* resource = out.joint_main.get_allocator().resource();
+    CellGrid grid(lod, resource);
+
+    // Tendons: one sprite per cell
+    {
+        std::pmr::vector<uint32_t> cells(tendon_positions.size(), resource);
+        JobSystem::instance().parallel_for("LOD tendons", tendon_positions.size(), vertex_grain, [&](size_t begin, size_t end) {
+            for (size_t i = begin; i < end; ++i) {
+                cells[i] = static_cast<uint32_t>(grid.cell(project(tendon_positions[i], lod.view_proj, lod.viewport)));
+                grid.claim(cells[i], static_cast<uint32_t>(i));
+            }
+        });
+
+        size_t drawn = 0;
+        for (size_t i = 0; i < tendon_positions.size(); ++i) {
+            drawn += grid.owns(cells[i], static_cast<uint32_t>(i));
+        }
+        out.tendon_borders.resize(drawn);
+        out.tendon_points.resize(drawn);
+        for (size_t i = 0, t = 0; i < tendon_positions.size(); ++i) {
+            if (!grid.owns(cells[i], static_cast<uint32_t>(i))) { continue; }
+            out.tendon_borders[t] = { tendon_positions[i], glm::vec3(0.0f) };
+            out.tendon_points[t] = { tendon_positions[i], glm::vec3(1.0f, 0.85f, 0.2f) };
+            ++t;
+        }
+        grid.clear();
+    }
+
+    if (tendons_only) { ranges = {}; }
+
+    // Blocks never straddle a range, so every range keeps its first and last joint
+    std::pmr::vector<LodBlock> blocks(resource);
+    size_t count = 0;
+    for (const JointRange& range : ranges) {
+        for (size_t begin = range.begin; begin < range.end; begin += lod_block) {
+            size_t n = std::min(lod_block, range.end - begin);
+            blocks.push_back({ count, begin, n });
+            count += n;
+        }
+    }
+
+    std::pmr::vector<glm::vec2> screen(count, resource);
+    std::pmr::vector<uint8_t> flags(count, 0, resource);
+
+    // Merge joints closer than min_segment to the last kept one into its polyline, then let the rest claim cells
+    JobSystem::instance().parallel_for("LOD merge", blocks.size(), 1, [&](size_t begin, size_t end) {
+        for (size_t b = begin; b < end; ++b) {
+            const LodBlock& block = blocks[b];
+            glm::vec2 last(0.0f);
+            for (size_t k = 0; k < block.count; ++k) {
+                size_t o = block.out_begin + k, i = block.joint_begin + k;
+                screen[o] = project(joints[i].pos, lod.view_proj, lod.viewport);
+
+                bool kept = k == 0 || k + 1 == block.count || (int)i == lod.keep || glm::distance(screen[o], last) >= lod.min_segment;
+                if (kept) {
+                    flags[o] = lod_kept;
+                    last = screen[o];
+                    grid.claim(grid.cell(screen[o]), static_cast<uint32_t>(o));
+                }
+            }
+        }
+    });
+
+    // Decide what each kept joint draws, back to front so the next kept joint is known
+    JobSystem::instance().parallel_for("LOD select", blocks.size(), 1, [&](size_t begin, size_t end) {
+        for (size_t b = begin; b < end; ++b) {
+            LodBlock& block = blocks[b];
+            size_t last = block.joint_begin + block.count - 1;
+            bool has_next = last + 1 < joints.size();
+            glm::vec2 next = has_next ? project(joints[last + 1].pos, lod.view_proj, lod.viewport) : screen[block.out_begin + block.count - 1];
+
+            for (size_t k = block.count; k-- > 0; ) {
+                size_t o = block.out_begin + k, i = block.joint_begin + k;
+                if (!(flags[o] & lod_kept)) { continue; }
+
+                bool bone = k + 1 < block.count || has_next;
+                bool exact = (int)i == lod.keep;
+                bool sprite = exact || grid.owns(grid.cell(screen[o]), static_cast<uint32_t>(o));
+                bool outline = exact || (bone ? glm::distance(screen[o], next) >= lod.min_outline : sprite);
+
+                bool axes = exact;
+                if (sprite && !axes) {
+                    glm::mat3 R = glm::mat3_cast(joints[i].rot);
+                    for (int a = 0; a < 3 && !axes; ++a) {
+                        glm::vec3 tip = joints[i].pos + axis_length * R[a];
+                        axes = glm::distance(screen[o], project(tip, lod.view_proj, lod.viewport)) >= lod.min_axis;
+                    }
+                }
+
+                uint8_t f = lod_kept;
+                if (bone) { f |= lod_bone; ++block.bones; block.bone_outlines += outline; }
+                if (sprite) { f |= lod_sprite; ++block.sprites; block.joint_outlines += outline; }
+                if (outline) { f |= lod_outline; }
+                if (sprite && axes) { f |= lod_axes; ++block.axes; }
+                flags[o] = f;
+                next = screen[o];
+            }
+        }
+    });
+
+    // Offsets of each block in the outputs
+    size_t bones = 0, bone_outlines = 0, sprites = 0, joint_outlines = 0, axes = 0;
+    for (LodBlock& block : blocks) {
+        bones += block.bones; block.bones = bones;
+        bone_outlines += block.bone_outlines; block.bone_outlines = bone_outlines;
+        sprites += block.sprites; block.sprites = sprites;
+        joint_outlines += block.joint_outlines; block.joint_outlines = joint_outlines;
+        axes += block.axes; block.axes = axes;
+    }
+    out.bone_outline.resize(bone_outlines * 2);
+    out.bone_main.resize(bones * 2);
+    out.joint_outlines.resize(joint_outlines);
+    out.joint_main.resize(sprites);
+    out.axes.resize(axes * 6);
+
+    // Each block fills its slots from the end, walking back to front like the selection
+    JobSystem::instance().parallel_for("LOD vertices", blocks.size(), 1, [&](size_t begin, size_t end) {
+        for (size_t b = begin; b < end; ++b) {
+            LodBlock block = blocks[b];
+            size_t last = block.joint_begin + block.count - 1;
+            glm::vec3 next = last + 1 < joints.size() ? joints[last + 1].pos : glm::vec3(0.0f);
+
+            for (size_t k = block.count; k-- > 0; ) {
+                size_t o = block.out_begin + k;
+                uint8_t f = flags[o];
+                if (!(f & lod_kept)) { continue; }
+
+                const glm::vec3& p = joints[block.joint_begin + k].pos;
+                if (f & lod_bone) {
+                    --block.bones;
+                    out.bone_main[block.bones * 2] = { p, main_color };
+                    out.bone_main[block.bones * 2 + 1] = { next, main_color };
+                    if (f & lod_outline) {
+                        --block.bone_outlines;
+                        out.bone_outline[block.bone_outlines * 2] = { p, outline_color };
+                        out.bone_outline[block.bone_outlines * 2 + 1] = { next, outline_color };
+                    }
+                }
+                if (f & lod_sprite) {
+                    out.joint_main[--block.sprites] = { p, main_color };
+                    if (f & lod_outline) { out.joint_outlines[--block.joint_outlines] = { p, outline_color }; }
+                }
+                if (f & lod_axes) {
+                    glm::mat3 R = glm::mat3_cast(joints[block.joint_begin + k].rot);
+                    Vertex* v = &out.axes[--block.axes * 6];
+                    for (int a = 0; a < 3; ++a) {
+                        v[a * 2] = { p, axis_colors[a] };
+                        v[a * 2 + 1] = { p + axis_length * R[a], axis_colors[a] };
+                    }
+                }
+                next = p;
+            }
+        }
+    });
+}
@@ -0,0 +1,112 @@
+#pragma once
+
+#include <span>
+#include <vector>
+#include <memory_resource>
+
+#include <glm/glm.hpp>
+
+#include "Main.hpp"
+#include "Frustum.hpp"
+
+
+// Vertex batches of a chain, e.g. in the frame arena
+struct ChainVertices
+{
+    explicit ChainVertices(std::pmr::memory_resource* resource = std::pmr::get_default_resource()) :
+        tendon_borders{ resource }, tendon_points{ resource }, bone_outline{ resource }, bone_main{ resource }, 
+        joint_outlines{ resource }, joint_main{ resource }, axes{ resource } {}
+
+    std::pmr::vector<Vertex> tendon_borders;
+    std::pmr::vector<Vertex> tendon_points;
+    std::pmr::vector<Vertex> bone_outline;
+    std::pmr::vector<Vertex> bone_main;
+    std::pmr::vector<Vertex> joint_outlines;
+    std::pmr::vector<Vertex> joint_main;
+    std::pmr::vector<Vertex> axes;
+};
+
+// Joints [begin, end) of a chain
+struct JointRange
+{
+    size_t begin;
+    size_t end;
+};
+
+// Box hierarchy over a chain. A leaf covers leaf_size joints plus the bone leaving the
+// last of them; each level above merges fanout boxes of the level below.
+struct ChainBounds
+{
+    static constexpr size_t leaf_size = 256;
+    static constexpr size_t fanout = 16;
+
+    std::vector<std::vector<Bounds>> levels;   // levels[0] holds the leaves, the last level one root
+};
+
+// Screen-space level of detail for dense chains. Thresholds are in pixels.
+struct ChainLod
+{
+    glm::mat4 view_proj{ 1.0f };
+    glm::vec2 viewport{ 1.0f };
+    int keep = -1;              // Joint always drawn in full, e.g. the selection
+    size_t min_joints = 2048;   // Fewer visible joints are all drawn in full
+
+    float min_segment = 2.0f;   // Shorter bones merge into polylines
+    float cell = 4.0f;          // One joint and one tendon sprite per cell of this size
+    float min_axis = 4.0f;      // Shorter axes are hidden
+    float min_outline = 8.0f;   // Shorter bones, and their joints, are drawn without outlines
+};
+
+// What the last draw of a chain left out
+struct CullStats
+{
+    size_t joints = 0;
+    size_t joints_visible = 0;  // In the frustum
+    size_t joints_drawn = 0;    // After level of detail
+    size_t tendons = 0;
+    size_t tendons_visible = 0;
+    size_t tendons_drawn = 0;
+
+    CullStats& operator+=(const CullStats& other)
+    {
+        joints += other.joints; joints_visible += other.joints_visible; joints_drawn += other.joints_drawn;
+        tendons += other.tendons; tendons_visible += other.tendons_visible; tendons_drawn += other.tendons_drawn;
+        return *this;
+    }
+};
+
+// CPU side of chain rendering and picking (no GL calls). Large chains are split
+// across the job system.
+class ChainGeometry
+{
+public:
+    static constexpr float axis_length = 25.0f;
+
+    static glm::vec3 tendon_position(const std::vector<Joint>& joints, const Tendon& tendon);
+    static void tendon_positions(const std::vector<Joint>& joints, std::span<const Tendon> tendons, std::pmr::vector<glm::vec3>& out);
+
+    // Window coordinates of a world position
+    static glm::vec2 project(const glm::vec3& pos, const glm::mat4& view_proj, const glm::vec2& display_size);
+    static void project(const std::vector<Joint>& joints, const glm::mat4& view_proj, const glm::vec2& display_size, std::vector<glm::vec2>& out);
+
+    // Highest index within radius pixels of the mouse, or -1
+    static int pick(const std::vector<Joint>& joints, const glm::mat4& view_proj, const glm::vec2& display_size, const glm::vec2& mouse, float radius);
+    static int pick(std::span<const glm::vec3> points, const glm::mat4& view_proj, const glm::vec2& display_size, const glm::vec2& mouse, float radius);
+    static int pick(std::span<const glm::vec2> screen, const glm::vec2& mouse, float radius);   // Already projected
+
+    // Leaf boxes grown by padding, which must cover joint axes and tendon offsets
+    static void bounds(const std::vector<Joint>& joints, float padding, ChainBounds& out);
+
+    // Joints in leaves that may intersect the frustum, as sorted, merged ranges
+    static void visible(const ChainBounds& bounds, size_t joint_count, const Frustum& frustum, std::pmr::vector<JointRange>& out);
+
+    // Tendons on bones that start in one of the ranges
+    static void visible(std::span<const Tendon> tendons, std::span<const JointRange> ranges, std::pmr::vector<Tendon>& out);
+
+    static void build(const std::vector<Joint>& joints, std::span<const glm::vec3> tendon_positions, ChainVertices& out, bool tendons_only = false);
+    static void build(const std::vector<Joint>& joints, std::span<const JointRange> ranges, std::span<const glm::vec3> tendon_positions, ChainVertices& out, bool tendons_only = false);
+
+    // Same with level of detail: vertex counts are bounded by the screen, not the joint count.
+    // Scratch data comes from the resource of out's vectors.
+    static void build(const std::vector<Joint>& joints, std::span<const JointRange> ranges, std::span<const glm::vec3> tendon_positions, const ChainLod& lod, ChainVertices& out, bool tendons_only = false);
+};
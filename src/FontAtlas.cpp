@@ -0,0 +1,101 @@
+#include "FontAtlas.hpp"
+
+#include <cstdio>
+#include <cstring>
+#include <iostream>
+#include <filesystem>
+
+#include <imgui.h>
+
+
+bool FontAtlas::rasterize(ImFontAtlas& atlas, const std::string& dir)
+{
+    bool ok = true;
+    for (const auto& spec : font_specs) {
+        std::string path = (std::filesystem::path(dir) / spec.file).string();
+        if (!std::filesystem::exists(path)) {
+            std::cerr << "Font not found: " << path << '\n';
+            ok = false;
+            continue;
+        }
+
+        // Fonts are looked up by their spec name later on
+        ImFontConfig config;
+        std::snprintf(config.Name, sizeof(config.Name), "%s", spec.name);
+        if (!atlas.AddFontFromFileTTF(path.c_str(), spec.size, &config)) {
+            std::cerr << "Failed to load " << path << '\n';
+            ok = false;
+        }
+    }
+
+    return atlas.Build() && ok;
+}
+
+std::unique_ptr<ImFontAtlas> FontAtlas::restore(const BakedAtlas& baked)
+{
+    auto atlas = std::make_unique<ImFontAtlas>();
+    atlas->Flags = baked.flags;
+
+    // Texture
+    size_t tex_size = static_cast<size_t>(baked.width) * baked.height;
+    atlas->TexWidth = baked.width;
+    atlas->TexHeight = baked.height;
+    atlas->TexPixelsAlpha8 = static_cast<unsigned char*>(IM_ALLOC(tex_size));
+    std::memcpy(atlas->TexPixelsAlpha8, baked.pixels, tex_size);
+    atlas->TexUvScale = ImVec2(1.0f / baked.width, 1.0f / baked.height);
+    atlas->TexUvWhitePixel = ImVec2(baked.white_uv[0], baked.white_uv[1]);
+    for (int i = 0; i < baked.line_uv_count && i < IM_ARRAYSIZE(atlas->TexUvLines); ++i) {
+        const float* uv = baked.line_uvs + i * 4;
+        atlas->TexUvLines[i] = ImVec4(uv[0], uv[1], uv[2], uv[3]);
+    }
+
+    // Custom rects hold the mouse cursor shapes and baked lines
+    for (int i = 0; i < baked.rect_count; ++i) {
+        ImFontAtlasCustomRect rect;
+        rect.X = baked.rects[i].x;
+        rect.Y = baked.rects[i].y;
+        rect.Width = baked.rects[i].width;
+        rect.Height = baked.rects[i].height;
+        atlas->CustomRects.push_back(rect);
+    }
+    atlas->PackIdMouseCursors = baked.pack_id_cursors;
+    atlas->PackIdLines = baked.pack_id_lines;
+
+    // Font sources first, so that the pointers fonts keep into Sources stay valid
+    for (int i = 0; i < baked.font_count; ++i) {
+        ImFontConfig config;
+        std::snprintf(config.Name, sizeof(config.Name), "%s", baked.fonts[i].name);
+        config.SizePixels = baked.fonts[i].size;
+        atlas->Sources.push_back(config);
+    }
+
+    for (int i = 0; i < baked.font_count; ++i) {
+        const BakedFont& src = baked.fonts[i];
+        ImFont* font = IM_NEW(ImFont);
+        atlas->Fonts.push_back(font);
+        atlas->Sources[i].DstFont = font;
+
+        font->Sources = &atlas->Sources[i];
+        font->SourcesCount = 1;
+        font->ContainerAtlas = atlas.get();
+        font->FontSize = src.size;
+        font->Ascent = src.ascent;
+        font->Descent = src.descent;
+
+        font->Glyphs.resize(src.glyph_count);
+        for (int g = 0; g < src.glyph_count; ++g) {
+            const BakedGlyph& in = src.glyphs[g];
+            ImFontGlyph& out = font->Glyphs[g];
+            out.Colored = 0;
+            out.Visible = in.visible;
+            out.Codepoint = in.codepoint;
+            out.AdvanceX = in.advance_x;
+            out.X0 = in.x0; out.Y0 = in.y0; out.X1 = in.x1; out.Y1 = in.y1;
+            out.U0 = in.u0; out.V0 = in.v0; out.U1 = in.u1; out.V1 = in.v1;
+        }
+        font->BuildLookupTable();
+    }
+
+    atlas->TexReady = true;
+    return atlas;
+}
@@ -0,0 +1,75 @@
+#pragma once
+
+#include <memory>
+#include <string>
+
+
+struct ImFontAtlas;
+
+
+// Fonts in atlas order: Roboto-Regular.ttf is the default font, Roboto-Bold.ttf the axis font
+struct FontSpec
+{
+    const char* name;
+    const char* file;
+    float size;
+};
+
+inline constexpr FontSpec font_specs[] = {
+    { "Regular", "Roboto-Regular.ttf", 14.0f },
+    { "Axis", "Roboto-Bold.ttf", 20.0f },
+};
+
+
+// Pre-rasterized atlas data, generated at build time by artichoke_bake
+struct BakedGlyph
+{
+    unsigned int codepoint;
+    unsigned int visible;
+    float advance_x;
+    float x0, y0, x1, y1;
+    float u0, v0, u1, v1;
+};
+
+struct BakedFont
+{
+    const char* name;
+    float size;
+    float ascent;
+    float descent;
+    const BakedGlyph* glyphs;
+    int glyph_count;
+};
+
+struct BakedRect
+{
+    unsigned short x, y, width, height;
+};
+
+struct BakedAtlas
+{
+    int width;
+    int height;
+    const unsigned char* pixels;    // Alpha8, width * height
+    float white_uv[2];
+    const float* line_uvs;          // 4 floats per baked line width
+    int line_uv_count;
+    const BakedRect* rects;
+    int rect_count;
+    int pack_id_cursors;
+    int pack_id_lines;
+    int flags;
+    const BakedFont* fonts;
+    int font_count;
+};
+
+
+class FontAtlas
+{
+public:
+    // Rasterizes font_specs from TTF files in dir and builds the atlas (no ImGui context required)
+    static bool rasterize(ImFontAtlas& atlas, const std::string& dir);
+
+    // Reconstructs a ready-to-use atlas from baked data without touching the rasterizer
+    static std::unique_ptr<ImFontAtlas> restore(const BakedAtlas& baked);
+};
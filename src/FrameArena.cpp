@@ -0,0 +1,54 @@
+#include "FrameArena.hpp"
+
+#include <cstdint>
+#include <algorithm>
+
+
+FrameArena::FrameArena(size_t capacity) :
+    block_{ new std::byte[capacity] }, capacity_{ capacity }
+{
+}
+
+FrameArena& FrameArena::frame()
+{
+    static FrameArena arena(1 << 20);
+    return arena;
+}
+
+void* FrameArena::do_allocate(size_t bytes, size_t alignment)
+{
+    uintptr_t base = reinterpret_cast<uintptr_t>(block_.get());
+    uintptr_t aligned = (base + offset_ + alignment - 1) & ~(uintptr_t)(alignment - 1);
+    size_t end = static_cast<size_t>(aligned - base) + bytes;
+
+    void* p = nullptr;
+    if (end <= capacity_) {
+        offset_ = end;
+        p = reinterpret_cast<void*>(aligned);
+    }
+    else {
+        // Out of space this frame: fall back to the heap until the next reset
+        overflow_.emplace_back(new std::byte[bytes + alignment]);
+        uintptr_t raw = reinterpret_cast<uintptr_t>(overflow_.back().get());
+        p = reinterpret_cast<void*>((raw + alignment - 1) & ~(uintptr_t)(alignment - 1));
+        overflow_used_ += bytes + alignment;
+    }
+
+    peak_ = std::max(peak_, used());
+    return p;
+}
+
+void FrameArena::reset()
+{
+    high_water_ = peak_;
+
+    if (!overflow_.empty()) {
+        overflow_.clear();
+        capacity_ = std::max(capacity_ * 2, peak_ + peak_ / 2);
+        block_.reset(new std::byte[capacity_]);
+    }
+
+    offset_ = 0;
+    overflow_used_ = 0;
+    peak_ = 0;
+}
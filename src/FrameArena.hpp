@@ -0,0 +1,59 @@
+#pragma once
+
+#include <memory>
+#include <vector>
+#include <cstddef>
+#include <memory_resource>
+
+
+// Bump allocator for transient data of one frame. Allocation is a pointer increment;
+// nothing is freed individually. A Scope rewinds to where it started, and reset()
+// releases everything at the end of the frame. Used through std::pmr containers.
+class FrameArena : public std::pmr::memory_resource
+{
+public:
+    explicit FrameArena(size_t capacity);
+
+    // Arena of the render thread
+    static FrameArena& frame();
+
+    // Releases everything allocated while it was alive
+    class Scope
+    {
+    public:
+        explicit Scope(FrameArena& arena) : arena_{ arena }, offset_{ arena.offset_ }, overflow_used_{ arena.overflow_used_ } {}
+        ~Scope() { arena_.offset_ = offset_; arena_.overflow_used_ = overflow_used_; }
+
+        Scope(const Scope&) = delete;
+        Scope& operator=(const Scope&) = delete;
+
+    private:
+        FrameArena& arena_;
+        size_t offset_;
+        size_t overflow_used_;
+    };
+
+    // End of frame. A frame that did not fit grows the block, so the next one does.
+    void reset();
+
+    size_t capacity() const { return capacity_; }
+    size_t used() const { return offset_ + overflow_used_; }
+    size_t high_water() const { return high_water_; }   // Peak use of the last frame
+
+private:
+    void* do_allocate(size_t bytes, size_t alignment) override;
+    void do_deallocate(void*, size_t, size_t) override {}
+    bool do_is_equal(const std::pmr::memory_resource& other) const noexcept override { return this == &other; }
+
+private:
+    std::unique_ptr<std::byte[]> block_;
+    size_t capacity_;
+    size_t offset_{ 0 };
+
+    // Allocations that did not fit the block, held until reset
+    std::vector<std::unique_ptr<std::byte[]>> overflow_;
+    size_t overflow_used_{ 0 };
+
+    size_t peak_{ 0 };
+    size_t high_water_{ 0 };
+};
@@ -0,0 +1,286 @@
+#include "FrameCapture.hpp"
+
+#include <cstring>
+#include <iostream>
+
+#include "Trace.hpp"
+#include "MemoryTracker.hpp"
+#include "ImageWriter.hpp"
+
+
+FrameCapture::FrameCapture(const std::string& path, bool block) : 
+    path_{ path }, format_{ Format::PNG }, block_{ block }, number_width_{ 0 },
+    slots_{}, next_slot_{ 0 }, next_index_{ 0 }, width_{ 0 }, height_{ 0 }, 
+    stream_{ nullptr }, writing_{ 0 }, stopping_{ false }, captured_{ 0 }, dropped_{ 0 }
+{
+    auto ends_with = [&](const char* ext) {
+        size_t n = std::strlen(ext);
+        return path_.size() >= n && path_.compare(path_.size() - n, n, ext) == 0;
+    };
+
+    if (ends_with(".ppm")) { format_ = Format::PPM; }
+    else if (ends_with(".yuv") || path_ == "-") { format_ = Format::YUV; }
+    else if (!ends_with(".png")) { path_ += ".png"; }
+}
+
+FrameCapture::~FrameCapture()
+{
+    finish();
+
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        stopping_ = true;
+    }
+    queue_changed_.notify_all();
+    if (writer_.joinable()) { writer_.join(); }
+
+    release();
+
+    if (stream_ && stream_ != stdout) { std::fclose(stream_); }
+    else if (stream_) { std::fflush(stream_); }
+
+    if (captured_ > 0 || dropped_ > 0) {
+        std::cerr << "Captured " << captured_ << " frames (" << dropped_ << " dropped)" << std::endl;
+    }
+}
+
+bool FrameCapture::start()
+{
+    if (format_ == Format::YUV) {
+        stream_ = path_ == "-" ? stdout : std::fopen(path_.c_str(), "wb");
+        if (!stream_) {
+            std::cerr << "Failed to open capture output: " << path_ << std::endl;
+            return false;
+        }
+    }
+    else if (!parse_pattern()) {
+        std::cerr << "Invalid capture path: " << path_ << " (one frame number as %d or %0Nd, %% for a percent sign)" << std::endl;
+        return false;
+    }
+
+    writer_ = std::thread(&FrameCapture::writer_main, this);
+    return true;
+}
+
+bool FrameCapture::parse_pattern()
+{
+    std::string parts[2];
+    int conversions = 0;
+    for (size_t i = 0; i < path_.size(); ++i) {
+        if (path_[i] != '%') {
+            parts[conversions].push_back(path_[i]);
+            continue;
+        }
+        if (i + 1 < path_.size() && path_[i + 1] == '%') {
+            parts[conversions].push_back('%');
+            ++i;
+            continue;
+        }
+
+        // %d, or %0 and a width of up to two digits, then d
+        size_t end = i + 1;
+        int width = 0;
+        if (end < path_.size() && path_[end] == '0') {
+            size_t digits = ++end;
+            while (end < path_.size() && end - digits < 2 && path_[end] >= '0' && path_[end] <= '9') {
+                width = width * 10 + (path_[end++] - '0');
+            }
+            if (end == digits) return false;
+        }
+        if (end >= path_.size() || path_[end] != 'd' || conversions == 1) return false;
+        number_width_ = width;
+        ++conversions;
+        i = end;
+    }
+
+    // Number image sequences even without a pattern in the path
+    if (conversions == 0) {
+        parts[1] = parts[0].substr(parts[0].size() - 4);
+        parts[0].erase(parts[0].size() - 4);
+        parts[0] += "_";
+        number_width_ = 5;
+    }
+    name_prefix_ = std::move(parts[0]);
+    name_suffix_ = std::move(parts[1]);
+    return true;
+}
+
+void FrameCapture::capture(GLuint framebuffer, int width, int height)
+{
+    if (width <= 0 || height <= 0) return;
+
+    if (width != width_ || height != height_) {
+        finish();
+        allocate(width, height);
+    }
+
+    // The slot about to be reused holds the oldest frame, issued ring_size frames ago
+    Slot& slot = slots_[next_slot_];
+    next_slot_ = (next_slot_ + 1) % ring_size;
+    if (slot.pending) { read_back(slot); }
+
+    GLint read_framebuffer = 0;
+    glGetIntegerv(GL_READ_FRAMEBUFFER_BINDING, &read_framebuffer);
+
+    glBindFramebuffer(GL_READ_FRAMEBUFFER, framebuffer);
+    glReadBuffer(framebuffer == 0 ? GL_BACK : GL_COLOR_ATTACHMENT0);
+    glBindBuffer(GL_PIXEL_PACK_BUFFER, slot.pbo);
+    glPixelStorei(GL_PACK_ALIGNMENT, 4);
+    glReadPixels(0, 0, width, height, GL_RGBA, GL_UNSIGNED_BYTE, nullptr);
+    glBindBuffer(GL_PIXEL_PACK_BUFFER, 0);
+    glBindFramebuffer(GL_READ_FRAMEBUFFER, read_framebuffer);
+
+    slot.fence = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+    slot.index = next_index_++;
+    slot.pending = true;
+}
+
+void FrameCapture::finish()
+{
+    // Oldest first, so frames reach the writer in order
+    for (size_t i = 0; i < ring_size; ++i) {
+        Slot& slot = slots_[(next_slot_ + i) % ring_size];
+        if (slot.pending) { read_back(slot); }
+    }
+
+    std::unique_lock<std::mutex> lock(mutex_);
+    queue_changed_.wait(lock, [this] { return (queue_.empty() && writing_ == 0) || !writer_.joinable(); });
+}
+
+void FrameCapture::allocate(int width, int height)
+{
+    release();
+
+    width_ = width;
+    height_ = height;
+    GLsizeiptr size = static_cast<GLsizeiptr>(width) * height * 4;
+
+    for (Slot& slot : slots_) {
+        glGenBuffers(1, &slot.pbo);
+        glBindBuffer(GL_PIXEL_PACK_BUFFER, slot.pbo);
+        glBufferData(GL_PIXEL_PACK_BUFFER, size, nullptr, GL_STREAM_READ);
+    }
+    glBindBuffer(GL_PIXEL_PACK_BUFFER, 0);
+    next_slot_ = 0;
+}
+
+void FrameCapture::release()
+{
+    for (Slot& slot : slots_) {
+        if (slot.fence) { glDeleteSync(slot.fence); }
+        if (slot.pbo) { glDeleteBuffers(1, &slot.pbo); }
+        slot = Slot{};
+    }
+}
+
+void FrameCapture::read_back(Slot& slot)
+{
+    Trace::Scope trace("Capture readback");
+
+    // Normally signalled long ago; waits only if the GPU is several frames behind
+    glClientWaitSync(slot.fence, GL_SYNC_FLUSH_COMMANDS_BIT, 1'000'000'000);
+    glDeleteSync(slot.fence);
+    slot.fence = nullptr;
+    slot.pending = false;
+
+    size_t size = static_cast<size_t>(width_) * height_ * 4;
+
+    Frame frame{ slot.index, width_, height_, {} };
+    {
+        std::unique_lock<std::mutex> lock(mutex_);
+        if (queue_.size() >= max_queued) {
+            if (!block_) {
+                ++dropped_;
+                return;
+            }
+            queue_changed_.wait(lock, [this] { return queue_.size() < max_queued; });
+        }
+        if (!free_buffers_.empty()) {
+            frame.rgba = std::move(free_buffers_.back());
+            free_buffers_.pop_back();
+        }
+    }
+    frame.rgba.resize(size);
+
+    glBindBuffer(GL_PIXEL_PACK_BUFFER, slot.pbo);
+    const void* pixels = glMapBufferRange(GL_PIXEL_PACK_BUFFER, 0, static_cast<GLsizeiptr>(size), GL_MAP_READ_BIT);
+    if (pixels) {
+        std::memcpy(frame.rgba.data(), pixels, size);
+        glUnmapBuffer(GL_PIXEL_PACK_BUFFER);
+    }
+    glBindBuffer(GL_PIXEL_PACK_BUFFER, 0);
+
+    // A frame that could not be read is dropped rather than written as garbage
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        if (pixels) {
+            queue_.push_back(std::move(frame));
+        }
+        else {
+            ++dropped_;
+            free_buffers_.push_back(std::move(frame.rgba));
+        }
+    }
+    queue_changed_.notify_all();
+}
+
+void FrameCapture::writer_main()
+{
+    Trace::set_thread_name("Capture writer");
+    MemoryTracker::Scope memory(MemoryTag::IO);
+
+    while (true) {
+        Frame frame;
+        {
+            std::unique_lock<std::mutex> lock(mutex_);
+            queue_changed_.wait(lock, [this] { return stopping_ || !queue_.empty(); });
+            if (queue_.empty()) return;
+
+            frame = std::move(queue_.front());
+            queue_.pop_front();
+            ++writing_;
+        }
+        queue_changed_.notify_all();
+
+        bool written = false;
+        {
+            Trace::Scope trace("Encode frame");
+            written = write(frame);
+        }
+
+        if (written) {
+            ++captured_;
+        }
+        else {
+            ++dropped_;
+        }
+
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            free_buffers_.push_back(std::move(frame.rgba));
+            --writing_;
+        }
+        queue_changed_.notify_all();
+    }
+}
+
+bool FrameCapture::write(Frame& frame)
+{
+    if (format_ == Format::YUV) {
+        return ImageWriter::write_i420(stream_, frame.width, frame.height, frame.rgba.data(), yuv_scratch_);
+    }
+
+    // The number is formatted with a fixed format; the user's path never reaches printf
+    char number[32];
+    std::snprintf(number, sizeof(number), "%0*llu", number_width_, static_cast<unsigned long long>(frame.index));
+    name_.assign(name_prefix_).append(number).append(name_suffix_);
+
+    bool ok = format_ == Format::PPM ? 
+        ImageWriter::write_ppm(name_, frame.width, frame.height, frame.rgba.data()) : 
+        ImageWriter::write_png(name_, frame.width, frame.height, frame.rgba.data());
+
+    if (!ok) {
+        std::cerr << "Failed to write frame: " << name_ << std::endl;
+    }
+    return ok;
+}
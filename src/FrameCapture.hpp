@@ -0,0 +1,103 @@
+#pragma once
+
+#include <deque>
+#include <mutex>
+#include <array>
+#include <atomic>
+#include <string>
+#include <thread>
+#include <vector>
+#include <cstdio>
+#include <cstdint>
+#include <condition_variable>
+
+#include <GL/glew.h>
+
+
+// Captures rendered frames to an image sequence or a raw video stream. Each frame is
+// read into a ring of pixel buffer objects and only mapped a few frames later, when
+// the transfer has finished, so readback never stalls the frame. Encoding and disk
+// writes happen on a writer thread.
+class FrameCapture
+{
+public:
+    enum class Format { PPM, PNG, YUV };
+
+    // The format follows the extension (.ppm, .png, .yuv). Image paths may contain one
+    // frame number, %d or %0Nd (frame_%05d.png), and %% for a percent sign; other
+    // conversions are rejected by start(). "-" streams YUV to stdout.
+    // When block is false, frames are dropped instead of waiting for a slow writer.
+    FrameCapture(const std::string& path, bool block);
+    ~FrameCapture();
+
+    bool start();
+
+    // Queues a readback of the framebuffer's current contents (before the swap)
+    void capture(GLuint framebuffer, int width, int height);
+
+    // Reads back all pending frames and waits until they are written
+    void finish();
+
+    uint64_t captured() const { return captured_; }
+    uint64_t dropped() const { return dropped_; }
+
+private:
+    struct Frame
+    {
+        uint64_t index;
+        int width;
+        int height;
+        std::vector<uint8_t> rgba;
+    };
+
+    struct Slot
+    {
+        GLuint pbo = 0;
+        GLsync fence = nullptr;
+        uint64_t index = 0;
+        bool pending = false;
+    };
+
+    // Splits an image path around its frame number; false for anything but one %d or %0Nd
+    bool parse_pattern();
+
+    void allocate(int width, int height);
+    void release();
+    void read_back(Slot& slot);
+    void writer_main();
+    bool write(Frame& frame);
+
+private:
+    static constexpr size_t ring_size = 3;
+    static constexpr size_t max_queued = 8;
+
+    std::string path_;
+    Format format_;
+    bool block_;
+
+    // Image file names: prefix, frame number padded with zeros to the width, suffix
+    std::string name_prefix_;
+    std::string name_suffix_;
+    int number_width_;
+    std::string name_;                  // Writer thread
+
+    std::array<Slot, ring_size> slots_;
+    size_t next_slot_;
+    uint64_t next_index_;
+    int width_;
+    int height_;
+
+    std::FILE* stream_;                 // YUV output
+    std::vector<uint8_t> yuv_scratch_;
+
+    std::thread writer_;
+    std::mutex mutex_;
+    std::condition_variable queue_changed_;
+    std::deque<Frame> queue_;
+    std::vector<std::vector<uint8_t>> free_buffers_;
+    size_t writing_;
+    bool stopping_;
+
+    std::atomic<uint64_t> captured_;
+    std::atomic<uint64_t> dropped_;
+};
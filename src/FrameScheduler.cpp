@@ -0,0 +1,61 @@
+#include "FrameScheduler.hpp"
+
+#include <algorithm>
+
+#include <GL/freeglut.h>
+
+
+FrameScheduler*& FrameScheduler::instance()
+{
+    static FrameScheduler* inst = nullptr;
+    return inst;
+}
+
+FrameScheduler::FrameScheduler(bool on_demand, float animation_fps) : 
+    on_demand_{ on_demand }, animation_fps_{ std::max(1.0f, animation_fps) }, 
+    pending_frames_{ 1 }, timer_pending_{ false }
+{
+    instance() = this;
+}
+
+void FrameScheduler::install()
+{
+    if (on_demand_) {
+        glutIdleFunc(nullptr);
+        glutPostRedisplay();
+    }
+    else {
+        glutIdleFunc([]() { 
+            glutPostRedisplay();
+        });
+    }
+}
+
+void FrameScheduler::invalidate(int frames)
+{
+    pending_frames_ = std::max(pending_frames_, frames);
+    if (on_demand_) { glutPostRedisplay(); }
+}
+
+int FrameScheduler::frame_interval_ms() const
+{
+    return std::max(1, static_cast<int>(1000.0f / animation_fps_));
+}
+
+void FrameScheduler::end_frame(bool animating)
+{
+    if (!on_demand_) return;
+
+    if (pending_frames_ > 0) {
+        --pending_frames_;
+        glutPostRedisplay();
+    }
+    else if (animating && !timer_pending_) {
+        timer_pending_ = true;
+        glutTimerFunc(frame_interval_ms(), [](int) {
+            instance()->timer_pending_ = false;
+            glutPostRedisplay();
+        }, 0);
+    }
+    // Otherwise nothing is posted and the GLUT loop sleeps until the next event
+}
@@ -0,0 +1,30 @@
+#pragma once
+
+
+// Decides when the next frame is drawn. In on-demand mode the GLUT loop sleeps
+// until an event invalidates the view, and animations are driven by a timer.
+class FrameScheduler
+{
+public:
+    FrameScheduler(bool on_demand, float animation_fps);
+
+    void install();
+
+    // Something changed: redraw now (ImGui needs a few frames to settle hover and layout)
+    void invalidate(int frames = 3);
+
+    // Called after each frame; animating keeps frames coming at the animation rate
+    void end_frame(bool animating);
+
+    bool on_demand() const { return on_demand_; }
+    int frame_interval_ms() const;
+
+private:
+    static FrameScheduler*& instance();
+
+private:
+    bool on_demand_;
+    float animation_fps_;
+    int pending_frames_;
+    bool timer_pending_;
+};
@@ -0,0 +1,48 @@
+#include "Frustum.hpp"
+
+
+Frustum Frustum::from_view_proj(const glm::mat4& view_proj, const glm::vec2& margin)
+{
+    // Rows of the matrix; glm stores columns
+    glm::vec4 row[4];
+    for (int i = 0; i < 4; ++i) {
+        row[i] = glm::vec4(view_proj[0][i], view_proj[1][i], view_proj[2][i], view_proj[3][i]);
+    }
+
+    // -w <= x <= w becomes -w(1 + margin) <= x <= w(1 + margin)
+    glm::vec4 wx = row[3] * (1.0f + 2.0f * margin.x);
+    glm::vec4 wy = row[3] * (1.0f + 2.0f * margin.y);
+
+    Frustum frustum;
+    frustum.planes_[0] = wx + row[0];
+    frustum.planes_[1] = wx - row[0];
+    frustum.planes_[2] = wy + row[1];
+    frustum.planes_[3] = wy - row[1];
+    frustum.planes_[4] = row[3] + row[2];
+    frustum.planes_[5] = row[3] - row[2];
+    return frustum;
+}
+
+bool Frustum::intersects(const Bounds& bounds) const
+{
+    if (bounds.empty()) { return false; }
+
+    for (const glm::vec4& plane : planes_) {
+        // Corner of the box furthest along the plane normal
+        glm::vec3 p(
+            plane.x >= 0.0f ? bounds.hi.x : bounds.lo.x,
+            plane.y >= 0.0f ? bounds.hi.y : bounds.lo.y,
+            plane.z >= 0.0f ? bounds.hi.z : bounds.lo.z
+        );
+        if (glm::dot(glm::vec3(plane), p) + plane.w < 0.0f) { return false; }
+    }
+    return true;
+}
+
+bool Frustum::contains(const glm::vec3& p) const
+{
+    for (const glm::vec4& plane : planes_) {
+        if (glm::dot(glm::vec3(plane), p) + plane.w < 0.0f) { return false; }
+    }
+    return true;
+}
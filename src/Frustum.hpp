@@ -0,0 +1,35 @@
+#pragma once
+
+#include <cfloat>
+
+#include <glm/glm.hpp>
+
+
+// Axis-aligned box; empty until extended
+struct Bounds
+{
+    glm::vec3 lo{ FLT_MAX };
+    glm::vec3 hi{ -FLT_MAX };
+
+    bool empty() const { return lo.x > hi.x; }
+    void extend(const glm::vec3& p) { lo = glm::min(lo, p); hi = glm::max(hi, p); }
+    void extend(const Bounds& b) { lo = glm::min(lo, b.lo); hi = glm::max(hi, b.hi); }
+    void pad(float amount) { lo -= glm::vec3(amount); hi += glm::vec3(amount); }
+};
+
+
+// Clip planes of a view-projection matrix, for conservative visibility tests.
+// Works for orthographic and perspective projections alike.
+class Frustum
+{
+public:
+    // margin widens the frustum by a fraction of the viewport on every side, e.g. for point sprites
+    static Frustum from_view_proj(const glm::mat4& view_proj, const glm::vec2& margin = glm::vec2(0.0f));
+
+    // False only if the box lies entirely outside one of the planes
+    bool intersects(const Bounds& bounds) const;
+    bool contains(const glm::vec3& p) const;
+
+private:
+    glm::vec4 planes_[6];     // left, right, bottom, top, near, far; inside where dot(plane, p) >= 0
+};
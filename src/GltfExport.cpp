@@ -0,0 +1,360 @@
+#include "GltfExport.hpp"
+
+#include <cmath>
+#include <cstdio>
+#include <limits>
+#include <charconv>
+#include <cstring>
+#include <numeric>
+#include <algorithm>
+
+#include "PoseLog.hpp"
+#include "ChainGeometry.hpp"
+
+
+namespace
+{
+    constexpr uint32_t glb_magic = 0x46546C67;          // "glTF"
+    constexpr uint32_t glb_version = 2;
+    constexpr uint32_t chunk_json = 0x4E4F534A;         // "JSON"
+    constexpr uint32_t chunk_bin = 0x004E4942;          // "BIN\0"
+    constexpr uint32_t component_float = 5126;
+    constexpr size_t header_size = 12 + 8;              // GLB header and the JSON chunk header
+    constexpr size_t chunk_floats = 1 << 20;            // Samples per chunk, as floats of all channels
+
+    int components(bool rotation) { return rotation ? 4 : 3; }
+}
+
+
+bool GltfWriter::open(const std::string& path)
+{
+    if (!file_.open(path)) { return false; }
+
+    // Headers are filled in by finish(), once the lengths are known
+    node_count_ = 0;
+    roots_.clear();
+    channels_.clear();
+    samples_ = 0;
+
+    static const char zeros[header_size] = {};
+    file_.write(zeros, sizeof(zeros));
+    put("{\"asset\":{\"version\":\"2.0\",\"generator\":\"Artichoke\"},\"nodes\":[");
+    return file_.ok();
+}
+
+bool GltfWriter::write_chain(const glm::vec3& root_pos, const glm::quat& root_quat, const std::vector<Joint>& joints, std::span<const Tendon> tendons)
+{
+    uint32_t base = node_count_;
+    uint64_t chain = roots_.size();
+    size_t count = joints.size();
+    if (count == 0) { return file_.ok(); }
+
+    // Tendon nodes follow the joints, grouped by bone
+    std::vector<uint32_t> order(tendons.size());
+    std::iota(order.begin(), order.end(), 0u);
+    std::stable_sort(order.begin(), order.end(), [&](uint32_t a, uint32_t b) { return tendons[a].bone_idx < tendons[b].bone_idx; });
+
+    size_t next_tendon = 0;
+    for (size_t i = 0; i < count; ++i) {
+        const Joint& joint = joints[i];
+        glm::vec3 translation = i == 0 ? root_pos : glm::vec3(0.0f, 0.0f, joints[i - 1].length);
+        glm::quat rotation = glm::normalize(i == 0 ? root_quat : joint.local_rot);
+        float t[3] = { translation.x, translation.y, translation.z };
+        float r[4] = { rotation.x, rotation.y, rotation.z, rotation.w };
+
+        put(base + i > 0 ? ",{\"name\":\"chain" : "{\"name\":\"chain");
+        put(chain);
+        put("_joint");
+        put(static_cast<uint64_t>(i));
+        put("\",\"translation\":");
+        put_floats(t, 3);
+        put(",\"rotation\":");
+        put_floats(r, 4);
+
+        // The next joint, then the tendons on this joint's bone
+        bool first = true;
+        auto child = [&](uint64_t node) {
+            put(first ? ",\"children\":[" : ",");
+            put(node);
+            first = false;
+        };
+        if (i + 1 < count) { child(base + i + 1); }
+        while (next_tendon < order.size() && tendons[order[next_tendon]].bone_idx == i) {
+            child(base + count + next_tendon);
+            ++next_tendon;
+        }
+        put(first ? "}" : "]}");
+    }
+
+    // Tendons in their bone's frame
+    for (size_t k = 0; k < order.size(); ++k) {
+        const Tendon& tendon = tendons[order[k]];
+        const Joint& joint = joints[std::min(tendon.bone_idx, count - 1)];
+        glm::vec3 local = glm::inverse(joint.rot) * (ChainGeometry::tendon_position(joints, tendon) - joint.pos);
+        float t[3] = { local.x, local.y, local.z };
+
+        put(",{\"name\":\"chain");
+        put(chain);
+        put("_tendon");
+        put(static_cast<uint64_t>(order[k]));
+        put("\",\"translation\":");
+        put_floats(t, 3);
+        put("}");
+    }
+
+    roots_.push_back(base);
+    node_count_ += static_cast<uint32_t>(count + tendons.size());
+    if (chain == 0) { animated_joints_ = count; }
+    return file_.ok();
+}
+
+bool GltfWriter::finish()
+{
+    if (!file_.is_open()) { return false; }
+
+    if (recording_ && !plan_animation()) { file_.fail(); }
+
+    put("],\"scene\":0,\"scenes\":[{\"nodes\":[");
+    for (size_t i = 0; i < roots_.size(); ++i) {
+        if (i > 0) { put(","); }
+        put(static_cast<uint64_t>(roots_[i]));
+    }
+    put("]}]");
+    if (!channels_.empty()) { write_animation_json(); }
+    put("}");
+
+    // Chunks are 4-byte aligned: JSON with blanks, binary data with zeros (floats only, so already aligned)
+    while (file_.ok() && file_.offset() % 4 != 0) { put(" "); }
+    uint32_t json_chunk[2] = { static_cast<uint32_t>(file_.offset() - header_size), chunk_json };
+
+    // Checked against the planned size, before any samples are streamed
+    uint64_t size = file_.offset() + (channels_.empty() ? 0 : 2 * sizeof(uint32_t) + bin_size_);
+    if (size > std::numeric_limits<uint32_t>::max()) {
+        std::fprintf(stderr, "%s: %llu bytes, larger than the 4 GB a glb file can hold\n", file_.path().c_str(), static_cast<unsigned long long>(size));
+        file_.discard();
+        return false;
+    }
+
+    if (!channels_.empty()) {
+        uint32_t bin_chunk[2] = { static_cast<uint32_t>(bin_size_), chunk_bin };
+        file_.write(bin_chunk, sizeof(bin_chunk));
+        if (!write_samples(file_.offset())) { file_.fail(); }
+    }
+
+    uint32_t header[3] = { glb_magic, glb_version, static_cast<uint32_t>(size) };
+    file_.write_at(0, header, sizeof(header));
+    file_.write_at(sizeof(header), json_chunk, sizeof(json_chunk));
+
+    // A partial file would not load; it is removed rather than left behind
+    if (!file_.close()) {
+        std::remove(file_.path().c_str());
+        return false;
+    }
+    return true;
+}
+
+bool GltfWriter::plan_animation()
+{
+    PosePlayer& recording = *recording_;
+    recording.rewind();
+    if (!recording.next()) { return false; }
+
+    size_t count = recording.joints().size();
+    if (count != animated_joints_) {
+        std::fprintf(stderr, "The recording has %zu joints, the chain %zu\n", count, animated_joints_);
+        return false;
+    }
+
+    // Only what changes gets a channel; the rest keeps the node's own transform
+    std::vector<Joint> initial(recording.joints().begin(), recording.joints().end());
+    glm::vec3 root_pos = recording.root_pos();
+    glm::quat root_quat = recording.root_quat();
+    std::vector<uint8_t> rotates(count, 0), moves(count, 0);
+
+    samples_ = 1;
+    first_time_ = last_time_ = sample_time(-std::numeric_limits<float>::infinity());
+    while (recording.next()) {
+        std::span<const Joint> joints = recording.joints();
+        if (joints.size() != count) {
+            std::fprintf(stderr, "The joint count changes during the recording\n");
+            return false;
+        }
+
+        ++samples_;
+        last_time_ = sample_time(last_time_);
+        moves[0] |= recording.root_pos() != root_pos;
+        rotates[0] |= recording.root_quat() != root_quat;
+        for (size_t i = 1; i < count; ++i) {
+            rotates[i] |= joints[i].local_rot != initial[i].local_rot;
+            moves[i] |= joints[i - 1].length != initial[i - 1].length;
+        }
+    }
+    if (!recording.is_open()) { return false; }
+
+    channels_.clear();
+    uint64_t offset = samples_ * sizeof(float);
+    for (uint32_t i = 0; i < count; ++i) {
+        for (bool rotation : { true, false }) {
+            if (!(rotation ? rotates[i] : moves[i])) { continue; }
+            channels_.push_back({ i, rotation, offset, 0 });
+            offset += samples_ * components(rotation) * sizeof(float);
+        }
+    }
+    bin_size_ = offset;
+    return true;
+}
+
+void GltfWriter::write_animation_json()
+{
+    put(",\"animations\":[{\"name\":\"Recording\",\"samplers\":[");
+    for (size_t c = 0; c < channels_.size(); ++c) {
+        put(c > 0 ? ",{\"input\":0,\"output\":" : "{\"input\":0,\"output\":");
+        put(static_cast<uint64_t>(c + 1));
+        put(",\"interpolation\":\"STEP\"}");
+    }
+    put("],\"channels\":[");
+    for (size_t c = 0; c < channels_.size(); ++c) {
+        put(c > 0 ? ",{\"sampler\":" : "{\"sampler\":");
+        put(static_cast<uint64_t>(c));
+        put(",\"target\":{\"node\":");
+        put(static_cast<uint64_t>(roots_[0] + channels_[c].joint));
+        put(channels_[c].rotation ? ",\"path\":\"rotation\"}}" : ",\"path\":\"translation\"}}");
+    }
+
+    // Accessor and buffer view n belong together: the times, then one per channel
+    put("]}],\"accessors\":[{\"bufferView\":0,\"componentType\":");
+    put(static_cast<uint64_t>(component_float));
+    put(",\"count\":");
+    put(samples_);
+    put(",\"type\":\"SCALAR\",\"min\":");
+    put_floats(&first_time_, 1);
+    put(",\"max\":");
+    put_floats(&last_time_, 1);
+    put("}");
+    for (size_t c = 0; c < channels_.size(); ++c) {
+        put(",{\"bufferView\":");
+        put(static_cast<uint64_t>(c + 1));
+        put(",\"componentType\":");
+        put(static_cast<uint64_t>(component_float));
+        put(",\"count\":");
+        put(samples_);
+        put(channels_[c].rotation ? ",\"type\":\"VEC4\"}" : ",\"type\":\"VEC3\"}");
+    }
+
+    put("],\"bufferViews\":[");
+    for (size_t v = 0; v <= channels_.size(); ++v) {
+        uint64_t offset = v == 0 ? 0 : channels_[v - 1].offset;
+        uint64_t length = samples_ * sizeof(float) * (v == 0 ? 1 : components(channels_[v - 1].rotation));
+        put(v > 0 ? ",{\"buffer\":0,\"byteOffset\":" : "{\"buffer\":0,\"byteOffset\":");
+        put(offset);
+        put(",\"byteLength\":");
+        put(length);
+        put("}");
+    }
+    put("],\"buffers\":[{\"byteLength\":");
+    put(bin_size_);
+    put("}]");
+}
+
+bool GltfWriter::write_samples(uint64_t bin_start)
+{
+    // As many samples per chunk as fit the budget; channels follow the times in the chunk
+    size_t floats = 1;
+    for (const Channel& channel : channels_) { floats += components(channel.rotation); }
+    chunk_samples_ = std::max<size_t>(1, chunk_floats / floats);
+
+    size_t chunk = chunk_samples_;
+    for (Channel& channel : channels_) {
+        channel.chunk = chunk;
+        chunk += chunk_samples_ * components(channel.rotation);
+    }
+    chunk_.resize(chunk);
+
+    recording_->rewind();
+    chunk_time_ = -std::numeric_limits<float>::infinity();
+    uint64_t written = 0;
+    size_t filled = 0;
+    while (recording_->next()) {
+        sample(filled);
+        if (++filled == chunk_samples_) {
+            if (!flush(bin_start, written, filled)) { return false; }
+            written += filled;
+            filled = 0;
+        }
+    }
+    if (filled > 0 && !flush(bin_start, written, filled)) { return false; }
+    written += filled;
+
+    if (written != samples_) {
+        std::fprintf(stderr, "The recording changed while exporting\n");
+        return false;
+    }
+    return true;
+}
+
+void GltfWriter::sample(size_t slot)
+{
+    const PosePlayer& recording = *recording_;
+    std::span<const Joint> joints = recording.joints();
+
+    chunk_time_ = sample_time(chunk_time_);
+    chunk_[slot] = chunk_time_;
+
+    for (const Channel& channel : channels_) {
+        float* out = &chunk_[channel.chunk + slot * components(channel.rotation)];
+        if (channel.rotation) {
+            glm::quat q = glm::normalize(channel.joint == 0 ? recording.root_quat() : joints[channel.joint].local_rot);
+            out[0] = q.x; out[1] = q.y; out[2] = q.z; out[3] = q.w;
+        }
+        else {
+            glm::vec3 t = channel.joint == 0 ? recording.root_pos() : glm::vec3(0.0f, 0.0f, joints[channel.joint - 1].length);
+            out[0] = t.x; out[1] = t.y; out[2] = t.z;
+        }
+    }
+}
+
+bool GltfWriter::flush(uint64_t bin_start, uint64_t first, size_t count)
+{
+    file_.write_at(bin_start + first * sizeof(float), chunk_.data(), count * sizeof(float));
+    for (const Channel& channel : channels_) {
+        size_t size = components(channel.rotation) * sizeof(float);
+        file_.write_at(bin_start + channel.offset + first * size, &chunk_[channel.chunk], count * size);
+    }
+    return file_.ok();
+}
+
+float GltfWriter::sample_time(float previous) const
+{
+    // glTF needs strictly increasing times; records closer than a float step are nudged apart
+    return std::max(static_cast<float>(recording_->time()), std::nextafter(previous, std::numeric_limits<float>::infinity()));
+}
+
+void GltfWriter::put(const char* text)
+{
+    file_.write(text, std::strlen(text));
+}
+
+void GltfWriter::put(float value)
+{
+    // JSON has no infinities or NaN
+    char buffer[32];
+    char* end = std::to_chars(buffer, buffer + sizeof(buffer), std::isfinite(value) ? value : 0.0f).ptr;
+    file_.write(buffer, end - buffer);
+}
+
+void GltfWriter::put(uint64_t value)
+{
+    char buffer[32];
+    char* end = std::to_chars(buffer, buffer + sizeof(buffer), value).ptr;
+    file_.write(buffer, end - buffer);
+}
+
+void GltfWriter::put_floats(const float* values, size_t count)
+{
+    put("[");
+    for (size_t i = 0; i < count; ++i) {
+        if (i > 0) { put(","); }
+        put(values[i]);
+    }
+    put("]");
+}
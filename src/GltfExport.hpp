@@ -0,0 +1,83 @@
+#pragma once
+
+#include <span>
+#include <string>
+#include <vector>
+#include <cstdint>
+
+#include <glm/glm.hpp>
+#include <glm/gtc/quaternion.hpp>
+
+#include "Main.hpp"
+#include "OutputFile.hpp"
+
+
+class PosePlayer;
+
+
+// Writes chains as a binary glTF 2.0 file (.glb). Every joint is a node whose translation is
+// its parent's bone (the root's is the root position) and whose rotation is local_rot, so the
+// node hierarchy reproduces FK. Tendons are child nodes of their bone's joint, at their
+// position in the exported pose.
+//
+// A pose recording becomes an animation of the first chain, one STEP sample per record, as a
+// recording holds each pose until the next. Sampler data is streamed into the binary chunk in
+// fixed-size chunks of samples while the recording is replayed once, so memory does not grow
+// with its length.
+class GltfWriter
+{
+public:
+    bool open(const std::string& path);
+    bool write_chain(const glm::vec3& root_pos, const glm::quat& root_quat, const std::vector<Joint>& joints, std::span<const Tendon> tendons);
+
+    // Animates the first chain, which must have the recording's joint count; written by finish()
+    void set_animation(PosePlayer* recording) { recording_ = recording; }
+
+    // Writes the animation and closes the file; false, with the file removed, if any write failed or
+    // the file would exceed the 4 GB of a glb, which is known before the samples are written
+    bool finish();
+
+private:
+    // Animated property of a node, with its data in the binary chunk
+    struct Channel
+    {
+        uint32_t joint;
+        bool rotation;              // Otherwise translation
+        uint64_t offset;            // Of its samples, from the start of the binary chunk
+        size_t chunk;               // Of its samples in the chunk
+    };
+
+    // First pass over the recording: which joints move, and the number and times of samples
+    bool plan_animation();
+    void write_animation_json();
+
+    // Second pass: samples into the chunk, each full chunk to its place in the binary chunk
+    bool write_samples(uint64_t bin_start);
+    void sample(size_t slot);
+    bool flush(uint64_t bin_start, uint64_t first, size_t count);
+    float sample_time(float previous) const;
+
+    void put(const char* text);
+    void put(float value);
+    void put(uint64_t value);
+    void put_floats(const float* values, size_t count);
+
+private:
+    OutputFile file_;
+
+    uint32_t node_count_{ 0 };
+    std::vector<uint32_t> roots_;
+    size_t animated_joints_{ 0 };   // Joints of the first chain
+
+    PosePlayer* recording_{ nullptr };
+    std::vector<Channel> channels_;
+    uint64_t samples_{ 0 };
+    uint64_t bin_size_{ 0 };
+    float first_time_{ 0.0f };
+    float last_time_{ 0.0f };
+
+    // Samples of the current chunk, per channel, with the times first
+    std::vector<float> chunk_;
+    size_t chunk_samples_{ 0 };
+    float chunk_time_{ 0.0f };      // Time of the last sample
+};
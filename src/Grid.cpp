@@ -2,13 +2,20 @@
 
 #include <vector>
 #include <iostream>
+#include <memory_resource>
 
 #include <glm/gtc/type_ptr.hpp>
 #include <glm/gtc/matrix_transform.hpp>
 
+#include "FrameArena.hpp"
 
-Grid::Grid() : gradient_shader_("res/color.vert", "res/color.frag"), grid_shader_("res/color.vert", "res/color.frag")
+
+Grid::Grid(const ShaderSource& source) :
+    quad_buffer_{ "Gradient" }, grid2d_buffer_{ "Grid 2D" }, grid3d_buffer_{ "Grid 3D" }
 {
+    gradient_shader_.load(source);
+    grid_shader_.load(source);
+
     // Create fullscreen quad for gradient
     std::vector<Vertex> quad = {
         {{0.f, 0.f, 0.f}, {0.90f, 0.90f, 0.85f}},
@@ -19,16 +26,19 @@ Grid::Grid() : gradient_shader_("res/color.vert", "res/color.frag"), grid_shader
 
     quad_buffer_.create();
     quad_buffer_.bind();
-    glBufferData(GL_ARRAY_BUFFER, quad.size() * sizeof(Vertex), quad.data(), GL_STATIC_DRAW);
+    quad_buffer_.update_data(quad.data(), quad.size() * sizeof(Vertex), GL_STATIC_DRAW);
     quad_buffer_.set_attribute(0, 3, GL_FLOAT, GL_FALSE, sizeof(Vertex), (void*)offsetof(Vertex, pos));
     quad_buffer_.set_attribute(1, 3, GL_FLOAT, GL_FALSE, sizeof(Vertex), (void*)offsetof(Vertex, color));
     quad_buffer_.unbind();
 }
 
 void Grid::create_2d_grid(int width, int height, float spacing) {
-    std::vector<Vertex> lines;
+    // Only needed until the upload
+    FrameArena::Scope scope(FrameArena::frame());
+    std::pmr::vector<Vertex> lines(&FrameArena::frame());
     float w = static_cast<float>(width);
     float h = static_cast<float>(height);
+    lines.reserve(2 * (static_cast<size_t>(w / spacing) + static_cast<size_t>(h / spacing) + 2));
 
     for (float x = fmodf(0, spacing); x < w; x += spacing) {
         lines.push_back({{x, 0, 0}, {0.71f, 0.71f, 0.67f}});
@@ -42,7 +52,7 @@ void Grid::create_2d_grid(int width, int height, float spacing) {
 
     grid2d_buffer_.create();
     grid2d_buffer_.bind();
-    glBufferData(GL_ARRAY_BUFFER, lines.size() * sizeof(Vertex), lines.data(), GL_STATIC_DRAW);
+    grid2d_buffer_.update_data(lines.data(), lines.size() * sizeof(Vertex), GL_STATIC_DRAW);
     grid2d_buffer_.set_attribute(0, 3, GL_FLOAT, GL_FALSE, sizeof(Vertex), (void*)offsetof(Vertex, pos));
     grid2d_buffer_.set_attribute(1, 3, GL_FLOAT, GL_FALSE, sizeof(Vertex), (void*)offsetof(Vertex, color));
     grid2d_buffer_.unbind();
@@ -51,8 +61,10 @@ void Grid::create_2d_grid(int width, int height, float spacing) {
 
 void Grid::create_3d_grid(float grid_size, float grid_spacing)
 {
-    std::vector<Vertex> lines;
+    FrameArena::Scope scope(FrameArena::frame());
+    std::pmr::vector<Vertex> lines(&FrameArena::frame());
     int num_lines = static_cast<int>(grid_size / grid_spacing);
+    lines.reserve(8 * (2 * num_lines + 1));
 
     for (int i = -num_lines; i <= num_lines; ++i) {
         float x = i * grid_spacing;
@@ -72,14 +84,17 @@ void Grid::create_3d_grid(float grid_size, float grid_spacing)
 
     grid3d_buffer_.create();
     grid3d_buffer_.bind();
-    glBufferData(GL_ARRAY_BUFFER, lines.size() * sizeof(Vertex), lines.data(), GL_STATIC_DRAW);
+    grid3d_buffer_.update_data(lines.data(), lines.size() * sizeof(Vertex), GL_STATIC_DRAW);
     grid3d_buffer_.set_attribute(0, 3, GL_FLOAT, GL_FALSE, sizeof(Vertex), (void*)offsetof(Vertex, pos));
     grid3d_buffer_.set_attribute(1, 3, GL_FLOAT, GL_FALSE, sizeof(Vertex), (void*)offsetof(Vertex, color));
     grid3d_buffer_.unbind();
     grid3d_vertex_count_ = static_cast<int>(lines.size());
 }
 
-void Grid::draw_2d(const Camera& camera, int width, int height) {
+void Grid::draw_2d(const Camera& camera) {
+    int width = camera.viewport_width();
+    int height = camera.viewport_height();
+
     // Draw gradient
     gradient_shader_.use();
     glm::mat4 proj = glm::ortho(0.f, 1.f, 0.f, 1.f); // This is fine for the quad
@@ -89,8 +104,10 @@ void Grid::draw_2d(const Camera& camera, int width, int height) {
     quad_buffer_.unbind();
 
     // Draw grid lines
-    if (grid2d_vertex_count_ == 0) {
+    if (grid2d_vertex_count_ == 0 || grid2d_width_ != width || grid2d_height_ != height) {
         create_2d_grid(width, height, 50.0f);
+        grid2d_width_ = width;
+        grid2d_height_ = height;
     }
 
     grid_shader_.use();
@@ -102,14 +119,13 @@ void Grid::draw_2d(const Camera& camera, int width, int height) {
     grid2d_buffer_.unbind();
 }
 
-void Grid::draw_3d(const Camera& camera, int width, int height) {
+void Grid::draw_3d(const Camera& camera) {
     if (grid3d_vertex_count_ == 0) {
         create_3d_grid(1000.0f, 100.0f);
     }
 
     grid_shader_.use();
-    glm::mat4 mvp = camera.get_proj(float(width) / height) * camera.get_view();
-    grid_shader_.setUniform("uMVP", mvp);
+    grid_shader_.setUniform("uMVP", camera.get_view_proj());
     grid3d_buffer_.bind();
     glDrawArrays(GL_LINES, 0, grid3d_vertex_count_);
     grid3d_buffer_.unbind();
@@ -11,10 +11,11 @@
 
 class Grid {
 public:
-    Grid();
+    explicit Grid(const ShaderSource& source);
 
-    void draw_2d(const Camera& camera, int width, int height);
-    void draw_3d(const Camera& camera, int width, int height);
+    // Both draw over the camera's viewport
+    void draw_2d(const Camera& camera);
+    void draw_3d(const Camera& camera);
 
 private:
     void create_gradient_quad();
@@ -28,5 +29,7 @@ private:
     Shader grid_shader_;
 
     int grid2d_vertex_count_ = 0;
+    int grid2d_width_ = 0;
+    int grid2d_height_ = 0;
     int grid3d_vertex_count_ = 0;
 };
\ No newline at end of file
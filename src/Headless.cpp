@@ -0,0 +1,160 @@
+#include "Headless.hpp"
+
+#include <cstdio>
+#include <cstring>
+
+#ifdef ARTICHOKE_HEADLESS
+#include <EGL/egl.h>
+#include <EGL/eglext.h>
+#endif
+
+
+Headless::Headless(int width, int height) : 
+    width_{ width }, height_{ height }, display_{ nullptr }, context_{ nullptr }, 
+    fbo_{ 0 }, color_{ 0 }, depth_{ 0 }, resolve_fbo_{ 0 }, resolve_color_{ 0 }
+{
+}
+
+Headless::~Headless()
+{
+    if (fbo_) { glDeleteFramebuffers(1, &fbo_); }
+    if (resolve_fbo_) { glDeleteFramebuffers(1, &resolve_fbo_); }
+    if (color_) { glDeleteRenderbuffers(1, &color_); }
+    if (depth_) { glDeleteRenderbuffers(1, &depth_); }
+    if (resolve_color_) { glDeleteRenderbuffers(1, &resolve_color_); }
+
+#ifdef ARTICHOKE_HEADLESS
+    if (display_) {
+        eglMakeCurrent(display_, EGL_NO_SURFACE, EGL_NO_SURFACE, EGL_NO_CONTEXT);
+        if (context_) { eglDestroyContext(display_, context_); }
+        eglTerminate(display_);
+    }
+#endif
+}
+
+bool Headless::create_context()
+{
+#ifdef ARTICHOKE_HEADLESS
+    // Prefer Mesa's surfaceless platform, which needs neither X11 nor a GPU
+    EGLDisplay display = EGL_NO_DISPLAY;
+    const char* extensions = eglQueryString(EGL_NO_DISPLAY, EGL_EXTENSIONS);
+    auto get_platform_display = reinterpret_cast<PFNEGLGETPLATFORMDISPLAYEXTPROC>(eglGetProcAddress("eglGetPlatformDisplayEXT"));
+
+    if (extensions && get_platform_display && std::strstr(extensions, "EGL_MESA_platform_surfaceless")) {
+        display = get_platform_display(EGL_PLATFORM_SURFACELESS_MESA, EGL_DEFAULT_DISPLAY, nullptr);
+    }
+    if (display == EGL_NO_DISPLAY) {
+        display = eglGetDisplay(EGL_DEFAULT_DISPLAY);
+    }
+
+    EGLint major = 0, minor = 0;
+    if (display == EGL_NO_DISPLAY || !eglInitialize(display, &major, &minor)) {
+        std::fprintf(stderr, "EGL initialization failed (0x%x)\n", eglGetError());
+        return false;
+    }
+    display_ = display;
+
+    if (!eglBindAPI(EGL_OPENGL_API)) {
+        std::fprintf(stderr, "EGL does not support desktop OpenGL\n");
+        return false;
+    }
+
+    const EGLint config_attribs[] = {
+        EGL_RENDERABLE_TYPE, EGL_OPENGL_BIT,
+        EGL_NONE
+    };
+
+    EGLConfig config = nullptr;
+    EGLint config_count = 0;
+    eglChooseConfig(display, config_attribs, &config, 1, &config_count);
+
+    // Same profile as the GLUT window: 3.3 compatibility (wide lines and points)
+    const EGLint context_attribs[] = {
+        EGL_CONTEXT_MAJOR_VERSION, 3,
+        EGL_CONTEXT_MINOR_VERSION, 3,
+        EGL_CONTEXT_OPENGL_PROFILE_MASK, EGL_CONTEXT_OPENGL_COMPATIBILITY_PROFILE_BIT,
+        EGL_NONE
+    };
+
+    // Without configs (surfaceless), the context is created config-less
+    EGLContext context = eglCreateContext(display, config_count > 0 ? config : EGL_NO_CONFIG_KHR, EGL_NO_CONTEXT, context_attribs);
+    if (context == EGL_NO_CONTEXT) {
+        std::fprintf(stderr, "EGL context creation failed (0x%x)\n", eglGetError());
+        return false;
+    }
+    context_ = context;
+
+    if (!eglMakeCurrent(display, EGL_NO_SURFACE, EGL_NO_SURFACE, context)) {
+        std::fprintf(stderr, "EGL make current failed (0x%x)\n", eglGetError());
+        return false;
+    }
+
+    std::fprintf(stderr, "Headless: EGL %d.%d\n", major, minor);
+    return true;
+#else
+    std::fprintf(stderr, "Headless rendering is not available: built without EGL\n");
+    return false;
+#endif
+}
+
+bool Headless::create_framebuffer()
+{
+    std::fprintf(stderr, "Headless: %s (%s)\n", glGetString(GL_RENDERER), glGetString(GL_VERSION));
+
+    GLint max_samples = 0;
+    glGetIntegerv(GL_MAX_SAMPLES, &max_samples);
+    GLsizei samples = max_samples < 4 ? max_samples : 4;
+
+    // Multisampled target, matching the window's 4x MSAA
+    glGenRenderbuffers(1, &color_);
+    glBindRenderbuffer(GL_RENDERBUFFER, color_);
+    glRenderbufferStorageMultisample(GL_RENDERBUFFER, samples, GL_RGBA8, width_, height_);
+
+    glGenRenderbuffers(1, &depth_);
+    glBindRenderbuffer(GL_RENDERBUFFER, depth_);
+    glRenderbufferStorageMultisample(GL_RENDERBUFFER, samples, GL_DEPTH24_STENCIL8, width_, height_);
+
+    glGenFramebuffers(1, &fbo_);
+    glBindFramebuffer(GL_FRAMEBUFFER, fbo_);
+    glFramebufferRenderbuffer(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_RENDERBUFFER, color_);
+    glFramebufferRenderbuffer(GL_FRAMEBUFFER, GL_DEPTH_STENCIL_ATTACHMENT, GL_RENDERBUFFER, depth_);
+
+    if (glCheckFramebufferStatus(GL_FRAMEBUFFER) != GL_FRAMEBUFFER_COMPLETE) {
+        std::fprintf(stderr, "Headless framebuffer is incomplete\n");
+        return false;
+    }
+
+    // Single-sampled copy that frames are resolved into
+    glGenRenderbuffers(1, &resolve_color_);
+    glBindRenderbuffer(GL_RENDERBUFFER, resolve_color_);
+    glRenderbufferStorage(GL_RENDERBUFFER, GL_RGBA8, width_, height_);
+
+    glGenFramebuffers(1, &resolve_fbo_);
+    glBindFramebuffer(GL_FRAMEBUFFER, resolve_fbo_);
+    glFramebufferRenderbuffer(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_RENDERBUFFER, resolve_color_);
+
+    if (glCheckFramebufferStatus(GL_FRAMEBUFFER) != GL_FRAMEBUFFER_COMPLETE) {
+        std::fprintf(stderr, "Headless resolve framebuffer is incomplete\n");
+        return false;
+    }
+
+    glBindRenderbuffer(GL_RENDERBUFFER, 0);
+    bind();
+    return true;
+}
+
+void Headless::bind() const
+{
+    glBindFramebuffer(GL_FRAMEBUFFER, fbo_);
+    glViewport(0, 0, width_, height_);
+}
+
+void Headless::present()
+{
+    glBindFramebuffer(GL_READ_FRAMEBUFFER, fbo_);
+    glBindFramebuffer(GL_DRAW_FRAMEBUFFER, resolve_fbo_);
+    glBlitFramebuffer(0, 0, width_, height_, 0, 0, width_, height_, GL_COLOR_BUFFER_BIT, GL_NEAREST);
+    glFinish();
+
+    bind();
+}
@@ -0,0 +1,43 @@
+#pragma once
+
+#include <GL/glew.h>
+
+
+// Offscreen GL context without a window system: EGL (surfaceless on Mesa, so it runs on
+// the software rasterizer on machines without a display or GPU) rendering into an FBO.
+// Available when built with EGL (ARTICHOKE_HEADLESS).
+class Headless
+{
+public:
+    Headless(int width, int height);
+    ~Headless();
+
+    // Creates the context and makes it current; the framebuffer needs GLEW (create_framebuffer)
+    bool create_context();
+    bool create_framebuffer();
+
+    // Binds the multisampled render target
+    void bind() const;
+
+    // Resolves the frame into the single-sampled buffer and waits for it
+    void present();
+
+    int width() const { return width_; }
+    int height() const { return height_; }
+
+    // Single-sampled framebuffer holding the last presented frame
+    GLuint resolved_framebuffer() const { return resolve_fbo_; }
+
+private:
+    int width_;
+    int height_;
+
+    void* display_;         // EGLDisplay
+    void* context_;         // EGLContext
+
+    GLuint fbo_;
+    GLuint color_;
+    GLuint depth_;
+    GLuint resolve_fbo_;
+    GLuint resolve_color_;
+};
@@ -0,0 +1,194 @@
+#include "ImageWriter.hpp"
+
+#include <array>
+#include <memory>
+#include <algorithm>
+
+
+namespace
+{
+    struct FileCloser
+    {
+        void operator()(std::FILE* file) const { std::fclose(file); }
+    };
+    using File = std::unique_ptr<std::FILE, FileCloser>;
+
+    void put_u32(std::vector<uint8_t>& out, uint32_t value)
+    {
+        out.push_back(static_cast<uint8_t>(value >> 24));
+        out.push_back(static_cast<uint8_t>(value >> 16));
+        out.push_back(static_cast<uint8_t>(value >> 8));
+        out.push_back(static_cast<uint8_t>(value));
+    }
+
+    void put_chunk(std::vector<uint8_t>& out, const char* type, const uint8_t* data, size_t size)
+    {
+        put_u32(out, static_cast<uint32_t>(size));
+        size_t start = out.size();
+        out.insert(out.end(), type, type + 4);
+        out.insert(out.end(), data, data + size);
+        put_u32(out, ImageWriter::crc32(out.data() + start, size + 4));
+    }
+
+    // BT.601 limited range
+    inline uint8_t luma(const uint8_t* p)
+    {
+        return static_cast<uint8_t>((66 * p[0] + 129 * p[1] + 25 * p[2] + 128) / 256 + 16);
+    }
+}
+
+
+bool ImageWriter::write_ppm(const std::string& path, int width, int height, const uint8_t* rgba)
+{
+    File file(std::fopen(path.c_str(), "wb"));
+    if (!file) return false;
+
+    std::fprintf(file.get(), "P6\n%d %d\n255\n", width, height);
+
+    std::vector<uint8_t> row(static_cast<size_t>(width) * 3);
+    for (int y = height - 1; y >= 0; --y) {
+        const uint8_t* src = rgba + static_cast<size_t>(y) * width * 4;
+        for (int x = 0; x < width; ++x) {
+            row[x * 3 + 0] = src[x * 4 + 0];
+            row[x * 3 + 1] = src[x * 4 + 1];
+            row[x * 3 + 2] = src[x * 4 + 2];
+        }
+        if (std::fwrite(row.data(), 1, row.size(), file.get()) != row.size()) return false;
+    }
+    return true;
+}
+
+bool ImageWriter::write_png(const std::string& path, int width, int height, const uint8_t* rgba)
+{
+    // Raw scanlines: filter byte (none) followed by RGB, top row first
+    size_t stride = static_cast<size_t>(width) * 3 + 1;
+    std::vector<uint8_t> raw(stride * height);
+    for (int y = 0; y < height; ++y) {
+        const uint8_t* src = rgba + static_cast<size_t>(height - 1 - y) * width * 4;
+        uint8_t* dst = &raw[y * stride];
+        dst[0] = 0;
+        for (int x = 0; x < width; ++x) {
+            dst[1 + x * 3 + 0] = src[x * 4 + 0];
+            dst[1 + x * 3 + 1] = src[x * 4 + 1];
+            dst[1 + x * 3 + 2] = src[x * 4 + 2];
+        }
+    }
+
+    // zlib stream of stored deflate blocks (at most 65535 bytes each)
+    std::vector<uint8_t> zlib;
+    zlib.reserve(raw.size() + raw.size() / 65535 * 5 + 16);
+    zlib.push_back(0x78);
+    zlib.push_back(0x01);
+    for (size_t offset = 0; offset < raw.size() || offset == 0; ) {
+        size_t size = std::min<size_t>(raw.size() - offset, 65535);
+        bool last = offset + size == raw.size();
+        zlib.push_back(last ? 1 : 0);
+        zlib.push_back(static_cast<uint8_t>(size));
+        zlib.push_back(static_cast<uint8_t>(size >> 8));
+        zlib.push_back(static_cast<uint8_t>(~size));
+        zlib.push_back(static_cast<uint8_t>(~size >> 8));
+        zlib.insert(zlib.end(), raw.begin() + offset, raw.begin() + offset + size);
+        offset += size;
+        if (last) break;
+    }
+    put_u32(zlib, adler32(raw.data(), raw.size()));
+
+    std::vector<uint8_t> png = { 0x89, 'P', 'N', 'G', '\r', '\n', 0x1a, '\n' };
+    png.reserve(zlib.size() + 64);
+
+    std::vector<uint8_t> header;
+    put_u32(header, static_cast<uint32_t>(width));
+    put_u32(header, static_cast<uint32_t>(height));
+    header.insert(header.end(), { 8, 2, 0, 0, 0 });    // 8-bit RGB, no interlace
+
+    put_chunk(png, "IHDR", header.data(), header.size());
+    put_chunk(png, "IDAT", zlib.data(), zlib.size());
+    put_chunk(png, "IEND", nullptr, 0);
+
+    File file(std::fopen(path.c_str(), "wb"));
+    if (!file) return false;
+    return std::fwrite(png.data(), 1, png.size(), file.get()) == png.size();
+}
+
+bool ImageWriter::write_i420(std::FILE* file, int width, int height, const uint8_t* rgba, std::vector<uint8_t>& scratch)
+{
+    int chroma_w = (width + 1) / 2;
+    int chroma_h = (height + 1) / 2;
+    size_t luma_size = static_cast<size_t>(width) * height;
+    size_t chroma_size = static_cast<size_t>(chroma_w) * chroma_h;
+
+    scratch.resize(luma_size + chroma_size * 2);
+    uint8_t* y_plane = scratch.data();
+    uint8_t* u_plane = y_plane + luma_size;
+    uint8_t* v_plane = u_plane + chroma_size;
+
+    auto pixel = [&](int x, int y) {
+        x = std::min(x, width - 1);
+        y = std::min(y, height - 1);
+        return rgba + (static_cast<size_t>(height - 1 - y) * width + x) * 4;
+    };
+
+    for (int y = 0; y < height; ++y) {
+        for (int x = 0; x < width; ++x) {
+            y_plane[static_cast<size_t>(y) * width + x] = luma(pixel(x, y));
+        }
+    }
+
+    // Chroma from the average of each 2x2 block
+    for (int y = 0; y < chroma_h; ++y) {
+        for (int x = 0; x < chroma_w; ++x) {
+            int r = 0, g = 0, b = 0;
+            for (int i = 0; i < 4; ++i) {
+                const uint8_t* p = pixel(x * 2 + (i & 1), y * 2 + (i >> 1));
+                r += p[0];
+                g += p[1];
+                b += p[2];
+            }
+            r /= 4; g /= 4; b /= 4;
+            u_plane[static_cast<size_t>(y) * chroma_w + x] = static_cast<uint8_t>((-38 * r - 74 * g + 112 * b + 128) / 256 + 128);
+            v_plane[static_cast<size_t>(y) * chroma_w + x] = static_cast<uint8_t>((112 * r - 94 * g - 18 * b + 128) / 256 + 128);
+        }
+    }
+
+    return std::fwrite(scratch.data(), 1, scratch.size(), file) == scratch.size();
+}
+
+uint32_t ImageWriter::crc32(const uint8_t* data, size_t size, uint32_t crc)
+{
+    static const std::array<uint32_t, 256> table = [] {
+        std::array<uint32_t, 256> t{};
+        for (uint32_t n = 0; n < 256; ++n) {
+            uint32_t c = n;
+            for (int k = 0; k < 8; ++k) {
+                c = (c & 1) ? 0xedb88320u ^ (c >> 1) : c >> 1;
+            }
+            t[n] = c;
+        }
+        return t;
+    }();
+
+    crc = ~crc;
+    for (size_t i = 0; i < size; ++i) {
+        crc = table[(crc ^ data[i]) & 0xff] ^ (crc >> 8);
+    }
+    return ~crc;
+}
+
+uint32_t ImageWriter::adler32(const uint8_t* data, size_t size, uint32_t adler)
+{
+    uint32_t a = adler & 0xffff;
+    uint32_t b = adler >> 16;
+
+    // Sums fit in 32 bits for 5552 bytes between reductions
+    while (size > 0) {
+        size_t block = std::min<size_t>(size, 5552);
+        size -= block;
+        for (size_t i = 0; i < block; ++i) {
+            a += *data++;
+            b += a;
+        }
+        a %= 65521;
+        b %= 65521;
+    }
+    return (b << 16) | a;
+}
@@ -0,0 +1,24 @@
+#pragma once
+
+#include <cstdio>
+#include <string>
+#include <vector>
+#include <cstdint>
+
+
+// Image encoders for captured frames. Input is tightly packed RGBA8 with the first row
+// at the bottom, as read back from OpenGL.
+class ImageWriter
+{
+public:
+    static bool write_ppm(const std::string& path, int width, int height, const uint8_t* rgba);
+
+    // Uncompressed (stored deflate) PNG: fast to write, no zlib dependency
+    static bool write_png(const std::string& path, int width, int height, const uint8_t* rgba);
+
+    // Appends one planar YUV 4:2:0 (I420, BT.601 limited range) frame, e.g. for piping into ffmpeg
+    static bool write_i420(std::FILE* file, int width, int height, const uint8_t* rgba, std::vector<uint8_t>& scratch);
+
+    static uint32_t crc32(const uint8_t* data, size_t size, uint32_t crc = 0);
+    static uint32_t adler32(const uint8_t* data, size_t size, uint32_t adler = 1);
+};
@@ -1,6 +1,7 @@
 #include "Input.hpp"
 
 #include <vector>
+#include <algorithm>
 #include <imgui.h>
 
 
@@ -37,7 +38,8 @@ void Input::update()
     display_size_ = glm::vec2(io.DisplaySize.x, io.DisplaySize.y);
 
     // Store delta time for use in camera animation, etc.
-    delta_time_ = io.DeltaTime;
+    // Clamped, since frames are not drawn while idle in on-demand mode
+    delta_time_ = std::min(io.DeltaTime, 0.1f);
 }
 
 bool Input::key_down(ImGuiKey key) const
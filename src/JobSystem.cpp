@@ -0,0 +1,377 @@
+#include "JobSystem.hpp"
+
+#include <chrono>
+#include <string>
+#include <algorithm>
+
+#include "Trace.hpp"
+#include "MemoryTracker.hpp"
+
+
+struct JobSystem::Job
+{
+    const char* name;
+    std::function<void()> fn;
+    MemoryTag tag = MemoryTag::Other;   // Subsystem of the submitting thread
+
+    // parallel_for chunk, run instead of fn
+    RangeFn range = nullptr;
+    const void* context = nullptr;
+    size_t begin = 0;
+    size_t end = 0;
+
+    std::atomic<int> pending{ 1 };      // Unfinished dependencies, plus one while being submitted
+    std::mutex mutex;
+    bool done = false;
+    std::vector<Handle> continuations;
+    std::condition_variable finished;
+};
+
+namespace
+{
+    thread_local size_t worker_index = 0;    // 0 for threads outside the pool
+
+    int configured_workers = -1;
+
+    // Recycled job records; only blocks of one size (the shared_ptr control block) are kept
+    struct JobPool
+    {
+        std::mutex mutex;
+        std::vector<void*> blocks;
+        size_t block_size = 0;
+    };
+
+    // Never destroyed: handles may outlive the job system at exit
+    JobPool& job_pool()
+    {
+        static JobPool* pool = new JobPool();
+        return *pool;
+    }
+
+    template <typename T>
+    struct JobAllocator
+    {
+        using value_type = T;
+
+        JobAllocator() = default;
+        template <typename U> JobAllocator(const JobAllocator<U>&) {}
+
+        T* allocate(size_t n)
+        {
+            JobPool& pool = job_pool();
+            if (n == 1) {
+                std::lock_guard<std::mutex> lock(pool.mutex);
+                if (pool.block_size == 0) { pool.block_size = sizeof(T); }
+                if (pool.block_size == sizeof(T) && !pool.blocks.empty()) {
+                    void* block = pool.blocks.back();
+                    pool.blocks.pop_back();
+                    return static_cast<T*>(block);
+                }
+            }
+            return static_cast<T*>(::operator new(n * sizeof(T)));
+        }
+
+        void deallocate(T* p, size_t n)
+        {
+            JobPool& pool = job_pool();
+            if (n == 1) {
+                std::lock_guard<std::mutex> lock(pool.mutex);
+                if (pool.block_size == sizeof(T)) {
+                    pool.blocks.push_back(p);
+                    return;
+                }
+            }
+            ::operator delete(p);
+        }
+
+        template <typename U> bool operator==(const JobAllocator<U>&) const { return true; }
+        template <typename U> bool operator!=(const JobAllocator<U>&) const { return false; }
+    };
+}
+
+
+JobSystem::JobSystem(size_t workers)
+{
+    queues_.resize(workers + 1);
+    for (auto& queue : queues_) {
+        queue = std::make_unique<Queue>();
+    }
+
+    for (size_t i = 0; i < workers; ++i) {
+        workers_.emplace_back(&JobSystem::worker_main, this, i + 1);
+    }
+}
+
+JobSystem::~JobSystem()
+{
+    {
+        std::lock_guard<std::mutex> lock(sleep_mutex_);
+        stopping_ = true;
+    }
+    sleep_.notify_all();
+
+    for (auto& worker : workers_) {
+        worker.join();
+    }
+}
+
+JobSystem& JobSystem::instance()
+{
+    static JobSystem system([] {
+        if (configured_workers >= 0) {
+            return static_cast<size_t>(configured_workers);
+        }
+        // The calling thread helps, so leave one core for it
+        unsigned int cores = std::thread::hardware_concurrency();
+        return static_cast<size_t>(cores > 1 ? cores - 1 : 0);
+    }());
+    return system;
+}
+
+void JobSystem::configure(int workers)
+{
+    configured_workers = workers;
+}
+
+JobSystem::Handle JobSystem::make_job(const char* name)
+{
+    Handle job = std::allocate_shared<Job>(JobAllocator<Job>());
+    job->name = name;
+    job->tag = MemoryTracker::current_tag();
+    return job;
+}
+
+JobSystem::Handle JobSystem::submit(const char* name, std::function<void()> fn, std::initializer_list<Handle> deps)
+{
+    Handle job = make_job(name);
+    job->fn = std::move(fn);
+
+    for (const Handle& dep : deps) {
+        if (!dep) continue;
+
+        std::lock_guard<std::mutex> lock(dep->mutex);
+        if (!dep->done) {
+            job->pending.fetch_add(1);
+            dep->continuations.push_back(job);
+        }
+    }
+
+    // Drop the submission guard; the last finished dependency queues the job otherwise
+    if (job->pending.fetch_sub(1) == 1) {
+        push(job);
+    }
+    return job;
+}
+
+void JobSystem::wait(const Handle& job)
+{
+    if (!job) return;
+
+    size_t own = queue_index();
+    while (true) {
+        {
+            std::lock_guard<std::mutex> lock(job->mutex);
+            if (job->done) return;
+        }
+
+        if (!run_one(own)) {
+            // Nothing to help with: the job is running elsewhere
+            std::unique_lock<std::mutex> lock(job->mutex);
+            job->finished.wait_for(lock, std::chrono::microseconds(200), [&] { return job->done; });
+        }
+    }
+}
+
+void JobSystem::run_range(const char* name, size_t count, size_t grain, RangeFn fn, const void* context)
+{
+    if (count == 0) return;
+
+    grain = std::max<size_t>(grain, 1);
+    size_t chunks = std::min({ (count + grain - 1) / grain, (workers_.size() + 1) * 4, max_chunks });
+
+    if (chunks <= 1 || workers_.empty()) {
+        Trace::Scope trace(name);
+        auto start = std::chrono::steady_clock::now();
+        fn(context, 0, count);
+        record(name, std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count());
+        return;
+    }
+
+    Handle jobs[max_chunks];
+    size_t submitted = 0;
+
+    size_t step = (count + chunks - 1) / chunks;
+    for (size_t begin = 0; begin < count; begin += step) {
+        Handle job = make_job(name);
+        job->range = fn;
+        job->context = context;
+        job->begin = begin;
+        job->end = std::min(begin + step, count);
+        job->pending.store(0, std::memory_order_relaxed);
+        push(job);
+        jobs[submitted++] = std::move(job);
+    }
+
+    for (size_t i = 0; i < submitted; ++i) {
+        wait(jobs[i]);
+    }
+}
+
+void JobSystem::collect_stats(std::vector<TaskStats>& out)
+{
+    out.clear();
+
+    size_t count = timing_count_.load(std::memory_order_acquire);
+    for (size_t i = 0; i < count; ++i) {
+        Timing& timing = timings_[i];
+        uint32_t runs = timing.count.exchange(0, std::memory_order_relaxed);
+        uint64_t ns = timing.ns.exchange(0, std::memory_order_relaxed);
+        out.push_back({ timing.name, ns / 1e6, runs });
+    }
+}
+
+bool JobSystem::run_one(size_t queue)
+{
+    Handle job;
+
+    // Own work first, newest job (still warm in cache)
+    {
+        Queue& own = *queues_[queue];
+        std::lock_guard<std::mutex> lock(own.mutex);
+        job = own.pop_back();
+    }
+
+    // Otherwise steal the oldest job of another queue
+    for (size_t i = 1; !job && i < queues_.size(); ++i) {
+        Queue& victim = *queues_[(queue + i) % queues_.size()];
+        std::lock_guard<std::mutex> lock(victim.mutex);
+        job = victim.pop_front();
+    }
+
+    if (!job) return false;
+
+    queued_.fetch_sub(1, std::memory_order_relaxed);
+    execute(job);
+    return true;
+}
+
+void JobSystem::push(const Handle& job)
+{
+    {
+        Queue& queue = *queues_[queue_index()];
+        std::lock_guard<std::mutex> lock(queue.mutex);
+        queue.push_back(job);
+    }
+
+    {
+        std::lock_guard<std::mutex> lock(sleep_mutex_);
+        queued_.fetch_add(1, std::memory_order_relaxed);
+    }
+    sleep_.notify_one();
+}
+
+void JobSystem::execute(const Handle& job)
+{
+    auto start = std::chrono::steady_clock::now();
+    {
+        Trace::Scope trace(job->name);
+        MemoryTracker::Scope memory(job->tag);
+        if (job->range) { job->range(job->context, job->begin, job->end); }
+        else { job->fn(); }
+    }
+    record(job->name, std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count());
+
+    std::vector<Handle> continuations;
+    {
+        std::lock_guard<std::mutex> lock(job->mutex);
+        job->done = true;
+        job->fn = nullptr;
+        continuations.swap(job->continuations);
+    }
+    job->finished.notify_all();
+
+    for (const Handle& next : continuations) {
+        if (next->pending.fetch_sub(1) == 1) {
+            push(next);
+        }
+    }
+}
+
+void JobSystem::worker_main(size_t index)
+{
+    worker_index = index;
+    Trace::set_thread_name("Job worker " + std::to_string(index));
+
+    while (true) {
+        if (run_one(index)) continue;
+
+        std::unique_lock<std::mutex> lock(sleep_mutex_);
+        sleep_.wait(lock, [this] { return stopping_ || queued_.load(std::memory_order_relaxed) > 0; });
+        if (stopping_) return;
+    }
+}
+
+void JobSystem::record(const char* name, double ms)
+{
+    if (!name) return;
+
+    // Task names are string literals, so pointers identify them
+    size_t count = timing_count_.load(std::memory_order_acquire);
+    Timing* timing = nullptr;
+    for (size_t i = 0; i < count && !timing; ++i) {
+        if (timings_[i].name == name) timing = &timings_[i];
+    }
+
+    if (!timing) {
+        std::lock_guard<std::mutex> lock(timing_mutex_);
+        count = timing_count_.load(std::memory_order_relaxed);
+        for (size_t i = 0; i < count && !timing; ++i) {
+            if (timings_[i].name == name) timing = &timings_[i];
+        }
+        if (!timing) {
+            if (count == max_timings) return;
+            timing = &timings_[count];
+            timing->name = name;
+            timing_count_.store(count + 1, std::memory_order_release);
+        }
+    }
+
+    timing->ns.fetch_add(static_cast<uint64_t>(ms * 1e6), std::memory_order_relaxed);
+    timing->count.fetch_add(1, std::memory_order_relaxed);
+}
+
+void JobSystem::Queue::push_back(Handle job)
+{
+    if (size == ring.size()) {
+        // Unroll into a ring twice the size
+        std::vector<Handle> grown(std::max<size_t>(16, ring.size() * 2));
+        for (size_t i = 0; i < size; ++i) {
+            grown[i] = std::move(ring[(head + i) % ring.size()]);
+        }
+        ring.swap(grown);
+        head = 0;
+    }
+    ring[(head + size) % ring.size()] = std::move(job);
+    ++size;
+}
+
+JobSystem::Handle JobSystem::Queue::pop_back()
+{
+    if (size == 0) return nullptr;
+    --size;
+    return std::move(ring[(head + size) % ring.size()]);
+}
+
+JobSystem::Handle JobSystem::Queue::pop_front()
+{
+    if (size == 0) return nullptr;
+    Handle job = std::move(ring[head]);
+    head = (head + 1) % ring.size();
+    --size;
+    return job;
+}
+
+size_t JobSystem::queue_index() const
+{
+    return worker_index < queues_.size() ? worker_index : 0;
+}
@@ -0,0 +1,103 @@
+#pragma once
+
+#include <mutex>
+#include <atomic>
+#include <memory>
+#include <thread>
+#include <vector>
+#include <cstdint>
+#include <functional>
+#include <condition_variable>
+
+
+// Small work-stealing task scheduler. Every worker owns a deque: it pushes and pops
+// its own jobs at the back and steals from the front of the others. Threads that
+// wait for a job help run queued work instead of blocking.
+class JobSystem
+{
+public:
+    struct Job;
+    using Handle = std::shared_ptr<Job>;
+
+    struct TaskStats
+    {
+        const char* name;
+        double ms;              // Accumulated over the last collected interval
+        uint32_t count;
+    };
+
+    explicit JobSystem(size_t workers);
+    ~JobSystem();
+
+    // Shared instance, created on first use with configure()'s worker count
+    static JobSystem& instance();
+    static void configure(int workers);
+
+    // Runs fn once all dependencies have finished
+    Handle submit(const char* name, std::function<void()> fn, std::initializer_list<Handle> deps = {});
+    void wait(const Handle& job);
+
+    // Splits [0, count) into chunks of at least grain items and runs them in parallel.
+    // Small ranges run inline on the calling thread. Does not allocate once warmed up.
+    template <typename Fn>
+    void parallel_for(const char* name, size_t count, size_t grain, const Fn& fn)
+    {
+        run_range(name, count, grain, [](const void* context, size_t begin, size_t end) {
+            (*static_cast<const Fn*>(context))(begin, end);
+        }, &fn);
+    }
+
+    size_t worker_count() const { return workers_.size(); }
+
+    // Per-task timings since the last call (main thread)
+    void collect_stats(std::vector<TaskStats>& out);
+
+private:
+    using RangeFn = void (*)(const void* context, size_t begin, size_t end);
+
+    void run_range(const char* name, size_t count, size_t grain, RangeFn fn, const void* context);
+    Handle make_job(const char* name);
+    bool run_one(size_t queue);
+    void push(const Handle& job);
+    void execute(const Handle& job);
+    void worker_main(size_t index);
+    void record(const char* name, double ms);
+    size_t queue_index() const;
+
+private:
+    // Ring of jobs; it only grows, so steady-state pushes do not allocate
+    struct Queue
+    {
+        std::mutex mutex;
+        std::vector<Handle> ring;
+        size_t head = 0;
+        size_t size = 0;
+
+        void push_back(Handle job);
+        Handle pop_back();
+        Handle pop_front();
+    };
+
+    // Upper bound on the chunks of one parallel_for
+    static constexpr size_t max_chunks = 64;
+
+    struct Timing
+    {
+        const char* name;
+        std::atomic<uint64_t> ns{ 0 };
+        std::atomic<uint32_t> count{ 0 };
+    };
+
+    std::vector<std::thread> workers_;
+    std::vector<std::unique_ptr<Queue>> queues_;    // [0] is shared by non-worker threads
+
+    std::mutex sleep_mutex_;
+    std::condition_variable sleep_;
+    std::atomic<int64_t> queued_{ 0 };
+    std::atomic<bool> stopping_{ false };
+
+    static constexpr size_t max_timings = 32;
+    std::mutex timing_mutex_;
+    std::atomic<size_t> timing_count_{ 0 };
+    Timing timings_[max_timings];
+};
@@ -0,0 +1,294 @@
+#include "JointSeries.hpp"
+
+#include <bit>
+#include <cmath>
+#include <limits>
+#include <cstring>
+#include <charconv>
+#include <algorithm>
+
+#include "Trace.hpp"
+#include "ChainGeometry.hpp"
+#include "MemoryTracker.hpp"
+
+
+static_assert(std::endian::native == std::endian::little, "Joint series are little-endian");
+
+
+namespace
+{
+    // CSV rows are formatted into a block of this size, with room for a row of any length at its end
+    constexpr size_t csv_block = 1 << 20;
+    constexpr size_t csv_row = 256;
+
+    char* put(char* out, double value) { return std::to_chars(out, out + 32, value).ptr; }
+    char* put(char* out, float value) { return std::to_chars(out, out + 32, value).ptr; }
+    char* put(char* out, size_t value) { return std::to_chars(out, out + 32, value).ptr; }
+
+    char* put(char* out, const char* text)
+    {
+        size_t length = std::strlen(text);
+        std::memcpy(out, text, length);
+        return out + length;
+    }
+}
+
+
+JointSeriesWriter::JointSeriesWriter(const std::string& path, bool block) :
+    path_{ path }, csv_{ path.size() >= 4 && path.compare(path.size() - 4, 4, ".csv") == 0 }, block_{ block }
+{
+}
+
+JointSeriesWriter::~JointSeriesWriter()
+{
+    finish();
+}
+
+bool JointSeriesWriter::start()
+{
+    if (!file_.open(path_)) { return false; }
+
+    // Zeroed header until finish(); CSV starts with the column names
+    if (csv_) {
+        text_.resize(csv_block);
+        const char* columns = "time,kind,index,x,y,z,qx,qy,qz,qw\n";
+        file_.write(columns, std::strlen(columns));
+    }
+    else {
+        JointSeriesFormat::Header header{};
+        file_.write(&header, sizeof(header));
+    }
+
+    writer_ = std::thread(&JointSeriesWriter::writer_main, this);
+    return true;
+}
+
+void JointSeriesWriter::sample(double time, std::span<const Joint> joints, std::span<const Tendon> tendons)
+{
+    if (finished_ || !writer_.joinable() || joints.empty()) return;
+    size_t bytes = joints.size_bytes() + tendons.size_bytes();
+
+    Sample sample;
+    {
+        // A sample larger than the whole budget still goes through once the queue is empty
+        std::unique_lock<std::mutex> lock(mutex_);
+        auto full = [&] { return queue_.size() >= max_queued || (!queue_.empty() && queued_bytes_ + bytes > max_queued_bytes); };
+        if (full()) {
+            if (!block_) {
+                ++dropped_;
+                return;
+            }
+            queue_changed_.wait(lock, [&] { return !full(); });
+        }
+        if (!free_samples_.empty()) {
+            sample = std::move(free_samples_.back());
+            free_samples_.pop_back();
+        }
+        queued_bytes_ += bytes;
+    }
+
+    // Recycled buffers keep their capacity, so steady sampling does not allocate
+    sample.time = time;
+    sample.joints.assign(joints.begin(), joints.end());
+    sample.tendons.assign(tendons.begin(), tendons.end());
+
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        queue_.push_back(std::move(sample));
+    }
+    queue_changed_.notify_all();
+    ++sampled_;
+}
+
+bool JointSeriesWriter::finish()
+{
+    if (finished_) return file_.ok();
+    finished_ = true;
+    if (!writer_.joinable()) return false;
+
+    // The writer drains the queue before it exits
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        stopping_ = true;
+    }
+    queue_changed_.notify_all();
+    writer_.join();
+
+    if (!csv_) {
+        flush_chunk();
+
+        JointSeriesFormat::Header header{};
+        std::memcpy(header.magic, JointSeriesFormat::magic, sizeof(header.magic));
+        header.version = JointSeriesFormat::version;
+        header.header_size = sizeof(header);
+        header.file_size = file_.offset();
+        header.sample_count = written_samples_;
+        header.chunk_count = chunk_count_;
+        header.joint_channels = JointSeriesFormat::joint_channels;
+        header.tendon_channels = JointSeriesFormat::tendon_channels;
+
+        file_.write_at(0, &header, sizeof(header));
+    }
+    return file_.close();
+}
+
+void JointSeriesWriter::writer_main()
+{
+    Trace::set_thread_name("Series writer");
+    MemoryTracker::Scope memory(MemoryTag::IO);
+
+    while (true) {
+        Sample sample;
+        {
+            std::unique_lock<std::mutex> lock(mutex_);
+            queue_changed_.wait(lock, [this] { return stopping_ || !queue_.empty(); });
+            if (queue_.empty()) return;
+
+            sample = std::move(queue_.front());
+            queue_.pop_front();
+        }
+
+        {
+            Trace::Scope trace("Write series");
+            if (csv_) { append_csv(sample); }
+            else { append(sample); }
+        }
+
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            queued_bytes_ -= sample.joints.size() * sizeof(Joint) + sample.tendons.size() * sizeof(Tendon);
+            free_samples_.push_back(std::move(sample));
+        }
+        queue_changed_.notify_all();
+    }
+}
+
+void JointSeriesWriter::append(const Sample& sample)
+{
+    using namespace JointSeriesFormat;
+    size_t joints = sample.joints.size();
+    size_t tendons = sample.tendons.size();
+
+    if (joints != chunk_joints_ || tendons != chunk_tendons_ || chunk_capacity_ == 0) {
+        flush_chunk();
+
+        // Chunks of about chunk_bytes; the buffer keeps its capacity across chunks
+        size_t sample_bytes = sizeof(double) + (joint_channels * joints + tendon_channels * tendons) * sizeof(float);
+        chunk_capacity_ = std::clamp(chunk_bytes / sample_bytes, size_t(1), max_chunk_samples);
+        chunk_joints_ = joints;
+        chunk_tendons_ = tendons;
+        channels_.resize(chunk_capacity_ * (joint_channels * joints + tendon_channels * tendons));
+        times_.reserve(chunk_capacity_);
+    }
+
+    // Each channel is a run of chunk_capacity_ samples; this one goes in the next slot of every run
+    size_t slot = times_.size();
+    times_.push_back(sample.time);
+
+    float* channel[joint_channels];
+    for (uint32_t c = 0; c < joint_channels; ++c) {
+        channel[c] = channels_.data() + (c * chunk_capacity_ + slot) * joints;
+    }
+    for (size_t i = 0; i < joints; ++i) {
+        const Joint& joint = sample.joints[i];
+        channel[0][i] = joint.local_rot.x;
+        channel[1][i] = joint.local_rot.y;
+        channel[2][i] = joint.local_rot.z;
+        channel[3][i] = joint.local_rot.w;
+        channel[4][i] = joint.pos.x;
+        channel[5][i] = joint.pos.y;
+        channel[6][i] = joint.pos.z;
+    }
+
+    float* tendon_base = channels_.data() + joint_channels * chunk_capacity_ * joints;
+    float* x = tendon_base + (0 * chunk_capacity_ + slot) * tendons;
+    float* y = tendon_base + (1 * chunk_capacity_ + slot) * tendons;
+    float* z = tendon_base + (2 * chunk_capacity_ + slot) * tendons;
+    for (size_t i = 0; i < tendons; ++i) {
+        // Tendons on a bone the chain no longer has have no position
+        const Tendon& tendon = sample.tendons[i];
+        glm::vec3 pos(std::numeric_limits<float>::quiet_NaN());
+        if (tendon.bone_idx + 1 < joints) { pos = ChainGeometry::tendon_position(sample.joints, tendon); }
+        x[i] = pos.x;
+        y[i] = pos.y;
+        z[i] = pos.z;
+    }
+
+    if (times_.size() == chunk_capacity_) { flush_chunk(); }
+}
+
+void JointSeriesWriter::flush_chunk()
+{
+    using namespace JointSeriesFormat;
+    size_t samples = times_.size();
+    if (samples == 0) return;
+
+    size_t joints = chunk_joints_;
+    size_t tendons = chunk_tendons_;
+
+    ChunkHeader header{};
+    std::memcpy(header.magic, chunk_magic, sizeof(header.magic));
+    header.sample_count = static_cast<uint32_t>(samples);
+    header.joint_count = static_cast<uint32_t>(joints);
+    header.tendon_count = static_cast<uint32_t>(tendons);
+    header.size = sizeof(header) + samples * sizeof(double) + samples * (joint_channels * joints + tendon_channels * tendons) * sizeof(float);
+    header.start_time = times_.front();
+
+    // A partial chunk only writes the filled part of each channel
+    file_.write(&header, sizeof(header));
+    file_.write(times_.data(), samples * sizeof(double));
+    for (uint32_t c = 0; c < joint_channels; ++c) {
+        file_.write(channels_.data() + c * chunk_capacity_ * joints, samples * joints * sizeof(float));
+    }
+    const float* tendon_base = channels_.data() + joint_channels * chunk_capacity_ * joints;
+    for (uint32_t c = 0; c < tendon_channels; ++c) {
+        file_.write(tendon_base + c * chunk_capacity_ * tendons, samples * tendons * sizeof(float));
+    }
+
+    written_samples_ += samples;
+    ++chunk_count_;
+    times_.clear();
+}
+
+void JointSeriesWriter::append_csv(const Sample& sample)
+{
+    char* out = text_.data();
+    auto reserve_row = [&] {
+        if (static_cast<size_t>(text_.data() + text_.size() - out) < csv_row) {
+            file_.write(text_.data(), out - text_.data());
+            out = text_.data();
+        }
+    };
+
+    for (size_t i = 0; i < sample.joints.size(); ++i) {
+        const Joint& joint = sample.joints[i];
+        reserve_row();
+        out = put(out, sample.time);
+        out = put(out, ",joint,");
+        out = put(out, i);
+        for (float value : { joint.pos.x, joint.pos.y, joint.pos.z, joint.local_rot.x, joint.local_rot.y, joint.local_rot.z, joint.local_rot.w }) {
+            *out++ = ',';
+            out = put(out, value);
+        }
+        *out++ = '\n';
+    }
+
+    for (size_t i = 0; i < sample.tendons.size(); ++i) {
+        const Tendon& tendon = sample.tendons[i];
+        if (tendon.bone_idx + 1 >= sample.joints.size()) continue;
+
+        glm::vec3 pos = ChainGeometry::tendon_position(sample.joints, tendon);
+        reserve_row();
+        out = put(out, sample.time);
+        out = put(out, ",tendon,");
+        out = put(out, i);
+        for (float value : { pos.x, pos.y, pos.z }) {
+            *out++ = ',';
+            out = put(out, value);
+        }
+        out = put(out, ",,,,\n");
+    }
+
+    file_.write(text_.data(), out - text_.data());
+    ++written_samples_;
+}
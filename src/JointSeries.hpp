@@ -0,0 +1,137 @@
+#pragma once
+
+#include <span>
+#include <deque>
+#include <mutex>
+#include <atomic>
+#include <string>
+#include <thread>
+#include <vector>
+#include <cstdint>
+#include <condition_variable>
+
+#include <glm/glm.hpp>
+
+#include "Main.hpp"
+#include "OutputFile.hpp"
+
+
+// Joint time series, version 1. Little-endian and columnar: samples are grouped into chunks,
+// and each chunk stores every channel of its samples as one contiguous array.
+//
+//   Header   64 bytes at offset 0
+//   Chunks   32-byte chunk header, then its channels in this order:
+//              time                            sample_count doubles
+//              local rotation x, y, z, w       sample_count * joint_count floats each
+//              world position x, y, z          sample_count * joint_count floats each
+//              tendon world position x, y, z   sample_count * tendon_count floats each
+//
+// Within a channel the samples follow each other, each with all its joints or tendons. Joint and
+// tendon counts are fixed within a chunk; a change starts a new one. The header is written
+// last; a series that was not finished has a zeroed header, but its chunks can still be read.
+namespace JointSeriesFormat
+{
+    constexpr char magic[8] = { 'A', 'R', 'T', 'I', 'S', 'E', 'R', '\0' };
+    constexpr char chunk_magic[4] = { 'C', 'H', 'N', 'K' };
+    constexpr uint32_t version = 1;
+    constexpr uint32_t joint_channels = 7;
+    constexpr uint32_t tendon_channels = 3;
+
+    struct Header
+    {
+        char magic[8];
+        uint32_t version;
+        uint32_t header_size;
+        uint64_t file_size;
+        uint64_t sample_count;
+        uint64_t chunk_count;
+        uint32_t joint_channels;
+        uint32_t tendon_channels;
+        uint8_t reserved[16];
+    };
+
+    struct ChunkHeader
+    {
+        char magic[4];
+        uint32_t sample_count;
+        uint32_t joint_count;
+        uint32_t tendon_count;
+        uint64_t size;              // Of the chunk with its header, in bytes
+        double start_time;          // Of its first sample
+    };
+
+    static_assert(sizeof(Header) == 64 && sizeof(ChunkHeader) == 32);
+}
+
+
+// Writes the joint and tendon state of a chain over time, in the columnar format above or, for
+// .csv paths, as CSV with one row per joint and tendon of each sample. Samples are copied into
+// a bounded queue of recycled buffers and transposed, posed and written on a writer thread, so
+// sampling costs a copy of the joints and tendons. When block is false, samples are dropped
+// instead of waiting for a slow disk.
+class JointSeriesWriter
+{
+public:
+    JointSeriesWriter(const std::string& path, bool block);
+    ~JointSeriesWriter();
+
+    bool start();
+
+    // Queues the chain's state at the given time, in seconds; one thread samples
+    void sample(double time, std::span<const Joint> joints, std::span<const Tendon> tendons);
+
+    // Writes the queued samples, the last chunk and the header; false if any write failed
+    bool finish();
+
+    uint64_t sampled() const { return sampled_; }
+    uint64_t dropped() const { return dropped_; }
+
+private:
+    struct Sample
+    {
+        double time;
+        std::vector<Joint> joints;
+        std::vector<Tendon> tendons;
+    };
+
+    void writer_main();
+    void append(const Sample& sample);
+    void append_csv(const Sample& sample);
+    void flush_chunk();
+
+private:
+    // Queued samples are limited in count and bytes, chunks in bytes, so memory stays bounded for any chain size
+    static constexpr size_t max_queued = 256;
+    static constexpr size_t max_queued_bytes = 64 << 20;
+    static constexpr size_t chunk_bytes = 4 << 20;
+    static constexpr size_t max_chunk_samples = 1024;
+
+    std::string path_;
+    bool csv_;
+    bool block_;
+    bool finished_{ false };
+
+    // Writer thread state, until finish() joins it
+    OutputFile file_;
+    uint64_t written_samples_{ 0 };
+    uint64_t chunk_count_{ 0 };
+
+    // Current chunk: times, and the channels, each with room for chunk_capacity_ samples
+    std::vector<double> times_;
+    std::vector<float> channels_;
+    size_t chunk_capacity_{ 0 };
+    size_t chunk_joints_{ 0 };
+    size_t chunk_tendons_{ 0 };
+    std::vector<char> text_;
+
+    std::thread writer_;
+    std::mutex mutex_;
+    std::condition_variable queue_changed_;
+    std::deque<Sample> queue_;
+    std::vector<Sample> free_samples_;
+    size_t queued_bytes_{ 0 };
+    bool stopping_{ false };
+
+    std::atomic<uint64_t> sampled_{ 0 };
+    std::atomic<uint64_t> dropped_{ 0 };
+};
@@ -1,10 +1,24 @@
 #include "Kinematics.hpp"
+
+#include <array>
+#include <algorithm>
+
 #include "Math.hpp"
+#include "JobSystem.hpp"
+
+
+// Chains at least this long run FK as a blocked scan on the job system
+constexpr size_t parallel_fk_threshold = 16384;
 
 // Forward kinematics: propagate positions and rotations
 void Kinematics::forward_kinematics(std::vector<Joint>& joints, const glm::vec3& root_pos, const glm::quat& root_quat)
 {
     if (joints.empty()) return;
+    if (joints.size() >= parallel_fk_threshold && JobSystem::instance().worker_count() > 0) {
+        forward_kinematics_parallel(joints, root_pos, root_quat);
+        return;
+    }
+
     joints[0].rot = root_quat;
     joints[0].pos = root_pos;
     for (size_t i = 1; i < joints.size(); ++i) {
@@ -13,6 +27,65 @@ void Kinematics::forward_kinematics(std::vector<Joint>& joints, const glm::vec3&
     }
 }
 
+// Each joint's transform composes all parents, so FK is a prefix scan: blocks first
+// compute poses relative to their first parent, a short sequential pass chains the
+// block ends together, and a second parallel pass moves every block into place.
+void Kinematics::forward_kinematics_parallel(std::vector<Joint>& joints, const glm::vec3& root_pos, const glm::quat& root_quat)
+{
+    if (joints.empty()) return;
+    joints[0].rot = root_quat;
+    joints[0].pos = root_pos;
+
+    JobSystem& jobs = JobSystem::instance();
+    size_t count = joints.size() - 1;
+    constexpr size_t max_blocks = 64;
+    size_t blocks = std::min<size_t>({ (jobs.worker_count() + 1) * 4, max_blocks, count });
+    size_t block_size = (count + blocks - 1) / blocks;
+
+    // Pass 1: relative to the block's parent joint (identity rotation at the origin)
+    jobs.parallel_for("FK", blocks, 1, [&](size_t begin, size_t end) {
+        for (size_t b = begin; b < end; ++b) {
+            size_t first = 1 + b * block_size;
+            size_t last = std::min(first + block_size, joints.size());
+
+            glm::quat rot(1, 0, 0, 0);
+            glm::vec3 pos(0.0f);
+            for (size_t i = first; i < last; ++i) {
+                pos += rot * glm::vec3(0, 0, joints[i - 1].length);
+                rot = rot * joints[i].local_rot;
+                joints[i].rot = rot;
+                joints[i].pos = pos;
+            }
+        }
+    });
+
+    // Pass 2: world transform of each block's parent
+    std::array<std::pair<glm::vec3, glm::quat>, max_blocks> parents;
+    glm::vec3 pos = root_pos;
+    glm::quat rot = root_quat;
+    for (size_t b = 0; b < blocks; ++b) {
+        parents[b] = { pos, rot };
+
+        size_t last = std::min(1 + (b + 1) * block_size, joints.size()) - 1;
+        pos = pos + rot * joints[last].pos;
+        rot = rot * joints[last].rot;
+    }
+
+    // Pass 3: apply the parent transforms
+    jobs.parallel_for("FK", blocks, 1, [&](size_t begin, size_t end) {
+        for (size_t b = begin; b < end; ++b) {
+            size_t first = 1 + b * block_size;
+            size_t last = std::min(first + block_size, joints.size());
+            const auto& [parent_pos, parent_rot] = parents[b];
+
+            for (size_t i = first; i < last; ++i) {
+                joints[i].pos = parent_pos + parent_rot * joints[i].pos;
+                joints[i].rot = parent_rot * joints[i].rot;
+            }
+        }
+    });
+}
+
 void Kinematics::rotate_joints(std::vector<Joint>& joints, const glm::quat& root_quat)
 {
     if (joints.empty()) return;
@@ -13,6 +13,7 @@
 class Kinematics {
 public:
     static void forward_kinematics(std::vector<Joint>& joints, const glm::vec3& root_pos, const glm::quat& root_quat);
+    static void forward_kinematics_parallel(std::vector<Joint>& joints, const glm::vec3& root_pos, const glm::quat& root_quat);
     static void rotate_joints(std::vector<Joint>& joints, const glm::quat& root_quat);
     static void update_segment_lengths(std::vector<Joint>& joints);
 };
@@ -1,7 +1,11 @@
+#include "Options.hpp"
 #include "Renderer.hpp"
+#include "JobSystem.hpp"
 
 int main(int argc, char* argv[]) {
-    Renderer renderer(argc, argv);
+    Options options = Options::parse(argc, argv);
+    JobSystem::configure(options.workers);
+    Renderer renderer(options, argc, argv);
     renderer.run();
     return 0;
 }
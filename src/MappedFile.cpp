@@ -0,0 +1,105 @@
+#include "MappedFile.hpp"
+
+#include <cstdio>
+
+#ifdef _WIN32
+#define WIN32_LEAN_AND_MEAN
+#define NOMINMAX
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#endif
+
+
+MappedFile::~MappedFile()
+{
+    close();
+}
+
+bool MappedFile::open(const std::string& path)
+{
+    close();
+
+#ifdef _WIN32
+    HANDLE file = CreateFileA(path.c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, nullptr);
+    if (file == INVALID_HANDLE_VALUE) {
+        std::fprintf(stderr, "Cannot open %s\n", path.c_str());
+        return false;
+    }
+
+    LARGE_INTEGER size;
+    if (!GetFileSizeEx(file, &size)) {
+        CloseHandle(file);
+        std::fprintf(stderr, "Cannot read the size of %s\n", path.c_str());
+        return false;
+    }
+    if (size.QuadPart == 0) {
+        // Empty files cannot be mapped; they are valid but hold nothing
+        CloseHandle(file);
+        return true;
+    }
+
+    HANDLE mapping = CreateFileMappingA(file, nullptr, PAGE_READONLY, 0, 0, nullptr);
+    CloseHandle(file);
+    if (!mapping) {
+        std::fprintf(stderr, "Cannot map %s\n", path.c_str());
+        return false;
+    }
+
+    void* view = MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0);
+    CloseHandle(mapping);
+    if (!view) {
+        std::fprintf(stderr, "Cannot map %s\n", path.c_str());
+        return false;
+    }
+
+    data_ = static_cast<const std::byte*>(view);
+    size_ = static_cast<size_t>(size.QuadPart);
+#else
+    int fd = ::open(path.c_str(), O_RDONLY);
+    if (fd < 0) {
+        std::fprintf(stderr, "Cannot open %s\n", path.c_str());
+        return false;
+    }
+
+    struct stat st;
+    if (fstat(fd, &st) != 0) {
+        ::close(fd);
+        std::fprintf(stderr, "Cannot read the size of %s\n", path.c_str());
+        return false;
+    }
+    if (st.st_size == 0) {
+        ::close(fd);
+        return true;
+    }
+
+    // The mapping stays valid after the descriptor is closed
+    void* view = mmap(nullptr, static_cast<size_t>(st.st_size), PROT_READ, MAP_PRIVATE, fd, 0);
+    ::close(fd);
+    if (view == MAP_FAILED) {
+        std::fprintf(stderr, "Cannot map %s\n", path.c_str());
+        return false;
+    }
+
+    data_ = static_cast<const std::byte*>(view);
+    size_ = static_cast<size_t>(st.st_size);
+#endif
+
+    return true;
+}
+
+void MappedFile::close()
+{
+    if (data_) {
+#ifdef _WIN32
+        UnmapViewOfFile(data_);
+#else
+        munmap(const_cast<std::byte*>(data_), size_);
+#endif
+    }
+    data_ = nullptr;
+    size_ = 0;
+}
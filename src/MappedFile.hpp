@@ -0,0 +1,28 @@
+#pragma once
+
+#include <string>
+#include <cstddef>
+
+
+// Read-only memory mapping of a whole file. Pages are loaded on first access,
+// so opening costs the same for any file size.
+class MappedFile
+{
+public:
+    MappedFile() = default;
+    ~MappedFile();
+
+    MappedFile(const MappedFile&) = delete;
+    MappedFile& operator=(const MappedFile&) = delete;
+
+    // False if the file cannot be opened or mapped; errors go to stderr
+    bool open(const std::string& path);
+    void close();
+
+    const std::byte* data() const { return data_; }
+    size_t size() const { return size_; }
+
+private:
+    const std::byte* data_{ nullptr };
+    size_t size_{ 0 };
+};
@@ -1,9 +1,96 @@
 #include "Math.hpp"
 
+#include <cmath>
+
 #include <glm/gtc/constants.hpp>
 
 #include "Main.hpp"
 
+
+namespace
+{
+    // Rotation about one coordinate axis from the cosine and sine of half its angle
+    template <int Axis>
+    glm::quat axis_quat(float c, float s)
+    {
+        return glm::quat(c, Axis == 0 ? s : 0.0f, Axis == 1 ? s : 0.0f, Axis == 2 ? s : 0.0f);
+    }
+
+    // One loop per axis order, so the zero terms of the three products fold away
+    template <int A, int B, int C>
+    void euler_kernel(std::span<const glm::vec3> degrees, std::span<glm::quat> out)
+    {
+        constexpr float half_radians = glm::pi<float>() / 360.0f;
+        for (size_t i = 0; i < degrees.size(); ++i) {
+            glm::vec3 h = degrees[i] * half_radians;
+            out[i] = axis_quat<A>(std::cos(h.x), std::sin(h.x)) * axis_quat<B>(std::cos(h.y), std::sin(h.y)) * axis_quat<C>(std::cos(h.z), std::sin(h.z));
+        }
+    }
+
+    // sin(x) / x on [0, pi] and acos on [-1, 1] to float precision (Taylor series and Abramowitz and
+    // Stegun 4.4.46), in plain arithmetic without selects, so the batch loops below vectorize
+    inline float sinc_poly(float x)
+    {
+        float x2 = x * x;
+        return 1.0f + x2 * (-1.0f / 6.0f + x2 * (1.0f / 120.0f + x2 * (-1.0f / 5040.0f + x2 * (1.0f / 362880.0f + x2 * (-1.0f / 39916800.0f +
+            x2 * (1.0f / 6227020800.0f + x2 * (-1.0f / 1307674368000.0f + x2 * (1.0f / 355687428096000.0f))))))));
+    }
+
+    inline float acos_poly(float x)
+    {
+        float a = std::abs(x);
+        float r = std::sqrt(std::abs(1.0f - a)) * (1.5707963050f + a * (-0.2145988016f + a * (0.0889789874f + a * (-0.0501743046f +
+            a * (0.0308918810f + a * (-0.0170881256f + a * (0.0066700901f + a * -0.0012624911f)))))));
+        return glm::half_pi<float>() - std::copysign(glm::half_pi<float>() - r, x);
+    }
+
+    // Slerp along the shorter arc or, for squad, the arc between the quaternions as given. The
+    // weights sin(t theta) / sin(theta) are taken as sinc ratios, which stay exact as theta goes to 0.
+    template <bool Shortest>
+    inline glm::quat slerp_kernel(const glm::quat& a, const glm::quat& b, float t)
+    {
+        float d = a.x * b.x + a.y * b.y + a.z * b.z + a.w * b.w;
+        float sign = Shortest ? std::copysign(1.0f, d) : 1.0f;
+        float theta = acos_poly(d * sign);
+        float inv = 1.0f / sinc_poly(theta);
+        float wa = (1.0f - t) * sinc_poly((1.0f - t) * theta) * inv;
+        float wb = t * sinc_poly(t * theta) * inv * sign;
+        return glm::quat(wa * a.w + wb * b.w, wa * a.x + wb * b.x, wa * a.y + wb * b.y, wa * a.z + wb * b.z);
+    }
+
+    // Hemisphere correction flips the sign of b's weight rather than b, which keeps the loops free of selects
+    inline glm::quat nlerp_kernel(const glm::quat& a, const glm::quat& b, float w)
+    {
+        float d = a.x * b.x + a.y * b.y + a.z * b.z + a.w * b.w;
+        float wa = 1.0f - w;
+        float wb = std::copysign(w, d);
+        glm::quat q(wa * a.w + wb * b.w, wa * a.x + wb * b.x, wa * a.y + wb * b.y, wa * a.z + wb * b.z);
+        float inv = 1.0f / std::sqrt(q.x * q.x + q.y * q.y + q.z * q.z + q.w * q.w);
+        return glm::quat(q.w * inv, q.x * inv, q.y * inv, q.z * inv);
+    }
+
+    inline glm::quat multiply(const glm::quat& p, const glm::quat& q)
+    {
+        return glm::quat(p.w * q.w - p.x * q.x - p.y * q.y - p.z * q.z,
+            p.w * q.x + p.x * q.w + p.y * q.z - p.z * q.y,
+            p.w * q.y - p.x * q.z + p.y * q.w + p.z * q.x,
+            p.w * q.z + p.x * q.y - p.y * q.x + p.z * q.w);
+    }
+
+    // Calls kernel(i, w) for every joint, in separate loops with and without a mask
+    template <typename Kernel>
+    inline void weighted_loop(size_t count, float weight, std::span<const float> mask, Kernel kernel)
+    {
+        if (mask.empty()) {
+            for (size_t i = 0; i < count; ++i) { kernel(i, weight); }
+        }
+        else {
+            for (size_t i = 0; i < count; ++i) { kernel(i, weight * mask[i]); }
+        }
+    }
+}
+
+
 glm::quat Math::axis_angle_quat(const glm::vec3& axis, float angle_deg) {
     return glm::angleAxis(glm::radians(angle_deg), glm::normalize(axis));
 }
@@ -34,3 +121,64 @@ std::pair<float, float> Math::plane_angles(ViewPlane plane) {
         default: return { 0.8f, 0.3f }; // arbitrary for 3D
     }
 }
+
+void Math::euler_to_quat(EulerOrder order, std::span<const glm::vec3> degrees, std::span<glm::quat> out) {
+    switch (order) {
+        case EulerOrder::XYZ: euler_kernel<0, 1, 2>(degrees, out); break;
+        case EulerOrder::XZY: euler_kernel<0, 2, 1>(degrees, out); break;
+        case EulerOrder::YXZ: euler_kernel<1, 0, 2>(degrees, out); break;
+        case EulerOrder::YZX: euler_kernel<1, 2, 0>(degrees, out); break;
+        case EulerOrder::ZXY: euler_kernel<2, 0, 1>(degrees, out); break;
+        case EulerOrder::ZYX: euler_kernel<2, 1, 0>(degrees, out); break;
+    }
+}
+
+void Math::slerp(std::span<const glm::quat> a, std::span<const glm::quat> b, std::span<const float> t, std::span<glm::quat> out) {
+    for (size_t i = 0; i < out.size(); ++i) {
+        out[i] = slerp_kernel<true>(a[i], b[i], t[i]);
+    }
+}
+
+void Math::squad(std::span<const glm::quat> a, std::span<const glm::quat> b, std::span<const glm::quat> sa, std::span<const glm::quat> sb,
+    std::span<const float> t, std::span<glm::quat> out) {
+    for (size_t i = 0; i < out.size(); ++i) {
+        out[i] = slerp_kernel<false>(slerp_kernel<false>(a[i], b[i], t[i]), slerp_kernel<false>(sa[i], sb[i], t[i]), 2.0f * t[i] * (1.0f - t[i]));
+    }
+}
+
+void Math::nlerp(std::span<const glm::quat> a, std::span<const glm::quat> b, float weight, std::span<const float> mask, std::span<glm::quat> out) {
+    weighted_loop(out.size(), weight, mask, [&](size_t i, float w) {
+        out[i] = nlerp_kernel(a[i], b[i], w);
+    });
+}
+
+void Math::add_rotations(std::span<const glm::quat> base, std::span<const glm::quat> delta, float weight, std::span<const float> mask,
+    std::span<glm::quat> out) {
+    const glm::quat identity(1, 0, 0, 0);
+    weighted_loop(out.size(), weight, mask, [&](size_t i, float w) {
+        out[i] = multiply(base[i], nlerp_kernel(identity, delta[i], w));
+    });
+}
+
+void Math::accumulate(std::span<glm::quat> sum, std::span<const glm::quat> q, float weight, std::span<const float> mask) {
+    weighted_loop(sum.size(), weight, mask, [&](size_t i, float w) {
+        const glm::quat& s = sum[i];
+        const glm::quat& p = q[i];
+        float ws = std::copysign(w, s.x * p.x + s.y * p.y + s.z * p.z + s.w * p.w);
+        sum[i] = glm::quat(s.w + ws * p.w, s.x + ws * p.x, s.y + ws * p.y, s.z + ws * p.z);
+    });
+}
+
+void Math::normalize(std::span<glm::quat> q) {
+    for (size_t i = 0; i < q.size(); ++i) {
+        float inv = 1.0f / std::sqrt(q[i].x * q[i].x + q[i].y * q[i].y + q[i].z * q[i].z + q[i].w * q[i].w);
+        q[i] = glm::quat(q[i].w * inv, q[i].x * inv, q[i].y * inv, q[i].z * inv);
+    }
+}
+
+void Math::difference(std::span<const glm::quat> q, std::span<const glm::quat> reference, std::span<glm::quat> out) {
+    for (size_t i = 0; i < out.size(); ++i) {
+        const glm::quat& r = reference[i];
+        out[i] = multiply(glm::quat(r.w, -r.x, -r.y, -r.z), q[i]);
+    }
+}
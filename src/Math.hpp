@@ -1,5 +1,7 @@
 #pragma once
 
+#include <span>
+#include <cstdint>
 #include <utility>
 
 #include <glm/glm.hpp>
@@ -7,10 +9,41 @@
 
 enum class ViewPlane;
 
+// Axis order of Euler angles; the first axis is applied outermost (q = q_first * q_second * q_third)
+enum class EulerOrder : uint8_t { XYZ, XZY, YXZ, YZX, ZXY, ZYX };
+
 class Math {
 public:
     static glm::quat axis_angle_quat(const glm::vec3& axis, float angle_deg);
     static glm::quat compute_frame_quat(const glm::vec3& from, const glm::vec3& to, glm::vec3 up = glm::vec3(0, 1, 0));
     static glm::quat compute_frame_quat_from_dir(const glm::vec3& dir, glm::vec3 up = glm::vec3(0, 1, 0));
     static std::pair<float, float> plane_angles(ViewPlane plane);
+
+    // Batch conversion of Euler angles in degrees, given in the order's axis order, to quaternions
+    static void euler_to_quat(EulerOrder order, std::span<const glm::vec3> degrees, std::span<glm::quat> out);
+
+    // Batch slerp along the shorter arc, out[i] = slerp(a[i], b[i], t[i]) for unit quaternions
+    static void slerp(std::span<const glm::quat> a, std::span<const glm::quat> b, std::span<const float> t, std::span<glm::quat> out);
+
+    // Batch squad through the segment's control points: slerp(slerp(a, b, t), slerp(sa, sb, t), 2t(1 - t)),
+    // with b on a's side and each control point on its key's
+    static void squad(std::span<const glm::quat> a, std::span<const glm::quat> b, std::span<const glm::quat> sa, std::span<const glm::quat> sb,
+        std::span<const float> t, std::span<glm::quat> out);
+
+    // Pose blending, with b or delta taken on the hemisphere nearer a or the identity. The weight of joint i is
+    // weight * mask[i], or the weight alone for an empty mask. Outputs may be the same array as an input.
+
+    // Batch normalized lerp, out[i] = normalize(lerp(a[i], b[i], w))
+    static void nlerp(std::span<const glm::quat> a, std::span<const glm::quat> b, float weight, std::span<const float> mask, std::span<glm::quat> out);
+
+    // Batch additive layer, out[i] = base[i] * nlerp(identity, delta[i], w)
+    static void add_rotations(std::span<const glm::quat> base, std::span<const glm::quat> delta, float weight, std::span<const float> mask,
+        std::span<glm::quat> out);
+
+    // Batch weighted sum for averages, sum[i] += w * q[i] on sum[i]'s hemisphere; normalized afterwards
+    static void accumulate(std::span<glm::quat> sum, std::span<const glm::quat> q, float weight, std::span<const float> mask);
+    static void normalize(std::span<glm::quat> q);
+
+    // Batch rotation from reference to q, out[i] = conjugate(reference[i]) * q[i] for unit quaternions
+    static void difference(std::span<const glm::quat> q, std::span<const glm::quat> reference, std::span<glm::quat> out);
 };
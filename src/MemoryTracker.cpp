@@ -0,0 +1,156 @@
+#include "MemoryTracker.hpp"
+
+#include <new>
+#include <atomic>
+#include <cstdlib>
+
+
+namespace
+{
+    struct Counters
+    {
+        std::atomic<uint64_t> allocations{ 0 };
+        std::atomic<uint64_t> bytes{ 0 };
+        std::atomic<int64_t> live_bytes{ 0 };
+    };
+
+    // Constant-initialized, so allocations during static initialization are safe
+    Counters counters[MemoryTracker::tag_count];
+    std::atomic<int64_t> live_bytes{ 0 };
+    std::atomic<int64_t> peak_bytes{ 0 };
+
+    thread_local uint64_t thread_count = 0;
+    thread_local MemoryTag thread_tag = MemoryTag::Other;
+
+    // Render thread: totals at the end of the previous frame, and the last frame's deltas
+    MemoryTracker::Snapshot previous;
+    MemoryTracker::Snapshot last_frame;
+
+    const char* tag_names[MemoryTracker::tag_count] = { "Other", "Kinematics", "Rendering", "Overlay", "I/O" };
+
+#if defined(ARTICHOKE_MEMORY_TRACKING) || !defined(NDEBUG)
+    // Precedes every allocation, so frees know their size and subsystem
+    struct alignas(alignof(std::max_align_t)) Header
+    {
+        size_t size;
+        MemoryTag tag;
+    };
+
+    void track(MemoryTag tag, int64_t size)
+    {
+        Counters& counter = counters[static_cast<size_t>(tag)];
+        counter.live_bytes.fetch_add(size, std::memory_order_relaxed);
+        int64_t live = live_bytes.fetch_add(size, std::memory_order_relaxed) + size;
+
+        if (size > 0) {
+            counter.allocations.fetch_add(1, std::memory_order_relaxed);
+            counter.bytes.fetch_add(static_cast<uint64_t>(size), std::memory_order_relaxed);
+            ++thread_count;
+
+            int64_t peak = peak_bytes.load(std::memory_order_relaxed);
+            while (live > peak && !peak_bytes.compare_exchange_weak(peak, live, std::memory_order_relaxed)) {}
+        }
+    }
+#endif
+}
+
+
+MemoryTracker::Scope::Scope(MemoryTag tag) : previous_{ thread_tag }
+{
+    thread_tag = tag;
+}
+
+MemoryTracker::Scope::~Scope()
+{
+    thread_tag = previous_;
+}
+
+MemoryTag MemoryTracker::current_tag()
+{
+    return thread_tag;
+}
+
+const char* MemoryTracker::tag_name(MemoryTag tag)
+{
+    size_t index = static_cast<size_t>(tag);
+    return index < tag_count ? tag_names[index] : "?";
+}
+
+uint64_t MemoryTracker::thread_allocations()
+{
+    return thread_count;
+}
+
+MemoryTracker::Snapshot MemoryTracker::snapshot()
+{
+    Snapshot result;
+    for (size_t i = 0; i < tag_count; ++i) {
+        TagStats& tag = result.tags[i];
+        tag.allocations = counters[i].allocations.load(std::memory_order_relaxed);
+        tag.bytes = counters[i].bytes.load(std::memory_order_relaxed);
+        tag.live_bytes = counters[i].live_bytes.load(std::memory_order_relaxed);
+
+        result.allocations += tag.allocations;
+        result.bytes += tag.bytes;
+    }
+    result.live_bytes = live_bytes.load(std::memory_order_relaxed);
+    result.peak_bytes = peak_bytes.load(std::memory_order_relaxed);
+    return result;
+}
+
+void MemoryTracker::reset_peak()
+{
+    peak_bytes.store(live_bytes.load(std::memory_order_relaxed), std::memory_order_relaxed);
+}
+
+void MemoryTracker::end_frame()
+{
+    Snapshot current = snapshot();
+
+    last_frame = current;
+    for (size_t i = 0; i < tag_count; ++i) {
+        last_frame.tags[i].allocations -= previous.tags[i].allocations;
+        last_frame.tags[i].bytes -= previous.tags[i].bytes;
+    }
+    last_frame.allocations -= previous.allocations;
+    last_frame.bytes -= previous.bytes;
+
+    previous = current;
+    reset_peak();
+}
+
+const MemoryTracker::Snapshot& MemoryTracker::frame()
+{
+    return last_frame;
+}
+
+
+#if defined(ARTICHOKE_MEMORY_TRACKING) || !defined(NDEBUG)
+
+void* operator new(size_t size)
+{
+    void* raw = std::malloc(sizeof(Header) + size);
+    if (!raw) throw std::bad_alloc();
+
+    Header* header = static_cast<Header*>(raw);
+    header->size = size;
+    header->tag = thread_tag;
+    track(header->tag, static_cast<int64_t>(size));
+    return header + 1;
+}
+
+void operator delete(void* p) noexcept
+{
+    if (!p) return;
+
+    Header* header = static_cast<Header*>(p) - 1;
+    track(header->tag, -static_cast<int64_t>(header->size));
+    std::free(header);
+}
+
+void operator delete(void* p, size_t) noexcept
+{
+    operator delete(p);
+}
+
+#endif
@@ -0,0 +1,76 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+
+
+// Subsystems that heap allocations are attributed to
+enum class MemoryTag : uint8_t
+{
+    Other,
+    Kinematics,
+    Rendering,
+    Overlay,
+    IO,
+    Count
+};
+
+
+// Heap allocation tracking through a replacement global operator new. Compiled in
+// debug builds and with ARTICHOKE_MEMORY_TRACKING; otherwise all counts stay zero.
+// Each allocation is attributed to the innermost Scope of the allocating thread.
+class MemoryTracker
+{
+public:
+#if defined(ARTICHOKE_MEMORY_TRACKING) || !defined(NDEBUG)
+    static constexpr bool enabled = true;
+#else
+    static constexpr bool enabled = false;
+#endif
+
+    static constexpr size_t tag_count = static_cast<size_t>(MemoryTag::Count);
+
+    struct TagStats
+    {
+        uint64_t allocations = 0;
+        uint64_t bytes = 0;             // Allocated, not net of frees
+        int64_t live_bytes = 0;
+    };
+
+    struct Snapshot
+    {
+        TagStats tags[tag_count];
+        uint64_t allocations = 0;
+        uint64_t bytes = 0;
+        int64_t live_bytes = 0;
+        int64_t peak_bytes = 0;         // Highest live_bytes since the last reset_peak()
+    };
+
+    // Attributes the calling thread's allocations to a subsystem while alive
+    class Scope
+    {
+    public:
+        explicit Scope(MemoryTag tag);
+        ~Scope();
+
+        Scope(const Scope&) = delete;
+        Scope& operator=(const Scope&) = delete;
+
+    private:
+        MemoryTag previous_;
+    };
+
+    static MemoryTag current_tag();
+    static const char* tag_name(MemoryTag tag);
+
+    // Allocations made by the calling thread since it started
+    static uint64_t thread_allocations();
+
+    // Totals since startup
+    static Snapshot snapshot();
+    static void reset_peak();
+
+    // Render thread: closes a frame; frame() then holds its allocations and bytes, the live bytes and the frame's peak
+    static void end_frame();
+    static const Snapshot& frame();
+};
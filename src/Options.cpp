@@ -0,0 +1,162 @@
+#include "Options.hpp"
+
+#include <cstdio>
+#include <string>
+#include <cstdlib>
+#include <cstring>
+#include <algorithm>
+
+
+Options Options::parse(int argc, char** argv)
+{
+    Options options;
+
+    for (int i = 1; i < argc; ++i) {
+        std::string arg = argv[i];
+        auto value = [&]() -> const char* {
+            if (i + 1 >= argc) {
+                std::fprintf(stderr, "Missing value for %s\n", arg.c_str());
+                std::exit(1);
+            }
+            return argv[++i];
+        };
+
+        if (arg == "--continuous") {
+            options.on_demand = false;
+        }
+        else if (arg == "--on-demand") {
+            options.on_demand = true;
+        }
+        else if (arg == "--animation-fps") {
+            options.animation_fps = std::max(1.0f, static_cast<float>(std::atof(value())));
+        }
+        else if (arg == "--sim-rate") {
+            options.sim_rate = std::max(0.0f, static_cast<float>(std::atof(value())));
+        }
+        else if (arg == "--workers") {
+            options.workers = std::max(0, std::atoi(value()));
+        }
+        else if (arg == "--headless") {
+            options.headless = true;
+        }
+        else if (arg == "--frames") {
+            options.frames = std::max(1, std::atoi(value()));
+        }
+        else if (arg == "--pose-script") {
+            options.pose_script = value();
+        }
+        else if (arg == "--capture") {
+            options.capture = value();
+        }
+        else if (arg == "--trace") {
+            options.trace_seconds = std::max(0.0, std::atof(value()));
+        }
+        else if (arg == "--trace-file") {
+            options.trace_file = value();
+        }
+        else if (arg == "--chains") {
+            options.scene.chains = static_cast<size_t>(std::max(1, std::atoi(value())));
+            options.generate_scene = true;
+        }
+        else if (arg == "--joints") {
+            options.scene.joints = static_cast<size_t>(std::max(2, std::atoi(value())));
+            options.generate_scene = true;
+        }
+        else if (arg == "--bone-length") {
+            options.scene.bone_length = std::max(1.0f, static_cast<float>(std::atof(value())));
+            options.generate_scene = true;
+        }
+        else if (arg == "--tendons-per-bone") {
+            options.scene.tendons_per_bone = static_cast<size_t>(std::max(0, std::atoi(value())));
+            options.generate_scene = true;
+        }
+        else if (arg == "--seed") {
+            options.scene.seed = static_cast<uint32_t>(std::strtoul(value(), nullptr, 10));
+            options.generate_scene = true;
+        }
+        else if (arg == "--animate") {
+            std::string mode = value();
+            if (mode == "none") { options.scene.animation = AnimationMode::None; }
+            else if (mode == "random") { options.scene.animation = AnimationMode::Random; }
+            else if (mode == "sine") { options.scene.animation = AnimationMode::Sine; }
+            else if (mode == "keys") { options.scene.animation = AnimationMode::Keyframes; }
+            else if (mode == "layers") { options.scene.animation = AnimationMode::Layered; }
+            else {
+                std::fprintf(stderr, "Unknown animation mode: %s (none, random, sine, keys or layers)\n", mode.c_str());
+                std::exit(1);
+            }
+            options.generate_scene = true;
+        }
+        else if (arg == "--amplitude") {
+            options.scene.amplitude = static_cast<float>(std::atof(value()));
+        }
+        else if (arg == "--frequency") {
+            options.scene.frequency = std::max(0.0f, static_cast<float>(std::atof(value())));
+        }
+        else if (arg == "--scene") {
+            options.scene_file = value();
+        }
+        else if (arg == "--save-scene") {
+            options.save_scene_file = value();
+        }
+        else if (arg == "--record") {
+            options.record_file = value();
+        }
+        else if (arg == "--play") {
+            options.play_file = value();
+        }
+        else if (arg == "--compress") {
+            options.compress_tolerance = std::max(0.0f, static_cast<float>(std::atof(value())));
+        }
+        else if (arg == "--bvh") {
+            options.bvh_file = value();
+        }
+        else if (arg == "--export-gltf") {
+            options.gltf_file = value();
+        }
+        else if (arg == "--series") {
+            options.series_file = value();
+        }
+        else if (arg == "--help" || arg == "-h") {
+            print_usage(argv[0]);
+            std::exit(0);
+        }
+        // Anything else is left for GLUT
+    }
+
+    return options;
+}
+
+void Options::print_usage(const char* program)
+{
+    std::printf(
+        "Usage: %s [options]\n"
+        "  --on-demand            Redraw only when something changes (default)\n"
+        "  --continuous           Redraw continuously\n"
+        "  --animation-fps <n>    Frame rate while animating in on-demand mode (default 60)\n"
+        "  --sim-rate <hz>        Simulation thread rate, 0 to disable (default 120)\n"
+        "  --workers <n>          Job system worker threads (default: cores - 1)\n"
+        "  --headless             Render offscreen without a window (EGL)\n"
+        "  --frames <n>           Frames to render in headless mode\n"
+        "  --pose-script <file>   Pose commands applied per frame in headless mode\n"
+        "  --capture <path>       Capture frames: frame_%%05d.png, .ppm, .yuv, or - for YUV on stdout\n"
+        "  --trace <seconds>      Record a Chrome trace at startup (F12 toggles one at runtime)\n"
+        "  --trace-file <path>    Trace output (default artichoke_trace.json)\n"
+        "  --chains <n>           Generate a scene of n chains on a grid\n"
+        "  --joints <n>           Joints per generated chain (default 5)\n"
+        "  --bone-length <len>    Bone length of generated chains (default 100)\n"
+        "  --tendons-per-bone <n> Tendons on every bone of generated chains (default 0)\n"
+        "  --seed <n>             Seed for bends and random animation (default 1)\n"
+        "  --animate <mode>       Animate generated chains: none, random, sine, keys or layers\n"
+        "  --amplitude <deg>      Animation amplitude (default 15)\n"
+        "  --frequency <hz>       Animation frequency (default 0.5)\n"
+        "  --scene <file>         Load a scene file (text if it ends in .txt)\n"
+        "  --save-scene <file>    Save the startup scene to a scene file\n"
+        "  --record <file>        Record every edit of the pose\n"
+        "  --play <file>          Play a pose recording back\n"
+        "  --compress <tolerance> Compress the --play recording to a world-space error bound\n"
+        "  --bvh <file>           Import a BVH motion capture and play it back\n"
+        "  --export-gltf <file>   Export the startup scene and the --play recording as .glb\n"
+        "  --series <file>        Write joint and tendon state every frame (columnar, or CSV for .csv)\n",
+        program);
+}
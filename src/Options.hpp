@@ -0,0 +1,61 @@
+#pragma once
+
+#include <string>
+
+#include "SceneGenerator.hpp"
+
+
+// Command-line options
+struct Options
+{
+    // Redraw only when something changed instead of continuously
+    bool on_demand = true;
+
+    // Frame rate while something animates in on-demand mode
+    float animation_fps = 60.0f;
+
+    // Fixed simulation rate in Hz; 0 runs kinematics on the render thread
+    float sim_rate = 120.0f;
+
+    // Job system worker threads; -1 uses one per core minus the main thread
+    int workers = -1;
+
+    // Render offscreen without a window system for a fixed number of frames
+    bool headless = false;
+    int frames = -1;                // -1: one frame, or until the pose script ends
+    std::string pose_script;
+
+    // Capture every frame to an image sequence or raw YUV stream (see FrameCapture)
+    std::string capture;
+
+    // Chrome trace of the first seconds (0: off; F12 toggles a trace at runtime)
+    double trace_seconds = 0.0;
+    std::string trace_file = "artichoke_trace.json";
+
+    // Procedural stress scene; without any scene option the single editable chain is shown
+    SceneSpec scene;
+    bool generate_scene = false;
+
+    // Scene file loaded at startup instead, and where to save the startup scene
+    std::string scene_file;
+    std::string save_scene_file;
+
+    // Record every edit of the pose to a file, and play one back (see PoseLog)
+    std::string record_file;
+    std::string play_file;
+
+    // World-space tolerance for compressing the --play recording (0: play it uncompressed; see AnimationCompression)
+    float compress_tolerance = 0.0f;
+
+    // BVH motion capture to import as the chain and play back
+    std::string bvh_file;
+
+    // glTF export of the startup scene, animated by the --play recording if there is one
+    std::string gltf_file;
+
+    // Per-frame joint and tendon state of the edited chain, columnar or .csv (see JointSeries)
+    std::string series_file;
+
+    static Options parse(int argc, char** argv);
+    static void print_usage(const char* program);
+};
@@ -0,0 +1,90 @@
+#include "OutputFile.hpp"
+
+
+namespace
+{
+    // Offsets past 2 GB do not fit the long of std::fseek where it is 32 bits, as on Windows
+    bool seek(FILE* file, uint64_t offset)
+    {
+#ifdef _WIN32
+        return _fseeki64(file, static_cast<__int64>(offset), SEEK_SET) == 0;
+#else
+        return fseeko(file, static_cast<off_t>(offset), SEEK_SET) == 0;
+#endif
+    }
+}
+
+
+OutputFile::~OutputFile()
+{
+    if (file_) { std::fclose(file_); }
+}
+
+bool OutputFile::open(const std::string& path)
+{
+    if (file_) { std::fclose(file_); }
+
+    path_ = path;
+    offset_ = 0;
+    moved_ = false;
+    file_ = std::fopen(path.c_str(), "wb");
+    if (!file_) {
+        std::fprintf(stderr, "Cannot write %s\n", path.c_str());
+        return ok_ = false;
+    }
+    return ok_ = true;
+}
+
+bool OutputFile::close()
+{
+    if (!file_) { return false; }
+
+    if (std::fclose(file_) != 0) { ok_ = false; }
+    file_ = nullptr;
+
+    if (!ok_) { std::fprintf(stderr, "Failed writing %s\n", path_.c_str()); }
+    return ok_;
+}
+
+void OutputFile::discard()
+{
+    if (file_) {
+        std::fclose(file_);
+        file_ = nullptr;
+        std::remove(path_.c_str());
+    }
+    ok_ = false;
+}
+
+bool OutputFile::write(const void* data, size_t size)
+{
+    if (!ok_ || size == 0) { return ok_; }
+    if (moved_) {
+        ok_ = seek(file_, offset_);
+        moved_ = false;
+        if (!ok_) { return false; }
+    }
+    ok_ = std::fwrite(data, 1, size, file_) == size;
+    offset_ += size;
+    return ok_;
+}
+
+bool OutputFile::pad(size_t alignment)
+{
+    static const char zeros[64] = {};
+    size_t size = (alignment - offset_ % alignment) % alignment;
+    while (ok_ && size > 0) {
+        size_t chunk = size < sizeof(zeros) ? size : sizeof(zeros);
+        write(zeros, chunk);
+        size -= chunk;
+    }
+    return ok_;
+}
+
+bool OutputFile::write_at(uint64_t offset, const void* data, size_t size)
+{
+    if (!ok_ || size == 0) { return ok_; }
+    moved_ = true;
+    ok_ = seek(file_, offset) && std::fwrite(data, 1, size, file_) == size;
+    return ok_;
+}
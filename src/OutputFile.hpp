@@ -0,0 +1,51 @@
+#pragma once
+
+#include <string>
+#include <cstdio>
+#include <cstdint>
+
+
+// Binary file written front to back, with a header overwritten once the rest is known. The
+// first failed write latches: later writes do nothing and close() reports it.
+class OutputFile
+{
+public:
+    OutputFile() = default;
+    ~OutputFile();
+
+    OutputFile(const OutputFile&) = delete;
+    OutputFile& operator=(const OutputFile&) = delete;
+
+    // Creates or truncates the file; false if it cannot, with the error on stderr
+    bool open(const std::string& path);
+
+    // Closes the file; false if any write failed, with the error on stderr
+    bool close();
+
+    // Closes and removes the file, for output that would not be readable
+    void discard();
+
+    // Appends, at offset()
+    bool write(const void* data, size_t size);
+
+    // Zeros up to the next multiple of the alignment
+    bool pad(size_t alignment);
+
+    // Overwrites bytes already written, or written later; appending continues at the end
+    bool write_at(uint64_t offset, const void* data, size_t size);
+
+    // Marks the output as failed, for errors found by the caller
+    void fail() { ok_ = false; }
+
+    bool is_open() const { return file_ != nullptr; }
+    bool ok() const { return ok_; }
+    uint64_t offset() const { return offset_; }
+    const std::string& path() const { return path_; }
+
+private:
+    FILE* file_{ nullptr };
+    std::string path_;
+    uint64_t offset_{ 0 };          // End of the appended data
+    bool moved_{ false };           // The position is not at offset_ after write_at()
+    bool ok_{ false };
+};
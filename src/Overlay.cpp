@@ -1,49 +1,35 @@
 #include "Overlay.hpp"
 
 #include <cmath>
+#include <algorithm>
+#include <cfloat>
 #include <string>
 #include <iostream>
 #include <filesystem>
+#include <memory_resource>
 
 #include <glm/gtc/type_ptr.hpp>
 
 #include "Input.hpp"
 #include "Chain.hpp"
 #include "Camera.hpp"
+#include "Profiler.hpp"
+#include "FontAtlas.hpp"
+#include "FrameArena.hpp"
+#include "Buffer.hpp"
+#include "MemoryTracker.hpp"
 
 
-Overlay::Overlay(std::shared_ptr<Camera> camera, std::shared_ptr<Chain> chain) : camera_(std::move(camera)), chain_(chain)
+Overlay::Overlay(std::shared_ptr<Camera> camera, std::shared_ptr<Chain> chain, std::shared_ptr<Profiler> profiler) : 
+    camera_(std::move(camera)), chain_(chain), profiler_(std::move(profiler))
 {
-    load_fonts();
-}
-
-void Overlay::load_fonts()
-{
-    ImGuiIO& io = ImGui::GetIO();
-
-    // Load Roboto-Regular.ttf as the default font
-    const char* regular_path = "res/Roboto-Regular.ttf";
-    if (!std::filesystem::exists(regular_path)) {
-        std::cerr << "Font not found: " << regular_path << '\n';
-    }
-    ImFont* regular = io.Fonts->AddFontFromFileTTF(regular_path, 14.0f);
-    if (!regular) {
-        std::cerr << "Failed to load " << regular_path << '\n';
-    }
-    fonts_["Regular"] = regular;
-
-    // Load Roboto-Bold.ttf as the axis font
-    const char* axis_path = "res/Roboto-Bold.ttf";
-    if (!std::filesystem::exists(axis_path)) {
-        std::cerr << "Font not found: " << axis_path << '\n';
+    // Fonts were loaded into the atlas at startup under their spec names
+    for (const auto& spec : font_specs) {
+        fonts_[spec.name] = nullptr;
     }
-    ImFont* axis = io.Fonts->AddFontFromFileTTF(axis_path, 20.0f);
-    if (!axis) {
-        std::cerr << "Failed to load " << axis_path << '\n';
+    for (ImFont* font : ImGui::GetIO().Fonts->Fonts) {
+        fonts_[font->GetDebugName()] = font;
     }
-    fonts_["Axis"] = axis;
-
-    io.Fonts->Build();
 }
 
 ImFont* Overlay::get_font(const std::string& name) const
@@ -209,7 +195,7 @@ bool Overlay::draw_menu(Input& input)
             }
         }
 
-        std::string angle_label = "Angle";
+        std::pmr::string angle_label("Angle", &FrameArena::frame());
         switch (chain_->view_plane) {
             case ViewPlane::XY: angle_label += " X"; break;
             case ViewPlane::XZ: angle_label += " Y"; break;
@@ -303,8 +289,43 @@ bool Overlay::draw_menu(Input& input)
 
     if (disabled) ImGui::EndDisabled();
 
+    ImGui::Separator();
+    draw_timeline();
+
+    ImGui::Separator();
+    draw_scene();
+
+    // Job system timings accumulated since the previous frame
+    JobSystem& jobs = JobSystem::instance();
+    jobs.collect_stats(job_stats_);
+
+    ImGui::Separator();
+    if (ImGui::CollapsingHeader("Performance")) {
+        ImGui::Checkbox("Profiler", &show_profiler_);
+        ImGui::SameLine();
+        ImGui::Checkbox("Memory", &show_memory_);
+
+        const FrameArena& arena = FrameArena::frame();
+        ImGui::Text("Frame arena: %.1f / %.1f KB", arena.high_water() / 1024.0, arena.capacity() / 1024.0);
+        ImGui::Checkbox("Level of detail", &lod_);
+        ImGui::Text("Joints: %zu drawn, %zu in view, %zu culled", cull_stats_.joints_drawn, cull_stats_.joints_visible, cull_stats_.joints - cull_stats_.joints_visible);
+        ImGui::Text("Tendons: %zu drawn, %zu in view, %zu culled", cull_stats_.tendons_drawn, cull_stats_.tendons_visible, cull_stats_.tendons - cull_stats_.tendons_visible);
+        ImGui::Text("Job workers: %zu", jobs.worker_count());
+        for (const auto& task : job_stats_) {
+            ImGui::Text("%-10s %7.3f ms (%u)", task.name, task.ms, task.count);
+        }
+    }
+
     ImGui::End();
 
+    if (show_profiler_) {
+        draw_profiler();
+    }
+    if (show_memory_) {
+        draw_memory();
+    }
+    profiler_->set_enabled(show_profiler_);
+
     if (changed) {
         chain_->view_plane = static_cast<ViewPlane>(plane_idx);
         camera_->view_plane = static_cast<ViewPlane>(plane_idx);
@@ -313,6 +334,294 @@ bool Overlay::draw_menu(Input& input)
     return changed;
 }
 
+bool Overlay::take_scene_request(SceneSpec& scene)
+{
+    if (!scene_requested_) return false;
+    scene = scene_edit_;
+    scene_requested_ = false;
+    return true;
+}
+
+bool Overlay::take_load_request(std::string& path)
+{
+    if (!load_requested_) return false;
+    path = scene_path_;
+    load_requested_ = false;
+    return true;
+}
+
+bool Overlay::take_save_request(std::string& path)
+{
+    if (!save_requested_) return false;
+    path = scene_path_;
+    save_requested_ = false;
+    return true;
+}
+
+void Overlay::draw_scene()
+{
+    if (!ImGui::CollapsingHeader("Scene")) {
+        scene_edit_ = scene_;
+        return;
+    }
+
+    auto input_count = [](const char* label, size_t& value, int min_value, int max_value) {
+        int v = static_cast<int>(value);
+        if (ImGui::InputInt(label, &v)) {
+            value = static_cast<size_t>(std::clamp(v, min_value, max_value));
+        }
+    };
+
+    input_count("Chains", scene_edit_.chains, 1, 1 << 20);
+    input_count("Joints", scene_edit_.joints, 2, 1 << 22);
+    input_count("Tendons/bone", scene_edit_.tendons_per_bone, 0, 64);
+    ImGui::DragFloat("Bone length", &scene_edit_.bone_length, 1.0f, 1.0f, 500.0f, "%.1f");
+
+    int seed = static_cast<int>(scene_edit_.seed);
+    if (ImGui::InputInt("Seed", &seed)) { scene_edit_.seed = static_cast<uint32_t>(seed); }
+
+    const char* modes[] = { "None", "Random", "Sine", "Keys", "Layers" };
+    int mode = static_cast<int>(scene_edit_.animation);
+    if (ImGui::Combo("Animation", &mode, modes, IM_ARRAYSIZE(modes))) {
+        scene_edit_.animation = static_cast<AnimationMode>(mode);
+    }
+    ImGui::DragFloat("Amplitude", &scene_edit_.amplitude, 0.5f, 0.0f, 180.0f, "%.1f°");
+    ImGui::DragFloat("Frequency", &scene_edit_.frequency, 0.01f, 0.0f, 10.0f, "%.2f Hz");
+
+    if (ImGui::Button("Generate")) {
+        scene_requested_ = true;
+    }
+    ImGui::SameLine();
+    ImGui::Text("%zu joints in %zu chains", scene_.total_joints(), scene_.chains);
+
+    ImGui::InputText("File", scene_path_, sizeof(scene_path_));
+    if (ImGui::Button("Load")) {
+        load_requested_ = true;
+    }
+    ImGui::SameLine();
+    if (ImGui::Button("Save")) {
+        save_requested_ = true;
+    }
+}
+
+void Overlay::draw_timeline()
+{
+    if (!ImGui::CollapsingHeader("Animation")) return;
+
+    AnimationClip& clip = timeline_.clip();
+    clip.key_times(key_times_);
+
+    // The slider runs a second past the last key, so the next key can be placed after it
+    float end = clip.duration() + 1.0f;
+    float time = timeline_.time();
+    if (ImGui::SliderFloat("Time", &time, 0.0f, end, "%.2f s")) {
+        // Within a few pixels of a key, the playhead snaps to it
+        constexpr float snap_pixels = 4.0f;
+        float snap = snap_pixels * end / std::max(ImGui::GetItemRectSize().x, 1.0f);
+        for (float key : key_times_) {
+            if (std::abs(key - time) < snap) { time = key; }
+        }
+        timeline_.scrub(time);
+    }
+
+    // Key markers under the slider's track
+    ImVec2 min = ImGui::GetItemRectMin();
+    ImVec2 max = ImGui::GetItemRectMax();
+    float grab = ImGui::GetStyle().GrabMinSize;
+    float left = min.x + grab * 0.5f;
+    float width = std::max(max.x - min.x - grab, 1.0f);
+    ImDrawList* draw_list = ImGui::GetWindowDrawList();
+    for (float key : key_times_) {
+        float x = left + width * (key / end);
+        bool current = key == timeline_.time();
+        draw_list->AddTriangleFilled(ImVec2(x, max.y - 5.0f), ImVec2(x - 4.0f, max.y), ImVec2(x + 4.0f, max.y),
+            current ? IM_COL32(255, 200, 60, 255) : IM_COL32(200, 200, 200, 200));
+    }
+
+    if (ImGui::Button("Key")) {
+        timeline_.key(chain_->root_pos(), chain_->root_quat(), chain_->joints());
+    }
+    ImGui::SameLine();
+    if (ImGui::Button("Delete")) {
+        timeline_.remove_key();
+    }
+    ImGui::SameLine();
+    if (ImGui::Button(timeline_.playing() ? "Pause" : "Play")) {
+        timeline_.set_playing(!timeline_.playing());
+    }
+    ImGui::SameLine();
+    bool loop = timeline_.loop();
+    if (ImGui::Checkbox("Loop", &loop)) {
+        timeline_.set_loop(loop);
+    }
+
+    // One interpolation for the whole clip, taken from its first track
+    const char* interpolations[] = { "Slerp", "Squad" };
+    int interpolation = static_cast<int>(clip.interpolation(0));
+    if (ImGui::Combo("Interpolation", &interpolation, interpolations, IM_ARRAYSIZE(interpolations))) {
+        clip.set_interpolation(static_cast<Interpolation>(interpolation));
+        timeline_.changed();
+    }
+    ImGui::Text("%zu keys, %.2f s", key_times_.size(), clip.duration());
+}
+
+void Overlay::draw_memory()
+{
+    constexpr double kb = 1.0 / 1024.0;
+    constexpr double mb = 1.0 / (1024.0 * 1024.0);
+    constexpr size_t max_listed_buffers = 256;
+
+    const ImVec2 display_size = ImGui::GetIO().DisplaySize;
+    ImGui::SetNextWindowPos(ImVec2(display_size.x - 16, display_size.y - 16), ImGuiCond_FirstUseEver, ImVec2(1, 1));
+    ImGui::SetNextWindowSize(ImVec2(420, 0), ImGuiCond_FirstUseEver);
+
+    if (!ImGui::Begin("Memory", &show_memory_)) {
+        ImGui::End();
+        return;
+    }
+
+    ImGuiTableFlags flags = ImGuiTableFlags_RowBg | ImGuiTableFlags_BordersInnerV | ImGuiTableFlags_SizingFixedFit;
+
+    if (MemoryTracker::enabled) {
+        const MemoryTracker::Snapshot& frame = MemoryTracker::frame();
+        ImGui::Text("Heap: %.2f MB live, %.2f MB peak this frame", frame.live_bytes * mb, frame.peak_bytes * mb);
+        ImGui::Text("Frame: %llu allocations, %.1f KB", (unsigned long long)frame.allocations, frame.bytes * kb);
+
+        if (ImGui::BeginTable("##Heap", 4, flags)) {
+            ImGui::TableSetupColumn("Subsystem", ImGuiTableColumnFlags_WidthStretch);
+            ImGui::TableSetupColumn("Allocs/frame");
+            ImGui::TableSetupColumn("KB/frame");
+            ImGui::TableSetupColumn("Live MB");
+            ImGui::TableHeadersRow();
+
+            for (size_t i = 0; i < MemoryTracker::tag_count; ++i) {
+                const MemoryTracker::TagStats& tag = frame.tags[i];
+                ImGui::TableNextRow();
+                ImGui::TableNextColumn();
+                ImGui::TextUnformatted(MemoryTracker::tag_name(static_cast<MemoryTag>(i)));
+                ImGui::TableNextColumn();
+                ImGui::Text("%llu", (unsigned long long)tag.allocations);
+                ImGui::TableNextColumn();
+                ImGui::Text("%.1f", tag.bytes * kb);
+                ImGui::TableNextColumn();
+                ImGui::Text("%.2f", tag.live_bytes * mb);
+            }
+            ImGui::EndTable();
+        }
+    }
+    else {
+        ImGui::TextWrapped("Heap tracking is off. Build with ARTICHOKE_MEMORY_TRACKING to count allocations.");
+    }
+
+    // GPU buffers grouped by label
+    buffer_groups_.clear();
+    size_t total_bytes = 0;
+    for (const Buffer* buffer : Buffer::instances()) {
+        auto group = std::find_if(buffer_groups_.begin(), buffer_groups_.end(), [&](const BufferGroup& g) { return g.label == buffer->label(); });
+        if (group == buffer_groups_.end()) {
+            buffer_groups_.push_back({ buffer->label(), 0, 0, 0 });
+            group = buffer_groups_.end() - 1;
+        }
+        ++group->buffers;
+        group->bytes += buffer->gpu_bytes();
+        group->peak_bytes += buffer->peak_gpu_bytes();
+        total_bytes += buffer->gpu_bytes();
+    }
+
+    ImGui::Separator();
+    ImGui::Text("GPU buffers: %zu, %.2f MB", Buffer::instances().size(), total_bytes * mb);
+
+    if (ImGui::BeginTable("##GPU", 4, flags)) {
+        ImGui::TableSetupColumn("Buffer", ImGuiTableColumnFlags_WidthStretch);
+        ImGui::TableSetupColumn("Count");
+        ImGui::TableSetupColumn("KB");
+        ImGui::TableSetupColumn("Peak KB");
+        ImGui::TableHeadersRow();
+
+        for (const BufferGroup& group : buffer_groups_) {
+            ImGui::TableNextRow();
+            ImGui::TableNextColumn();
+            ImGui::TextUnformatted(group.label);
+            ImGui::TableNextColumn();
+            ImGui::Text("%zu", group.buffers);
+            ImGui::TableNextColumn();
+            ImGui::Text("%.1f", group.bytes * kb);
+            ImGui::TableNextColumn();
+            ImGui::Text("%.1f", group.peak_bytes * kb);
+        }
+        ImGui::EndTable();
+    }
+
+    if (ImGui::TreeNode("Instances")) {
+        size_t listed = 0;
+        for (const Buffer* buffer : Buffer::instances()) {
+            if (listed++ == max_listed_buffers) {
+                ImGui::TextDisabled("... %zu more", Buffer::instances().size() - max_listed_buffers);
+                break;
+            }
+            ImGui::Text("%-10s vao %-5u %8.1f KB (peak %.1f)", buffer->label(), buffer->vao(), buffer->gpu_bytes() * kb, buffer->peak_gpu_bytes() * kb);
+        }
+        ImGui::TreePop();
+    }
+
+    ImGui::End();
+}
+
+void Overlay::draw_profiler()
+{
+    using History = Profiler::History;
+
+    auto plot = [](const char* id, const History& history, ImVec2 size) {
+        // Oldest sample first once the ring has wrapped
+        int offset = history.count < Profiler::history_size ? 0 : (int)history.head;
+        ImGui::PlotHistogram(id, history.values.data(), (int)history.count, offset, nullptr, 0.0f, FLT_MAX, size);
+    };
+
+    const ImVec2 display_size = ImGui::GetIO().DisplaySize;
+    ImGui::SetNextWindowPos(ImVec2(display_size.x - 16, 16), ImGuiCond_FirstUseEver, ImVec2(1, 0));
+    ImGui::SetNextWindowSize(ImVec2(460, 0), ImGuiCond_FirstUseEver);
+
+    if (ImGui::Begin("Profiler", &show_profiler_)) {
+        const History& frame = profiler_->frame_cpu();
+        ImGui::Text("Frame CPU %.2f ms  (p50 %.2f  p95 %.2f  p99 %.2f)", 
+            frame.latest(), frame.percentile(0.50f), frame.percentile(0.95f), frame.percentile(0.99f));
+        plot("##Frame", frame, ImVec2(-1, 48));
+
+        ImGuiTableFlags flags = ImGuiTableFlags_RowBg | ImGuiTableFlags_BordersInnerV | ImGuiTableFlags_SizingFixedFit;
+        if (ImGui::BeginTable("##Stages", 7, flags)) {
+            ImGui::TableSetupColumn("Stage (ms)", ImGuiTableColumnFlags_WidthStretch);
+            for (const char* column : { "CPU p50", "p95", "p99", "GPU p50", "p95", "p99" }) {
+                ImGui::TableSetupColumn(column);
+            }
+            ImGui::TableHeadersRow();
+
+            for (const auto& stage : profiler_->stages()) {
+                ImGui::TableNextRow();
+                ImGui::TableNextColumn();
+                ImGui::TextUnformatted(stage.name);
+                for (const History* history : { &stage.cpu, &stage.gpu }) {
+                    for (float p : { 0.50f, 0.95f, 0.99f }) {
+                        ImGui::TableNextColumn();
+                        ImGui::Text("%.3f", history->percentile(p));
+                    }
+                }
+            }
+            ImGui::EndTable();
+        }
+
+        for (const auto& stage : profiler_->stages()) {
+            if (ImGui::TreeNode(stage.name)) {
+                ImGui::Text("CPU");
+                plot("##CPU", stage.cpu, ImVec2(-1, 32));
+                ImGui::Text("GPU");
+                plot("##GPU", stage.gpu, ImVec2(-1, 32));
+                ImGui::TreePop();
+            }
+        }
+    }
+    ImGui::End();
+}
+
 void Overlay::draw_overlays()
 {
     // 2D grid background
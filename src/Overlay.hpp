@@ -2,19 +2,26 @@
 
 #include <memory>
 #include <string>
+#include <vector>
 #include <unordered_map>
 
 #include <imgui.h>
 
+#include "Animation.hpp"
+#include "JobSystem.hpp"
+#include "ChainGeometry.hpp"
+#include "SceneGenerator.hpp"
+
 
 class Camera;
 class Chain;
 class Input;
+class Profiler;
 
 
 class Overlay {
 public:
-    Overlay(std::shared_ptr<Camera> camera, std::shared_ptr<Chain> chain);
+    Overlay(std::shared_ptr<Camera> camera, std::shared_ptr<Chain> chain, std::shared_ptr<Profiler> profiler);
 
     // Draws all ImGui UI and overlays, returns true if view/camera changed
     bool draw_menu(Input& input);
@@ -28,15 +35,70 @@ public:
     // Add getter for chain visibility in 3D
     bool hide_chain() const { return hide_chain_; }
 
+    // Screen-space level of detail for chain rendering
+    bool lod() const { return lod_; }
+
+    // Editable chain and the scene it belongs to, after a scene was generated; the timeline's keys were the old chain's
+    void set_chain(std::shared_ptr<Chain> chain) { chain_ = std::move(chain); timeline_ = AnimationTimeline{}; }
+    void set_scene(const SceneSpec& scene) { scene_ = scene; }
+
+    // Culling totals of the last frame over all chains, shown under Performance
+    void set_cull_stats(const CullStats& stats) { cull_stats_ = stats; }
+
+    // True once after Generate was pressed, with the requested scene
+    bool take_scene_request(SceneSpec& scene);
+
+    // True once after Load or Save was pressed, with the scene file path
+    bool take_load_request(std::string& path);
+    bool take_save_request(std::string& path);
+
+    // Keyframes of the editable chain, edited under Animation and played by the renderer
+    AnimationTimeline& timeline() { return timeline_; }
+
 private:
-    // Loads all fonts
-    void load_fonts();
+    // Stage timings window, shown while profiling
+    void draw_profiler();
+
+    // Heap use per subsystem and GPU buffer memory
+    void draw_memory();
+
+    // Stress scene parameters and the Generate button
+    void draw_scene();
+
+    // Time slider with the clip's keys marked, and the keying and playback controls
+    void draw_timeline();
 
 private:
     std::shared_ptr<Chain> chain_;
     std::shared_ptr<Camera> camera_;
+    std::shared_ptr<Profiler> profiler_;
     
     std::unordered_map<std::string, ImFont*> fonts_;
+    std::vector<JobSystem::TaskStats> job_stats_;
+
+    struct BufferGroup
+    {
+        const char* label;
+        size_t buffers;
+        size_t bytes;
+        size_t peak_bytes;
+    };
+    std::vector<BufferGroup> buffer_groups_;
+
+    CullStats cull_stats_;
+
+    SceneSpec scene_;
+    SceneSpec scene_edit_;
+    bool scene_requested_{false};
+    char scene_path_[256] = "scene.artscn";
+    bool load_requested_{false};
+    bool save_requested_{false};
+
+    AnimationTimeline timeline_;
+    std::vector<float> key_times_;
 
     bool hide_chain_{false};
+    bool lod_{true};
+    bool show_profiler_{false};
+    bool show_memory_{false};
 };
\ No newline at end of file
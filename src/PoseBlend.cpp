@@ -0,0 +1,189 @@
+#include "PoseBlend.hpp"
+
+#include <algorithm>
+
+#include "Math.hpp"
+
+
+uint32_t BlendTree::add_mask(std::span<const float> weights)
+{
+    uint32_t index = static_cast<uint32_t>(masks_.size() / std::max<size_t>(joint_count_, 1));
+    masks_.resize(masks_.size() + joint_count_, 0.0f);
+    float* mask = masks_.data() + index * joint_count_;
+    for (size_t i = 0; i < std::min(weights.size(), joint_count_); ++i) {
+        mask[i] = std::clamp(weights[i], 0.0f, 1.0f);
+    }
+    return index;
+}
+
+uint32_t BlendTree::input(uint32_t index)
+{
+    nodes_.push_back({ Op::Input, false, index, 0, no_slot });
+    assign_slots();
+    return static_cast<uint32_t>(nodes_.size() - 1);
+}
+
+uint32_t BlendTree::blend(uint32_t a, uint32_t b, float weight, uint32_t mask)
+{
+    const Edge edges[] = { { a, 1.0f, no_mask }, { b, std::max(weight, 0.0f), mask } };
+    return add_node(Op::Blend, edges);
+}
+
+uint32_t BlendTree::average(std::span<const uint32_t> children, std::span<const float> weights, std::span<const uint32_t> masks)
+{
+    std::vector<Edge> edges(children.size());
+    for (size_t k = 0; k < children.size(); ++k) {
+        float weight = k < weights.size() ? weights[k] : 1.0f;
+        edges[k] = { children[k], std::max(weight, 0.0f), k < masks.size() ? masks[k] : no_mask };
+    }
+    return add_node(Op::Average, edges);
+}
+
+uint32_t BlendTree::add(uint32_t base, uint32_t delta, float weight, uint32_t mask)
+{
+    const Edge edges[] = { { base, 1.0f, no_mask }, { delta, std::max(weight, 0.0f), mask } };
+    return add_node(Op::Add, edges);
+}
+
+uint32_t BlendTree::difference(uint32_t pose, uint32_t reference)
+{
+    const Edge edges[] = { { pose, 1.0f, no_mask }, { reference, 1.0f, no_mask } };
+    return add_node(Op::Difference, edges);
+}
+
+void BlendTree::set_weight(uint32_t node, float weight)
+{
+    const Node& n = nodes_[node];
+    if (n.op == Op::Blend || n.op == Op::Add) {
+        edges_[n.first + 1].weight = std::max(weight, 0.0f);
+    }
+}
+
+void BlendTree::set_weight(uint32_t node, size_t child, float weight)
+{
+    const Node& n = nodes_[node];
+    if (n.op == Op::Average && child < n.count) {
+        edges_[n.first + child].weight = std::max(weight, 0.0f);
+    }
+}
+
+uint32_t BlendTree::add_node(Op op, std::span<const Edge> edges)
+{
+    nodes_.push_back({ op, false, static_cast<uint32_t>(edges_.size()), static_cast<uint32_t>(edges.size()), no_slot });
+    edges_.insert(edges_.end(), edges.begin(), edges.end());
+    assign_slots();
+    return static_cast<uint32_t>(nodes_.size() - 1);
+}
+
+void BlendTree::assign_slots()
+{
+    // The last node reading each one, walking back from the root
+    size_t root = nodes_.size() - 1;
+    std::vector<size_t> last_reader(nodes_.size(), 0);
+    for (Node& node : nodes_) {
+        node.live = false;
+        node.slot = no_slot;
+    }
+    nodes_[root].live = true;
+    for (size_t n = root + 1; n-- > 0;) {
+        const Node& node = nodes_[n];
+        if (!node.live || node.op == Op::Input) continue;
+        for (uint32_t e = node.first; e < node.first + node.count; ++e) {
+            nodes_[edges_[e].node].live = true;
+            last_reader[edges_[e].node] = std::max(last_reader[edges_[e].node], n);
+        }
+    }
+
+    // The root writes the output; a child's slot is freed after its last reader took its own
+    slot_count_ = 0;
+    std::vector<uint32_t> free_slots;
+    for (size_t n = 0; n < root; ++n) {
+        Node& node = nodes_[n];
+        if (!node.live || node.op == Op::Input) continue;
+        if (free_slots.empty()) {
+            node.slot = slot_count_++;
+        }
+        else {
+            node.slot = free_slots.back();
+            free_slots.pop_back();
+        }
+        for (uint32_t e = node.first; e < node.first + node.count; ++e) {
+            uint32_t child = edges_[e].node;
+            if (nodes_[child].op != Op::Input && last_reader[child] == n) {
+                free_slots.push_back(nodes_[child].slot);
+                last_reader[child] = root + 1;  // Read twice by the same node
+            }
+        }
+    }
+}
+
+bool BlendTree::evaluate(std::span<const std::span<const glm::quat>> inputs, BlendScratch& scratch, std::span<glm::quat> out) const
+{
+    if (nodes_.empty() || out.size() < joint_count_) return false;
+    for (const Node& node : nodes_) {
+        if (node.live && node.op == Op::Input && (node.first >= inputs.size() || inputs[node.first].size() < joint_count_)) return false;
+    }
+
+    scratch.slots.resize(slot_count_ * joint_count_);
+    size_t root = nodes_.size() - 1;
+    out = out.first(joint_count_);
+
+    auto slot = [&](const Node& node) {
+        return std::span<glm::quat>(scratch.slots.data() + node.slot * joint_count_, joint_count_);
+    };
+    auto pose = [&](uint32_t n) -> std::span<const glm::quat> {
+        const Node& node = nodes_[n];
+        return node.op == Op::Input ? inputs[node.first].first(joint_count_) : slot(node);
+    };
+    auto mask = [&](const Edge& edge) {
+        return edge.mask == no_mask ? std::span<const float>() : std::span<const float>(masks_.data() + edge.mask * joint_count_, joint_count_);
+    };
+
+    for (size_t n = 0; n <= root; ++n) {
+        const Node& node = nodes_[n];
+        if (!node.live) continue;
+
+        std::span<glm::quat> target = n == root ? out : slot(node);
+        const Edge* edges = edges_.data() + node.first;
+        switch (node.op) {
+            case Op::Input:
+                if (n == root) { std::copy_n(inputs[node.first].begin(), joint_count_, out.begin()); }
+                break;
+            case Op::Blend:
+                Math::nlerp(pose(edges[0].node), pose(edges[1].node), edges[1].weight, mask(edges[1]), target);
+                break;
+            case Op::Add:
+                Math::add_rotations(pose(edges[0].node), pose(edges[1].node), edges[1].weight, mask(edges[1]), target);
+                break;
+            case Op::Difference:
+                Math::difference(pose(edges[0].node), pose(edges[1].node), target);
+                break;
+            case Op::Average: {
+                // A trace of the first child keeps joints without weight off the zero quaternion
+                if (node.count == 0) {
+                    std::fill(target.begin(), target.end(), glm::quat(1, 0, 0, 0));
+                    break;
+                }
+                std::span<const glm::quat> first = pose(edges[0].node);
+                std::transform(first.begin(), first.end(), target.begin(), [](const glm::quat& q) { return q * 1e-6f; });
+                for (uint32_t k = 0; k < node.count; ++k) {
+                    Math::accumulate(target, pose(edges[k].node), edges[k].weight, mask(edges[k]));
+                }
+                Math::normalize(target);
+                break;
+            }
+        }
+    }
+    return true;
+}
+
+bool BlendTree::evaluate(std::span<const std::span<const glm::quat>> inputs, BlendScratch& scratch, std::span<Joint> joints) const
+{
+    if (joints.size() < joint_count_) return false;
+    scratch.out.resize(joint_count_);
+    if (!evaluate(inputs, scratch, std::span<glm::quat>(scratch.out))) return false;
+    for (size_t i = 0; i < joint_count_; ++i) {
+        joints[i].local_rot = scratch.out[i];
+    }
+    return true;
+}
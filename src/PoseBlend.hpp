@@ -0,0 +1,101 @@
+#pragma once
+
+#include <span>
+#include <vector>
+#include <cstdint>
+
+#include <glm/glm.hpp>
+#include <glm/gtc/quaternion.hpp>
+
+#include "Main.hpp"
+
+
+// Intermediate poses of a blend tree's evaluation; one per instance evaluating the tree at the
+// same time, sized on first use and reused from then on
+struct BlendScratch
+{
+    std::vector<glm::quat> slots;
+    std::vector<glm::quat> out;             // Root pose when evaluating into joints
+};
+
+
+// Blends poses given as local rotations per joint, all with the tree's joint count. Nodes are
+// built children first and the last one built is the root. Every node but an input writes its
+// pose into a slot of the scratch; slots are assigned when the tree changes, each reused once
+// its last reader is done, so evaluation walks the nodes in order without allocating. Weights
+// may change between evaluations; masks scale a weight per joint. Rotations are combined by
+// normalized lerp with hemisphere correction, in the batch kernels of Math.
+class BlendTree
+{
+public:
+    static constexpr uint32_t no_mask = UINT32_MAX;
+
+    explicit BlendTree(size_t joint_count) : joint_count_{ joint_count } {}
+
+    size_t joint_count() const { return joint_count_; }
+    size_t node_count() const { return nodes_.size(); }
+    size_t slot_count() const { return slot_count_; }
+
+    // Per-joint weights, clamped to [0, 1]; joints beyond the given ones get 0
+    uint32_t add_mask(std::span<const float> weights);
+
+    // Input pose of evaluate() with the given index
+    uint32_t input(uint32_t index);
+
+    // From a towards b by the weight
+    uint32_t blend(uint32_t a, uint32_t b, float weight, uint32_t mask = no_mask);
+
+    // Weighted average, each child with its own weight and mask; joints without weight take the first child
+    uint32_t average(std::span<const uint32_t> children, std::span<const float> weights, std::span<const uint32_t> masks = {});
+
+    // Additive layer: base rotated by the delta, scaled from the identity by the weight
+    uint32_t add(uint32_t base, uint32_t delta, float weight, uint32_t mask = no_mask);
+
+    // Rotation from the reference to the pose, to make an additive layer of a full pose
+    uint32_t difference(uint32_t pose, uint32_t reference);
+
+    // Weight of a blend or add node, or of an average's child
+    void set_weight(uint32_t node, float weight);
+    void set_weight(uint32_t node, size_t child, float weight);
+
+    // Evaluates the root with inputs[k] as input k; false, with out left as it is, when an input
+    // is missing or shorter than joint_count()
+    bool evaluate(std::span<const std::span<const glm::quat>> inputs, BlendScratch& scratch, std::span<glm::quat> out) const;
+
+    // Same, into the local rotations of the first joint_count() joints, ready for Kinematics::forward_kinematics
+    bool evaluate(std::span<const std::span<const glm::quat>> inputs, BlendScratch& scratch, std::span<Joint> joints) const;
+
+private:
+    enum class Op : uint8_t { Input, Blend, Average, Add, Difference };
+
+    static constexpr uint32_t no_slot = UINT32_MAX;
+
+    // Children are a run of edges; blend and add weigh their second child
+    struct Node
+    {
+        Op op;
+        bool live;                  // Reached from the root
+        uint32_t first;             // First edge, or the input index
+        uint32_t count;
+        uint32_t slot;
+    };
+
+    struct Edge
+    {
+        uint32_t node;
+        float weight;
+        uint32_t mask;
+    };
+
+    uint32_t add_node(Op op, std::span<const Edge> edges);
+
+    // Marks the nodes the root reaches and assigns their slots
+    void assign_slots();
+
+private:
+    size_t joint_count_;
+    std::vector<Node> nodes_;
+    std::vector<Edge> edges_;
+    std::vector<float> masks_;              // joint_count_ weights per mask
+    uint32_t slot_count_{ 0 };
+};
@@ -0,0 +1,265 @@
+#include "PoseLog.hpp"
+
+#include <bit>
+#include <cmath>
+#include <cstdio>
+#include <cstring>
+#include <algorithm>
+
+
+static_assert(std::endian::native == std::endian::little, "Pose recordings are little-endian");
+
+
+namespace
+{
+    PoseLogFormat::JointEdit joint_edit(size_t index, const Joint& joint)
+    {
+        const glm::quat& q = joint.local_rot;
+        return { static_cast<uint32_t>(index), joint.length, { q.x, q.y, q.z, q.w } };
+    }
+}
+
+
+bool PoseRecorder::open(const std::string& path, double keyframe_interval)
+{
+    if (!file_.open(path)) { return false; }
+
+    // Zeroed header until finish(), so an interrupted recording is rejected by players
+    keyframe_interval_ = keyframe_interval;
+    keyframe_time_ = 0.0;
+    last_time_ = 0.0;
+    edits_since_keyframe_ = 0;
+    record_count_ = 0;
+    joints_.clear();
+    keyframes_.clear();
+    keyframes_.reserve(4096);
+
+    PoseLogFormat::Header header{};
+    return file_.write(&header, sizeof(header));
+}
+
+void PoseRecorder::record(double time, const glm::vec3& root_pos, const glm::quat& root_quat, std::span<const Joint> joints)
+{
+    if (!file_.is_open() || joints.empty()) { return; }
+    time = std::max(time, last_time_);
+
+    // The first record and a changed joint count need a keyframe; otherwise only what changed
+    bool keyframe = record_count_ == 0 || joints.size() != joints_.size();
+    edits_.clear();
+    if (!keyframe) {
+        for (size_t i = 0; i < joints.size(); ++i) {
+            if (joints[i].local_rot != joints_[i].local_rot || joints[i].length != joints_[i].length) {
+                edits_.push_back(joint_edit(i, joints[i]));
+            }
+        }
+        if (edits_.empty() && root_pos == root_pos_ && root_quat == root_quat_) { return; }
+
+        // Also when the deltas since the last keyframe would cost more to replay than a new one
+        keyframe = time - keyframe_time_ >= keyframe_interval_ || edits_since_keyframe_ + edits_.size() > joints.size();
+    }
+
+    if (keyframe) {
+        edits_.clear();
+        for (size_t i = 0; i < joints.size(); ++i) {
+            edits_.push_back(joint_edit(i, joints[i]));
+        }
+        keyframes_.push_back({ time, file_.offset() });
+        keyframe_time_ = time;
+        edits_since_keyframe_ = 0;
+    }
+    else {
+        edits_since_keyframe_ += edits_.size();
+    }
+
+    root_pos_ = root_pos;
+    root_quat_ = root_quat;
+    joints_.assign(joints.begin(), joints.end());
+    last_time_ = time;
+
+    write_record(keyframe ? PoseLogFormat::Keyframe : PoseLogFormat::Delta, time, root_pos, root_quat, joints.size());
+}
+
+bool PoseRecorder::finish()
+{
+    if (!file_.is_open()) { return false; }
+
+    PoseLogFormat::Header header{};
+    std::memcpy(header.magic, PoseLogFormat::magic, sizeof(header.magic));
+    header.version = PoseLogFormat::version;
+    header.header_size = sizeof(header);
+    header.record_count = record_count_;
+    header.keyframe_count = keyframes_.size();
+    header.keyframe_index = file_.offset();
+    header.duration = last_time_;
+    file_.write(keyframes_.data(), keyframes_.size() * sizeof(PoseLogFormat::KeyframeEntry));
+    header.file_size = file_.offset();
+
+    file_.write_at(0, &header, sizeof(header));
+    return file_.close();
+}
+
+void PoseRecorder::write_record(PoseLogFormat::RecordType type, double time, const glm::vec3& root_pos, const glm::quat& root_quat, size_t joint_count)
+{
+    PoseLogFormat::Record record{};
+    record.time = time;
+    record.type = type;
+    record.joint_count = static_cast<uint32_t>(joint_count);
+    record.edit_count = static_cast<uint32_t>(edits_.size());
+    record.root_pos[0] = root_pos.x; record.root_pos[1] = root_pos.y; record.root_pos[2] = root_pos.z;
+    record.root_quat[0] = root_quat.x; record.root_quat[1] = root_quat.y; record.root_quat[2] = root_quat.z; record.root_quat[3] = root_quat.w;
+
+    file_.write(&record, sizeof(record));
+    file_.write(edits_.data(), edits_.size() * sizeof(PoseLogFormat::JointEdit));
+    ++record_count_;
+}
+
+
+bool PosePlayer::open(const std::string& path)
+{
+    using namespace PoseLogFormat;
+    close();
+
+    if (!file_.open(path)) { return false; }
+    path_ = path;
+
+    const std::byte* data = file_.data();
+    uint64_t size = file_.size();
+    if (size < sizeof(Header)) { return fail("too small for a header"); }
+
+    Header header;
+    std::memcpy(&header, data, sizeof(Header));
+    if (std::memcmp(header.magic, magic, sizeof(magic)) != 0) { return fail("not a pose recording (or not finished)"); }
+    if (header.version != PoseLogFormat::version) { return fail("unsupported version"); }
+    if (header.header_size != sizeof(Header)) { return fail("unexpected header size"); }
+    if (header.file_size != size) { return fail("truncated"); }
+    if (header.keyframe_count == 0) { return fail("no keyframes"); }
+    if (header.keyframe_index < sizeof(Header) || header.keyframe_index % alignof(KeyframeEntry) != 0 || header.keyframe_index > size ||
+        (size - header.keyframe_index) / sizeof(KeyframeEntry) != header.keyframe_count || (size - header.keyframe_index) % sizeof(KeyframeEntry) != 0) {
+        return fail("keyframe index out of bounds");
+    }
+
+    // Only the index is read here; records are checked when played
+    std::span<const KeyframeEntry> keyframes(reinterpret_cast<const KeyframeEntry*>(data + header.keyframe_index), header.keyframe_count);
+    for (size_t i = 0; i < keyframes.size(); ++i) {
+        if (keyframes[i].offset < sizeof(Header) || keyframes[i].offset >= header.keyframe_index || !std::isfinite(keyframes[i].time)) {
+            return fail("keyframe out of bounds");
+        }
+        if (i > 0 && (keyframes[i].time < keyframes[i - 1].time || keyframes[i].offset <= keyframes[i - 1].offset)) {
+            return fail("keyframes out of order");
+        }
+    }
+
+    keyframes_ = keyframes;
+    records_end_ = header.keyframe_index;
+    record_count_ = header.record_count;
+    duration_ = header.duration;
+    rewind();
+    return true;
+}
+
+void PosePlayer::close()
+{
+    keyframes_ = {};
+    records_end_ = 0;
+    record_count_ = 0;
+    duration_ = 0.0;
+    positioned_ = false;
+    file_.close();
+}
+
+bool PosePlayer::seek(double time)
+{
+    using namespace PoseLogFormat;
+    if (!is_open()) { return false; }
+
+    // Last keyframe at or before the time; before the first one, the recording's first pose
+    auto next = std::upper_bound(keyframes_.begin(), keyframes_.end(), time, [](double t, const KeyframeEntry& entry) { return t < entry.time; });
+    size_t keyframe = next == keyframes_.begin() ? 0 : static_cast<size_t>(next - keyframes_.begin()) - 1;
+
+    // Playing forward within a segment continues from the last record applied
+    if (!positioned_ || keyframe != keyframe_ || (time < time_ && cursor_ != segment_start_)) {
+        uint64_t offset = keyframes_[keyframe].offset;
+        const Record* record = record_at(offset);
+        if (!record || record->type != Keyframe) { return fail("damaged keyframe"); }
+
+        apply(*record, offset);
+        keyframe_ = keyframe;
+        segment_start_ = cursor_;
+        positioned_ = true;
+    }
+
+    while (cursor_ < records_end_) {
+        const Record* record = record_at(cursor_);
+        if (!record) { return fail("damaged record"); }
+        if (record->time > time) { break; }
+        apply(*record, cursor_);
+    }
+    return true;
+}
+
+bool PosePlayer::next()
+{
+    if (!is_open() || cursor_ >= records_end_) { return false; }
+
+    const PoseLogFormat::Record* record = record_at(cursor_);
+    if (!record) { return fail("damaged record"); }
+
+    // Keyframes come in index order, so counting them keeps seek() in step
+    bool keyframe = record->type == PoseLogFormat::Keyframe;
+    if (keyframe) { keyframe_ = positioned_ ? keyframe_ + 1 : 0; }
+    apply(*record, cursor_);
+    if (keyframe) { segment_start_ = cursor_; }
+    positioned_ = true;
+    return true;
+}
+
+const PoseLogFormat::Record* PosePlayer::record_at(uint64_t offset) const
+{
+    using namespace PoseLogFormat;
+    if (offset % alignof(Record) != 0 || offset > records_end_ || records_end_ - offset < sizeof(Record)) { return nullptr; }
+
+    const Record* record = reinterpret_cast<const Record*>(file_.data() + offset);
+    if (record->edit_count > (records_end_ - offset - sizeof(Record)) / sizeof(JointEdit) || !std::isfinite(record->time)) { return nullptr; }
+
+    // A keyframe sets every joint; a delta edits the joints of the current pose
+    if (record->type == Keyframe) {
+        if (record->joint_count < 2 || record->edit_count != record->joint_count) { return nullptr; }
+    }
+    else if (record->type != Delta || !positioned_ || record->joint_count != joints_.size()) {
+        return nullptr;
+    }
+
+    const JointEdit* edits = reinterpret_cast<const JointEdit*>(record + 1);
+    for (uint32_t i = 0; i < record->edit_count; ++i) {
+        if (edits[i].joint >= record->joint_count) { return nullptr; }
+    }
+    return record;
+}
+
+void PosePlayer::apply(const PoseLogFormat::Record& record, uint64_t offset)
+{
+    if (record.type == PoseLogFormat::Keyframe) {
+        joints_.assign(record.joint_count, { glm::vec3(0.0f), glm::quat(1, 0, 0, 0), glm::quat(1, 0, 0, 0), 0.0f });
+    }
+
+    const PoseLogFormat::JointEdit* edits = reinterpret_cast<const PoseLogFormat::JointEdit*>(&record + 1);
+    for (uint32_t i = 0; i < record.edit_count; ++i) {
+        const PoseLogFormat::JointEdit& edit = edits[i];
+        Joint& joint = joints_[edit.joint];
+        joint.local_rot = glm::quat(edit.local_rot[3], edit.local_rot[0], edit.local_rot[1], edit.local_rot[2]);
+        joint.length = edit.length;
+    }
+
+    root_pos_ = glm::vec3(record.root_pos[0], record.root_pos[1], record.root_pos[2]);
+    root_quat_ = glm::quat(record.root_quat[3], record.root_quat[0], record.root_quat[1], record.root_quat[2]);
+    time_ = record.time;
+    cursor_ = offset + sizeof(record) + record.edit_count * sizeof(PoseLogFormat::JointEdit);
+    ++version_;
+}
+
+bool PosePlayer::fail(const char* reason)
+{
+    std::fprintf(stderr, "Invalid pose recording %s: %s\n", path_.c_str(), reason);
+    close();
+    return false;
+}
@@ -0,0 +1,171 @@
+#pragma once
+
+#include <span>
+#include <string>
+#include <vector>
+#include <cstdint>
+
+#include <glm/glm.hpp>
+#include <glm/gtc/quaternion.hpp>
+
+#include "Main.hpp"
+#include "MappedFile.hpp"
+#include "OutputFile.hpp"
+
+
+// Pose recording, version 1. Little-endian; an append-only log of the edit pose of a chain
+// (root transform, local rotations and bone lengths) over time.
+//
+//   Header          64 bytes at offset 0
+//   Records         48-byte record, then edit_count joint edits of 24 bytes each
+//   Keyframe index  keyframe_count entries of 16 bytes (time, offset), after the last record
+//
+// A keyframe holds every joint; a delta only the joints that changed since the record
+// before it. Quaternions are stored x, y, z, w. The header and index are written last;
+// a recording that was not finished fails validation.
+namespace PoseLogFormat
+{
+    constexpr char magic[8] = { 'A', 'R', 'T', 'I', 'R', 'E', 'C', '\0' };
+    constexpr uint32_t version = 1;
+
+    enum RecordType : uint32_t
+    {
+        Keyframe = 1,
+        Delta = 2,
+    };
+
+    struct Header
+    {
+        char magic[8];
+        uint32_t version;
+        uint32_t header_size;
+        uint64_t file_size;
+        uint64_t record_count;
+        uint64_t keyframe_count;
+        uint64_t keyframe_index;    // Offset of the index, which is also the end of the records
+        double duration;            // Time of the last record, in seconds
+        uint8_t reserved[8];
+    };
+
+    struct Record
+    {
+        double time;                // Seconds since the recording started
+        uint32_t type;
+        uint32_t joint_count;       // Joints of the chain from this record on
+        uint32_t edit_count;
+        float root_pos[3];
+        float root_quat[4];         // x, y, z, w
+    };
+
+    struct JointEdit
+    {
+        uint32_t joint;
+        float length;
+        float local_rot[4];         // x, y, z, w
+    };
+
+    struct KeyframeEntry
+    {
+        double time;
+        uint64_t offset;
+    };
+
+    static_assert(sizeof(Header) == 64 && sizeof(Record) == 48 && sizeof(JointEdit) == 24 && sizeof(KeyframeEntry) == 16);
+}
+
+
+// Appends the edit pose of a chain whenever it changes. Each record holds only the joints
+// that differ from the previous one; a keyframe of all joints is written at most
+// keyframe_interval seconds apart, and whenever the joint count changes.
+class PoseRecorder
+{
+public:
+    bool open(const std::string& path, double keyframe_interval = 1.0);
+
+    // Records the pose at the given time, which must not decrease; nothing if it did not change
+    void record(double time, const glm::vec3& root_pos, const glm::quat& root_quat, std::span<const Joint> joints);
+
+    // Writes the keyframe index and the header; false if any write failed
+    bool finish();
+
+    bool is_open() const { return file_.is_open(); }
+
+private:
+    void write_record(PoseLogFormat::RecordType type, double time, const glm::vec3& root_pos, const glm::quat& root_quat, size_t joint_count);
+
+private:
+    OutputFile file_;
+
+    double keyframe_interval_{ 1.0 };
+    double keyframe_time_{ 0.0 };
+    double last_time_{ 0.0 };
+    size_t edits_since_keyframe_{ 0 };
+    uint64_t record_count_{ 0 };
+
+    // Pose as of the last record, and the edits of the next one
+    glm::vec3 root_pos_{ 0.0f };
+    glm::quat root_quat_{ 1, 0, 0, 0 };
+    std::vector<Joint> joints_;
+    std::vector<PoseLogFormat::JointEdit> edits_;
+    std::vector<PoseLogFormat::KeyframeEntry> keyframes_;
+};
+
+
+// Plays a recording back from a memory mapping. Seeking finds the last keyframe at or before
+// the target through a binary search of the index and applies the deltas after it; playing
+// forward continues from the previous position. Only the pages of the records read are loaded.
+class PosePlayer
+{
+public:
+    // False for files that cannot be mapped or fail validation; errors go to stderr
+    bool open(const std::string& path);
+    void close();
+
+    bool is_open() const { return !keyframes_.empty(); }
+    double start_time() const { return keyframes_.empty() ? 0.0 : keyframes_.front().time; }
+    double duration() const { return duration_; }
+    uint64_t record_count() const { return record_count_; }
+
+    // Moves to the pose at the given time; false if a damaged record was hit, which closes the recording
+    bool seek(double time);
+
+    // Record by record: rewind() goes back before the first one and next() applies the one after the
+    // current position; false at the end or at a damaged record
+    void rewind() { positioned_ = false; cursor_ = sizeof(PoseLogFormat::Header); }
+    bool next();
+    double time() const { return time_; }
+
+    // Pose of the current position: root transform, local rotations and lengths (positions are not recorded)
+    const glm::vec3& root_pos() const { return root_pos_; }
+    const glm::quat& root_quat() const { return root_quat_; }
+    std::span<const Joint> joints() const { return joints_; }
+
+    // Changes whenever seek() changed the pose
+    uint64_t version() const { return version_; }
+
+private:
+    // The record at offset, if it is complete and consistent with the current pose
+    const PoseLogFormat::Record* record_at(uint64_t offset) const;
+    void apply(const PoseLogFormat::Record& record, uint64_t offset);
+    bool fail(const char* reason);
+
+private:
+    MappedFile file_;
+    std::string path_;
+    std::span<const PoseLogFormat::KeyframeEntry> keyframes_;
+    uint64_t records_end_{ 0 };
+    uint64_t record_count_{ 0 };
+    double duration_{ 0.0 };
+
+    // Position: keyframe of the current segment, next record to apply and time of the last one applied
+    size_t keyframe_{ 0 };
+    uint64_t segment_start_{ 0 };   // Record after the keyframe
+    uint64_t cursor_{ 0 };
+    double time_{ 0.0 };
+    bool positioned_{ false };
+
+    glm::vec3 root_pos_{ 0.0f };
+    glm::quat root_quat_{ 1, 0, 0, 0 };
+    std::vector<Joint> joints_;
+    uint64_t version_{ 0 };
+};
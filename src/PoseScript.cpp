@@ -0,0 +1,104 @@
+#include "PoseScript.hpp"
+
+#include <fstream>
+#include <sstream>
+#include <iostream>
+#include <algorithm>
+
+#include "Math.hpp"
+#include "Chain.hpp"
+#include "Camera.hpp"
+#include "MemoryTracker.hpp"
+
+
+bool PoseScript::load(const std::string& path)
+{
+    MemoryTracker::Scope memory(MemoryTag::IO);
+    std::ifstream file(path);
+    if (!file) {
+        std::cerr << "Failed to open pose script: " << path << std::endl;
+        return false;
+    }
+
+    commands_.clear();
+
+    std::string line;
+    for (int line_number = 1; std::getline(file, line); ++line_number) {
+        std::istringstream in(line);
+        Command command{};
+        std::string verb;
+
+        if (!(in >> command.frame)) {
+            // Blank or comment line
+            std::string rest;
+            in.clear();
+            if (!(in >> rest) || rest[0] == '#') continue;
+            std::cerr << path << ":" << line_number << ": expected a frame number" << std::endl;
+            return false;
+        }
+
+        in >> verb;
+        bool ok = false;
+
+        if (verb == "rotate") {
+            std::string axis;
+            ok = static_cast<bool>(in >> command.joint >> axis >> command.degrees) && command.joint >= 0;
+            if (axis == "x") { command.axis = glm::vec3(1, 0, 0); }
+            else if (axis == "y") { command.axis = glm::vec3(0, 1, 0); }
+            else if (axis == "z") { command.axis = glm::vec3(0, 0, 1); }
+            else { ok = false; }
+        }
+        else if (verb == "view") {
+            std::string plane;
+            ok = static_cast<bool>(in >> plane);
+            command.view = true;
+            if (plane == "xy") { command.plane = ViewPlane::XY; }
+            else if (plane == "yz") { command.plane = ViewPlane::YZ; }
+            else if (plane == "xz") { command.plane = ViewPlane::XZ; }
+            else if (plane == "xyz") { command.plane = ViewPlane::XYZ; }
+            else { ok = false; }
+        }
+
+        if (!ok || command.frame < 0) {
+            std::cerr << path << ":" << line_number << ": invalid command: " << line << std::endl;
+            return false;
+        }
+        commands_.push_back(command);
+    }
+
+    std::stable_sort(commands_.begin(), commands_.end(), [](const Command& a, const Command& b) { return a.frame < b.frame; });
+    return true;
+}
+
+void PoseScript::apply(int frame, Chain& chain, Camera& camera) const
+{
+    auto first = std::lower_bound(commands_.begin(), commands_.end(), frame, [](const Command& c, int f) { return c.frame < f; });
+    bool rotated = false;
+
+    for (auto it = first; it != commands_.end() && it->frame == frame; ++it) {
+        if (it->view) {
+            camera.view_plane = it->plane;
+            chain.view_plane = it->plane;
+            continue;
+        }
+
+        auto& joints = chain.joints();
+        if (it->joint >= (int)joints.size()) {
+            std::cerr << "Pose script: joint " << it->joint << " does not exist" << std::endl;
+            continue;
+        }
+
+        glm::quat q = Math::axis_angle_quat(it->axis, it->degrees);
+        if (it->joint == 0) {
+            chain.set_root_quat(q * chain.root_quat());
+        }
+        else {
+            joints[it->joint].local_rot = q * joints[it->joint].local_rot;
+        }
+        rotated = true;
+    }
+
+    if (rotated) {
+        chain.forward_kinematics();
+    }
+}
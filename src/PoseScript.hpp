@@ -0,0 +1,42 @@
+#pragma once
+
+#include <string>
+#include <vector>
+
+#include <glm/glm.hpp>
+
+#include "Main.hpp"
+
+
+class Chain;
+class Camera;
+
+
+// Pose changes applied at given frames, for driving headless runs. One command per line:
+//   <frame> rotate <joint> <x|y|z> <degrees>    rotate a joint (0 = root) in its parent's frame
+//   <frame> view <xy|yz|xz|xyz>                 switch the view plane
+// Blank lines and lines starting with '#' are ignored.
+class PoseScript
+{
+public:
+    bool load(const std::string& path);
+
+    // Applies the commands of the given frame
+    void apply(int frame, Chain& chain, Camera& camera) const;
+
+    // Frame of the last command, -1 if empty
+    int last_frame() const { return commands_.empty() ? -1 : commands_.back().frame; }
+
+private:
+    struct Command
+    {
+        int frame;
+        bool view;          // View change instead of a rotation
+        ViewPlane plane;
+        int joint;
+        glm::vec3 axis;
+        float degrees;
+    };
+
+    std::vector<Command> commands_;     // Sorted by frame
+};
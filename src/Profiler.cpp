@@ -0,0 +1,125 @@
+#include "Profiler.hpp"
+
+#include <algorithm>
+
+
+void Profiler::History::push(float value)
+{
+    values[head] = value;
+    head = (head + 1) % history_size;
+    count = std::min(count + 1, history_size);
+}
+
+float Profiler::History::percentile(float p) const
+{
+    if (count == 0) return 0.0f;
+
+    std::array<float, history_size> sorted;
+    std::copy_n(values.begin(), count, sorted.begin());
+
+    size_t rank = std::min(count - 1, static_cast<size_t>(p * (count - 1) + 0.5f));
+    std::nth_element(sorted.begin(), sorted.begin() + rank, sorted.begin() + count);
+    return sorted[rank];
+}
+
+
+Profiler::Profiler() : 
+    enabled_{ false }, requested_{ false }, gpu_busy_{ false }, frame_{ 0 }, 
+    stages_{}, frame_cpu_{}, frame_start_{}
+{
+    stages_.reserve(max_stages);
+}
+
+Profiler::~Profiler()
+{
+    for (auto& stage : stages_) {
+        for (GLuint query : stage.queries) {
+            if (query) { glDeleteQueries(1, &query); }
+        }
+    }
+}
+
+void Profiler::begin_frame()
+{
+    enabled_ = requested_;
+    if (!enabled_) return;
+
+    frame_start_ = std::chrono::steady_clock::now();
+
+    // Results of the frame that used this query slot before
+    collect_gpu(frame_ % query_frames);
+
+    for (auto& stage : stages_) {
+        stage.cpu_ms = 0.0f;
+        stage.used = false;
+    }
+}
+
+void Profiler::end_frame()
+{
+    if (!enabled_) return;
+
+    for (auto& stage : stages_) {
+        if (stage.used) { stage.cpu.push(stage.cpu_ms); }
+    }
+
+    frame_cpu_.push(std::chrono::duration<float, std::milli>(std::chrono::steady_clock::now() - frame_start_).count());
+    ++frame_;
+}
+
+size_t Profiler::begin(const char* name)
+{
+    size_t index = 0;
+    while (index < stages_.size() && stages_[index].name != name) { ++index; }
+    if (index == stages_.size()) {
+        if (stages_.size() == max_stages) return max_stages;
+        stages_.emplace_back();
+        stages_.back().name = name;
+    }
+
+    Stage& stage = stages_[index];
+    stage.start = std::chrono::steady_clock::now();
+
+    if (!gpu_busy_ && !stage.used) {
+        size_t slot = frame_ % query_frames;
+        if (!stage.queries[slot]) { glGenQueries(1, &stage.queries[slot]); }
+
+        glBeginQuery(GL_TIME_ELAPSED, stage.queries[slot]);
+        stage.issued[slot] = true;
+        stage.timing_gpu = true;
+        gpu_busy_ = true;
+    }
+    return index;
+}
+
+void Profiler::end(size_t index)
+{
+    if (index == max_stages) return;
+
+    Stage& stage = stages_[index];
+    stage.cpu_ms += std::chrono::duration<float, std::milli>(std::chrono::steady_clock::now() - stage.start).count();
+    stage.used = true;
+
+    if (stage.timing_gpu) {
+        glEndQuery(GL_TIME_ELAPSED);
+        stage.timing_gpu = false;
+        gpu_busy_ = false;
+    }
+}
+
+void Profiler::collect_gpu(size_t slot)
+{
+    for (auto& stage : stages_) {
+        if (!stage.issued[slot]) continue;
+        stage.issued[slot] = false;
+
+        // A result that is still not ready this many frames later is skipped, never waited on
+        GLint available = 0;
+        glGetQueryObjectiv(stage.queries[slot], GL_QUERY_RESULT_AVAILABLE, &available);
+        if (!available) continue;
+
+        GLuint64 ns = 0;
+        glGetQueryObjectui64v(stage.queries[slot], GL_QUERY_RESULT, &ns);
+        stage.gpu.push(static_cast<float>(ns / 1e6));
+    }
+}
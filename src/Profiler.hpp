@@ -0,0 +1,100 @@
+#pragma once
+
+#include <array>
+#include <chrono>
+#include <vector>
+#include <cstdint>
+
+#include <GL/glew.h>
+
+#include "Trace.hpp"
+
+
+// Per-stage frame timings: CPU time from scoped timers and GPU time from GL_TIME_ELAPSED
+// queries, kept as rolling histories. Scopes cost a single branch while disabled.
+class Profiler
+{
+public:
+    static constexpr size_t history_size = 240;
+    static constexpr size_t query_frames = 4;      // Frames a GPU result may lag behind
+    static constexpr size_t max_stages = 32;
+
+    struct History
+    {
+        std::array<float, history_size> values{};
+        size_t head = 0;                            // Next slot to write
+        size_t count = 0;
+
+        void push(float value);
+        float latest() const { return count ? values[(head + history_size - 1) % history_size] : 0.0f; }
+
+        // p in [0, 1] over the recorded samples
+        float percentile(float p) const;
+    };
+
+    struct Stage
+    {
+        const char* name = nullptr;
+        History cpu;
+        History gpu;
+
+        // Per-frame state
+        std::chrono::steady_clock::time_point start;
+        float cpu_ms = 0.0f;
+        bool used = false;
+        std::array<GLuint, query_frames> queries{};
+        std::array<bool, query_frames> issued{};
+        bool timing_gpu = false;
+    };
+
+    // Times the enclosing block as a stage, and records it in a running trace.
+    // Names are string literals and identify stages.
+    class Scope
+    {
+    public:
+        Scope(Profiler& profiler, const char* name) : trace_{ name }, profiler_{ profiler.enabled_ ? &profiler : nullptr }, stage_{ 0 }
+        {
+            if (profiler_) { stage_ = profiler_->begin(name); }
+        }
+        ~Scope()
+        {
+            if (profiler_) { profiler_->end(stage_); }
+        }
+
+        Scope(const Scope&) = delete;
+        Scope& operator=(const Scope&) = delete;
+
+    private:
+        Trace::Scope trace_;
+        Profiler* profiler_;
+        size_t stage_;
+    };
+
+    Profiler();
+    ~Profiler();
+
+    // Takes effect at the next frame
+    void set_enabled(bool enabled) { requested_ = enabled; }
+    bool enabled() const { return enabled_; }
+
+    void begin_frame();
+    void end_frame();
+
+    const std::vector<Stage>& stages() const { return stages_; }
+    const History& frame_cpu() const { return frame_cpu_; }
+
+private:
+    size_t begin(const char* name);
+    void end(size_t stage);
+    void collect_gpu(size_t slot);
+
+private:
+    bool enabled_;
+    bool requested_;
+    bool gpu_busy_;                 // GL_TIME_ELAPSED queries cannot nest
+    uint64_t frame_;
+
+    std::vector<Stage> stages_;
+    History frame_cpu_;
+    std::chrono::steady_clock::time_point frame_start_;
+};
@@ -3,7 +3,11 @@
 #include <string>
 #include <memory>
 #include <vector>
+#include <cmath>
+#include <chrono>
+#include <cfloat>
 #include <iostream>
+#include <algorithm>
 #include <filesystem>
 
 #include <GL/glew.h>
@@ -24,7 +28,30 @@
 #include "Camera.hpp"
 #include "Shader.hpp"
 #include "Overlay.hpp"
-
+#include "Profiler.hpp"
+#include "Startup.hpp"
+#include "Headless.hpp"
+#include "FrameCapture.hpp"
+#include "Trace.hpp"
+#include "Simulation.hpp"
+#include "JobSystem.hpp"
+#include "FrameArena.hpp"
+#include "MemoryTracker.hpp"
+#include "SceneFile.hpp"
+#include "SceneText.hpp"
+#include "PoseLog.hpp"
+#include "BvhImport.hpp"
+#include "GltfExport.hpp"
+#include "JointSeries.hpp"
+#include "AnimationCompression.hpp"
+
+
+// Length of a trace started with F12
+static constexpr double default_trace_seconds = 5.0;
+
+// Frames before the heap check starts (buffers, pools and ImGui windows settle), and its report limit
+static constexpr uint64_t heap_check_warmup_frames = 8;
+static constexpr int max_heap_reports = 10;
 
 static std::vector<Vertex> axis_data = {
     Vertex{{0, 0, 0}, {0.75f, 0.15f, 0.20f}},
@@ -43,154 +70,795 @@ Renderer*& Renderer::instance()
 }
 
 
-Renderer::Renderer(int argc, char** argv) : 
-    shader_{}, main_buffer_{}, axis_buffer_{}, 
-    grid_{ nullptr }, camera_{ nullptr }, chain_{ nullptr }, overlay_{ nullptr }
+Renderer::Renderer(const Options& options, int argc, char** argv) : 
+    options_{ options }, scheduler_{ options.on_demand && options.capture.empty(), options.animation_fps }, 
+    shader_{}, main_buffer_{ "Main" }, axis_buffer_{ "Axes" }, 
+    grid_{ nullptr }, camera_{ nullptr }, chain_{ nullptr }, overlay_{ nullptr }, 
+    font_atlas_{ nullptr }, startup_{ nullptr }
 {
     instance() = this;
 
-    glutInit(&argc, argv);
-    int win_w = WINDOW_WIDTH, win_h = WINDOW_HEIGHT;
-
-    // Get screen size
-    int screen_w = glutGet(GLUT_SCREEN_WIDTH);
-    int screen_h = glutGet(GLUT_SCREEN_HEIGHT);
-
-    // Center position
-    int pos_x = (screen_w - win_w) / 2;
-    int pos_y = (screen_h - win_h) / 2;
+    // ImGui allocates through malloc by default; route it through the tracked operator new before
+    // the font atlas is baked, so its heap use is counted under the current tag like everything else
+    if constexpr (MemoryTracker::enabled) {
+        ImGui::SetAllocatorFunctions(
+            [](size_t size, void*) { return ::operator new(size); },
+            [](void* p, void*) { ::operator delete(p); });
+    }
 
-    // Initialize GLUT
-    glutInitWindowSize(win_w, win_h);
-    glutInitWindowPosition(pos_x, pos_y); // Center the window
-    glutInitDisplayMode(GLUT_RGBA | GLUT_DOUBLE | GLUT_DEPTH | GLUT_MULTISAMPLE);
-    glutSetOption(GLUT_MULTISAMPLE, 4);
-    glutCreateWindow("Artichoke - Articulated Chain Viewer");
+    Trace::set_thread_name("Main");
+    if (options_.trace_seconds > 0.0) {
+        Trace::start(options_.trace_file, options_.trace_seconds);
+    }
 
-    // GLUT callbacks
-    glutDisplayFunc([]() { 
-        instance()->display();
-    });
-    glutReshapeFunc([](int w, int h) { 
-        instance()->reshape(w, h);
-    });
-    glutIdleFunc([]() { 
-        glutPostRedisplay();
-    });
+    // Start reading resources and baking fonts while the window and GL context come up
+    startup_ = std::make_unique<Startup>();
+
+    if (options_.headless) {
+        // No window system: an EGL context rendering into a framebuffer object
+        startup_->begin_phase("EGL context");
+        headless_ = std::make_unique<Headless>(static_cast<int>(WINDOW_WIDTH), static_cast<int>(WINDOW_HEIGHT));
+        if (!headless_->create_context()) {
+            exit(1);
+        }
+        startup_->end_phase();
+    }
+    else {
+        startup_->begin_phase("GLUT window");
+        glutInit(&argc, argv);
+
+        // Return from the main loop when the window closes; the close callback finishes recordings and captures
+        glutSetOption(GLUT_ACTION_ON_WINDOW_CLOSE, GLUT_ACTION_GLUTMAINLOOP_RETURNS);
+        int win_w = WINDOW_WIDTH, win_h = WINDOW_HEIGHT;
+
+        // Get screen size
+        int screen_w = glutGet(GLUT_SCREEN_WIDTH);
+        int screen_h = glutGet(GLUT_SCREEN_HEIGHT);
+
+        // Center position
+        int pos_x = (screen_w - win_w) / 2;
+        int pos_y = (screen_h - win_h) / 2;
+
+        // Initialize GLUT
+        glutInitWindowSize(win_w, win_h);
+        glutInitWindowPosition(pos_x, pos_y); // Center the window
+        glutInitDisplayMode(GLUT_RGBA | GLUT_DOUBLE | GLUT_DEPTH | GLUT_MULTISAMPLE);
+        glutSetOption(GLUT_MULTISAMPLE, 4);
+        glutCreateWindow("Artichoke - Articulated Chain Viewer");
+
+        // GLUT callbacks
+        glutDisplayFunc([]() { 
+            instance()->display();
+        });
+        glutReshapeFunc([](int w, int h) { 
+            instance()->reshape(w, h);
+        });
+        glutCloseFunc([]() {
+            instance()->close();
+        });
+        scheduler_.install();
+        startup_->end_phase();
+    }
 
     // Initialize GLEW
+    startup_->begin_phase("GLEW");
     GLenum err = glewInit();
+#ifdef GLEW_ERROR_NO_GLX_DISPLAY
+    // GLEW built for GLX looks for an X display first; the EGL context only needs the GL entry points
+    if (headless_ && err == GLEW_ERROR_NO_GLX_DISPLAY) {
+        err = glewContextInit();
+    }
+#endif
     if (err != GLEW_OK) {
         fprintf(stderr, "GLEW initialization failed: %s\n", glewGetErrorString(err));
         exit(1);
     }
+    if (headless_ && !headless_->create_framebuffer()) {
+        exit(1);
+    }
+    startup_->end_phase();
 
-    // Initialize ImGui
+    // Present a cleared frame right away so the window is not blank while the rest loads
+    startup_->begin_phase("Clear frame");
+    glClearColor(0.85f, 0.85f, 0.80f, 1.0f);
+    glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
+    if (!headless_) { glutSwapBuffers(); }
+    startup_->end_phase();
+
+    // Initialize shaders and buffers
+    startup_->begin_phase("Shaders");
+    const ShaderSource& source = startup_->shader_source();
+    shader_.load(source);
+    startup_->end_phase();
+
+    // Initialize ImGui with the font atlas baked on the worker thread
+    startup_->begin_phase("ImGui");
+    font_atlas_ = startup_->take_font_atlas();
     IMGUI_CHECKVERSION();
-    ImGui::CreateContext();
+    ImGui::CreateContext(font_atlas_.get());
     ImGui::StyleColorsDark();
-    ImGui_ImplGLUT_Init();
-    ImGui_ImplGLUT_InstallFuncs();
+    if (headless_) {
+        // Without the GLUT backend the display size and frame time are set by hand
+        reshape(headless_->width(), headless_->height());
+    }
+    else {
+        ImGui_ImplGLUT_Init();
+        install_input_callbacks();
+    }
     ImGui_ImplOpenGL3_Init();
+    startup_->end_phase();
 
-    // Initialize shaders and buffers
-    shader_.load("res/color.vert", "res/color.frag");
-
+    startup_->begin_phase("Scene");
     main_buffer_.create();
 
     axis_buffer_.create();
     axis_buffer_.bind();
-    glBufferData(GL_ARRAY_BUFFER, axis_data.size() * sizeof(Vertex), axis_data.data(), GL_STATIC_DRAW);
+    axis_buffer_.update_data(axis_data.data(), axis_data.size() * sizeof(Vertex), GL_STATIC_DRAW);
     Buffer::set_vertex_attributes(); // Unified attribute setup
     axis_buffer_.unbind();
 
     // Initialize chain and camera
-    grid_ = std::make_unique<Grid>();
+    grid_ = std::make_unique<Grid>(source);
     camera_ = std::make_shared<Camera>();
-    chain_ = std::make_shared<Chain>(camera_);
-    overlay_ = std::make_unique<Overlay>(camera_, chain_);
+    camera_->set_viewport(width_, height_);
+    chain_shader_ = std::make_shared<Shader>();
+    chain_shader_->load(source);
+    chain_ = std::make_shared<Chain>(camera_, chain_shader_, ChainSpec{});
+    chains_ = { chain_ };
+    profiler_ = std::make_shared<Profiler>();
+    overlay_ = std::make_unique<Overlay>(camera_, chain_, profiler_);
+
+    if (!options_.scene_file.empty()) {
+        if (!load_scene(options_.scene_file)) { exit(1); }
+    }
+    else if (options_.generate_scene) {
+        generate_scene(options_.scene);
+    }
+    if (!options_.bvh_file.empty() && !import_bvh(options_.bvh_file)) {
+        exit(1);
+    }
+    if (!options_.save_scene_file.empty() && !save_scene(options_.save_scene_file)) {
+        exit(1);
+    }
+
+    // Headless runs apply the pose script on the render thread, so frames are reproducible
+    if (options_.sim_rate > 0.0f && !headless_) {
+        simulation_ = std::make_unique<Simulation>(options_.sim_rate);
+        simulation_->start();
+    }
+    if (!options_.pose_script.empty() && !pose_script_.load(options_.pose_script)) {
+        exit(1);
+    }
+    if (!options_.play_file.empty()) {
+        player_ = std::make_unique<PosePlayer>();
+        if (!player_->open(options_.play_file)) { exit(1); }
+        if (options_.compress_tolerance > 0.0f && !compress_recording()) { exit(1); }
+        play_start_ = session_time();
+    }
+    if (!options_.record_file.empty()) {
+        recorder_ = std::make_unique<PoseRecorder>();
+        if (!recorder_->open(options_.record_file)) { exit(1); }
+        recorded_pose_version_ = UINT64_MAX;
+        record_start_ = session_time();
+    }
+    if (!options_.gltf_file.empty() && !export_gltf(options_.gltf_file)) {
+        exit(1);
+    }
+
+    // Recording runs continuously; headless runs wait for the writer instead of dropping frames
+    if (!options_.capture.empty()) {
+        capture_ = std::make_unique<FrameCapture>(options_.capture, headless_ != nullptr);
+        if (!capture_->start()) {
+            exit(1);
+        }
+    }
+    if (!options_.series_file.empty()) {
+        series_ = std::make_unique<JointSeriesWriter>(options_.series_file, headless_ != nullptr);
+        if (!series_->start()) {
+            exit(1);
+        }
+        series_start_ = session_time();
+    }
+    startup_->end_phase();
+
+    // Timed until the first full frame has been presented
+    startup_->begin_phase("First frame");
 }
 
 Renderer::~Renderer()
 {
+    // Freeglut has destroyed the window by now; only a headless context is still alive
+    close();
+
+    if (simulation_) { simulation_->stop(); }
+    Trace::stop();
+
+    if (series_ && series_->finish()) {
+        fprintf(log_stream(), "Saved joint series %s: %llu samples (%llu dropped)\n", options_.series_file.c_str(),
+            static_cast<unsigned long long>(series_->sampled()), static_cast<unsigned long long>(series_->dropped()));
+    }
+
+    ImGui::DestroyContext();
+
+    // The context does not own a shared atlas, so it is released after the context
+    font_atlas_.reset();
+}
+
+void Renderer::close()
+{
+    if (closed_) return;
+    closed_ = true;
+
+    if (recorder_ && recorder_->finish()) {
+        fprintf(log_stream(), "Saved pose recording %s\n", options_.record_file.c_str());
+    }
+
+    // Drains the readback ring, so the last frames are written
+    capture_.reset();
+
+    // Everything holding GL objects, before the window and its context go away
     delete_buffers();
+    overlay_.reset();
+    profiler_.reset();
+    chain_.reset();
+    chains_.clear();
+    grid_.reset();
+    chain_shader_.reset();
+    shader_.destroy();
 
     ImGui_ImplOpenGL3_Shutdown();
-    ImGui_ImplGLUT_Shutdown();
-    ImGui::DestroyContext();
+    if (!headless_) { ImGui_ImplGLUT_Shutdown(); }
 }
 
 void Renderer::run()
 {
-    glutMainLoop();
+    if (!headless_) {
+        glutMainLoop();
+        return;
+    }
+
+    // Fixed number of frames, by default until the pose script ends
+    int frames = options_.frames > 0 ? options_.frames : std::max(1, pose_script_.last_frame() + 1);
+    if (options_.frames <= 0 && player_) {
+        frames = std::max(frames, static_cast<int>(std::ceil(player_->duration() * options_.animation_fps)) + 1);
+    }
+    if (options_.frames <= 0 && bvh_) {
+        frames = std::max(frames, static_cast<int>(std::ceil(bvh_->frame_count() * bvh_->frame_time() * options_.animation_fps)) + 1);
+    }
+
+    auto start = std::chrono::steady_clock::now();
+    for (int frame = 0; frame < frames; ++frame) {
+        pose_script_.apply(frame, *chain_, *camera_);
+        display();
+    }
+    double ms = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+
+    fprintf(log_stream(), "Headless: rendered %d frames in %.1f ms (%.2f ms/frame)\n", frames, ms, ms / frames);
 }
 
-void Renderer::display()
+void Renderer::install_input_callbacks()
 {
-    ImGui_ImplOpenGL3_NewFrame();
-    ImGui_ImplGLUT_NewFrame();
-    ImGui::NewFrame();
-
-    input_.update();
+    // Same hooks as ImGui_ImplGLUT_InstallFuncs(), plus invalidation for on-demand redraw
+    glutReshapeFunc([](int w, int h) {
+        ImGui_ImplGLUT_ReshapeFunc(w, h);
+        instance()->reshape(w, h);
+        instance()->scheduler_.invalidate();
+    });
+    glutMotionFunc([](int x, int y) {
+        ImGui_ImplGLUT_MotionFunc(x, y);
+        instance()->scheduler_.invalidate();
+    });
+    glutPassiveMotionFunc([](int x, int y) {
+        ImGui_ImplGLUT_MotionFunc(x, y);
+        instance()->scheduler_.invalidate();
+    });
+    glutMouseFunc([](int button, int state, int x, int y) {
+        ImGui_ImplGLUT_MouseFunc(button, state, x, y);
+        instance()->scheduler_.invalidate();
+    });
+    glutMouseWheelFunc([](int button, int dir, int x, int y) {
+        ImGui_ImplGLUT_MouseWheelFunc(button, dir, x, y);
+        instance()->scheduler_.invalidate();
+    });
+    glutKeyboardFunc([](unsigned char c, int x, int y) {
+        ImGui_ImplGLUT_KeyboardFunc(c, x, y);
+        instance()->scheduler_.invalidate();
+    });
+    glutKeyboardUpFunc([](unsigned char c, int x, int y) {
+        ImGui_ImplGLUT_KeyboardUpFunc(c, x, y);
+        instance()->scheduler_.invalidate();
+    });
+    glutSpecialFunc([](int key, int x, int y) {
+        ImGui_ImplGLUT_SpecialFunc(key, x, y);
+        instance()->scheduler_.invalidate();
+    });
+    glutSpecialUpFunc([](int key, int x, int y) {
+        ImGui_ImplGLUT_SpecialUpFunc(key, x, y);
+        instance()->scheduler_.invalidate();
+    });
+}
 
-    bool changed = overlay_->draw_menu(input_);
+void Renderer::display()
+{
+    if (closed_) return;
+
+    Profiler& profiler = *profiler_;
+    profiler.begin_frame();
+
+    uint64_t heap_start = MemoryTracker::thread_allocations();
+    scene_generated_ = false;
+    MemoryTracker::Scope memory(MemoryTag::Rendering);
+
+    bool changed = false;
+    {
+        Profiler::Scope scope(profiler, "ImGui");
+        MemoryTracker::Scope memory(MemoryTag::Overlay);
+        ImGui_ImplOpenGL3_NewFrame();
+        if (headless_) {
+            ImGui::GetIO().DeltaTime = 1.0f / options_.animation_fps;
+        }
+        else {
+            ImGui_ImplGLUT_NewFrame();
+        }
+        ImGui::NewFrame();
+
+        input_.update();
+
+        // F12 starts a trace of the default length, or ends the running one
+        if (ImGui::IsKeyPressed(ImGuiKey_F12, false)) {
+            if (Trace::active()) { Trace::stop(); }
+            else { Trace::start(options_.trace_file, default_trace_seconds); }
+        }
+
+        changed = overlay_->draw_menu(input_);
+
+        SceneSpec scene;
+        if (overlay_->take_scene_request(scene)) {
+            generate_scene(scene);
+        }
+
+        std::string path;
+        if (overlay_->take_load_request(path)) {
+            load_scene(path);
+        }
+        if (overlay_->take_save_request(path)) {
+            save_scene(path);
+        }
+    }
 
     if (changed) {
         chain_->view_plane = camera_->view_plane;
     }
 
     if (changed || !input_.want_capture_mouse()) {
+        Profiler::Scope scope(profiler, "Camera");
         camera_->update(input_, chain_->active_joint());
     }
 
     if (!ImGui::IsWindowHovered(ImGuiHoveredFlags_AnyWindow)) { 
-        chain_->update(input_, chain_->view_plane, chain_->view_plane != ViewPlane::XYZ, 
-            camera_->get_proj(static_cast<float>(WINDOW_WIDTH) / WINDOW_HEIGHT), camera_->get_view());
+        Profiler::Scope scope(profiler, "Chain update");
+        MemoryTracker::Scope memory(MemoryTag::Kinematics);
+        chain_->update(input_, chain_->view_plane, chain_->view_plane != ViewPlane::XYZ);
     }
 
-    // Use Grid class for background gradient and grid
-    if (camera_->view_plane != ViewPlane::XYZ) {
-        grid_->draw_2d(*camera_, WINDOW_WIDTH, WINDOW_HEIGHT);
+    // A recording drives the edit pose, which then takes the same FK, simulation and render path as edits
+    if (player_) {
+        Profiler::Scope scope(profiler, "Playback");
+        MemoryTracker::Scope memory(MemoryTag::IO);
+        double time = session_time() - play_start_;
+        if (compressed_) {
+            // The compressed clip interpolates between its keys, so the pose changes every frame
+            glm::vec3 root_pos;
+            glm::quat root_quat;
+            compressed_->sample(static_cast<float>(time), compressed_cursor_);
+            sampled_pose_.assign(chain_->joints().begin(), chain_->joints().end());
+            compressed_->apply(compressed_cursor_, root_pos, root_quat, sampled_pose_);
+            chain_->set_pose(root_pos, root_quat, sampled_pose_);
+        }
+        else if (player_->seek(time) && player_->version() != played_version_) {
+            chain_->set_pose(player_->root_pos(), player_->root_quat(), player_->joints());
+            played_version_ = player_->version();
+        }
+        if (!player_->is_open() || time >= player_->duration()) {
+            fprintf(log_stream(), "Played %s\n", options_.play_file.c_str());
+            player_.reset();
+            compressed_.reset();
+        }
     }
-    else {
-        grid_->draw_3d(*camera_, WINDOW_WIDTH, WINDOW_HEIGHT);
+    if (bvh_) {
+        Profiler::Scope scope(profiler, "Motion capture");
+        MemoryTracker::Scope memory(MemoryTag::IO);
+
+        // Frames the reader has ready are skipped up to the one due now
+        uint64_t due = static_cast<uint64_t>((session_time() - bvh_start_) / bvh_->frame_time());
+        while (bvh_frame_ < due && bvh_->front()) {
+            bvh_->pop();
+            ++bvh_frame_;
+        }
+        const BvhFrame* frame = bvh_frame_ == due ? bvh_->front() : nullptr;
+        if (frame && frame->joints.size() == chain_->joints().size()) {
+            chain_->set_pose(frame->root_pos, frame->root_quat, frame->joints);
+            bvh_->pop();
+            ++bvh_frame_;
+        }
+        if (bvh_->finished()) {
+            fprintf(log_stream(), "Played %s: %llu frames\n", options_.bvh_file.c_str(), static_cast<unsigned long long>(bvh_frame_));
+            bvh_.reset();
+        }
+    }
+    AnimationTimeline& timeline = overlay_->timeline();
+    timeline.advance(ImGui::GetIO().DeltaTime);
+    if (timeline.pending()) {
+        Profiler::Scope scope(profiler, "Timeline");
+        MemoryTracker::Scope memory(MemoryTag::Kinematics);
+        glm::vec3 root_pos = chain_->root_pos();
+        glm::quat root_quat = chain_->root_quat();
+        sampled_pose_.assign(chain_->joints().begin(), chain_->joints().end());
+        if (timeline.take_pose(root_pos, root_quat, sampled_pose_)) {
+            chain_->set_pose(root_pos, root_quat, sampled_pose_);
+        }
+    }
+    if (recorder_ && chain_->pose_version() != recorded_pose_version_) {
+        Profiler::Scope scope(profiler, "Recording");
+        MemoryTracker::Scope memory(MemoryTag::IO);
+        recorder_->record(session_time() - record_start_, chain_->root_pos(), chain_->root_quat(), chain_->joints());
+        recorded_pose_version_ = chain_->pose_version();
+    }
+    if (series_) {
+        Profiler::Scope scope(profiler, "Joint series");
+        MemoryTracker::Scope memory(MemoryTag::IO);
+        series_->sample(session_time() - series_start_, chain_->joints(), chain_->tendons());
     }
 
-    glClearColor(0.85f, 0.85f, 0.80f, 1.0f);
-    glEnable(GL_MULTISAMPLE);
-    glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
+    // Use Grid class for background gradient and grid
+    {
+        Profiler::Scope scope(profiler, "Grid");
+        if (camera_->view_plane != ViewPlane::XYZ) {
+            grid_->draw_2d(*camera_);
+        }
+        else {
+            grid_->draw_3d(*camera_);
+        }
+    }
 
-    glm::mat4 mvp = camera_->get_proj(static_cast<float>(WINDOW_WIDTH) / WINDOW_HEIGHT) * camera_->get_view();
+    const glm::mat4& mvp = camera_->get_view_proj();
+
+    {
+        Profiler::Scope scope(profiler, "Axes");
+        glClearColor(0.85f, 0.85f, 0.80f, 1.0f);
+        glEnable(GL_MULTISAMPLE);
+        glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
+
+        if (camera_->view_plane == ViewPlane::XYZ) {
+            // Draw the axis lines
+            shader_.use();
+            shader_.setUniform("uMVP", mvp);
+            axis_buffer_.bind();
+            glLineWidth(2.0f);
+            glDrawArrays(GL_LINES, 0, 6);
+            glLineWidth(1.0f);
+            axis_buffer_.unbind();
+        }
+    }
 
-    if (camera_->view_plane == ViewPlane::XYZ) {
-        // Draw the axis lines
-        shader_.use();
-        shader_.setUniform("uMVP", mvp);
-        axis_buffer_.bind();
-        glLineWidth(2.0f);
-        glDrawArrays(GL_LINES, 0, 6);
-        glLineWidth(1.0f);
-        axis_buffer_.unbind();
+    // Hand edits to the simulation and draw its interpolated poses; while dragging, the edit pose is drawn directly
+    bool animated = animation_.mode != AnimationMode::None;
+    const std::vector<std::vector<Joint>>* poses = nullptr;
+    if (simulation_) {
+        Profiler::Scope scope(profiler, "Simulation");
+        MemoryTracker::Scope memory(MemoryTag::Kinematics);
+        if (chain_->pose_version() != submitted_pose_version_) {
+            simulation_->submit(chains_, animation_);
+            submitted_pose_version_ = chain_->pose_version();
+        }
+        if (simulation_->interpolate(display_poses_)) {
+            poses = &display_poses_;
+            display_pose_version_ = simulation_->pose_version();
+        }
+    }
+    else if (animated) {
+        // Without the simulation thread the animation is posed here; headless runs step by frame for reproducible output
+        Profiler::Scope scope(profiler, "Simulation");
+        MemoryTracker::Scope memory(MemoryTag::Kinematics);
+        double time = session_time();
+        display_poses_.resize(chains_.size());
+        display_animations_.resize(chains_.size());
+        JobSystem::instance().parallel_for("Chain FK", chains_.size(), SceneGenerator::chain_grain(chain_->joints().size()), [&](size_t begin, size_t end) {
+            for (size_t c = begin; c < end; ++c) {
+                const Chain& chain = *chains_[c];
+                SceneGenerator::animate(animation_, time, c, chain.root_pos(), chain.root_quat(), chain.joints(), display_poses_[c], &display_animations_[c]);
+            }
+        });
+        poses = &display_poses_;
+        ++display_pose_version_;
     }
 
-    // Render the articulated chain
-    chain_->render(mvp, overlay_->hide_chain());
+    // Render the articulated chains
+    {
+        Profiler::Scope scope(profiler, "Chain render");
+        CullStats cull_stats;
+        for (size_t i = 0; i < chains_.size(); ++i) {
+            Chain& chain = *chains_[i];
+
+            // Snapshots taken before a scene change do not match the new chains
+            const std::vector<Joint>* pose = nullptr;
+            if (poses && i < poses->size() && (*poses)[i].size() == chain.joints().size() && !chain.dragging()) {
+                pose = &(*poses)[i];
+            }
+            chain.render(mvp, overlay_->hide_chain(), pose, overlay_->lod(), display_pose_version_);
+            cull_stats += chain.cull_stats();
+        }
+        overlay_->set_cull_stats(cull_stats);
+    }
 
     // Draw the UI overlays
-    overlay_->draw_overlays();
+    {
+        Profiler::Scope scope(profiler, "ImGui render");
+        MemoryTracker::Scope memory(MemoryTag::Overlay);
+        overlay_->draw_overlays();
+
+        ImGui::Render();
+        ImGui_ImplOpenGL3_RenderDrawData(ImGui::GetDrawData());
+    }
+
+    {
+        Profiler::Scope scope(profiler, "Present");
+        if (headless_) {
+            headless_->present();
+            if (capture_) { capture_->capture(headless_->resolved_framebuffer(), headless_->width(), headless_->height()); }
+        }
+        else {
+            if (capture_) { capture_->capture(0, width_, height_); }
+            glutSwapBuffers();
+        }
+    }
+    profiler.end_frame();
+
+    // Keep drawing while anything moves; a pose change gets one more frame so dependent UI catches up
+    bool pose_changed = chain_->pose_version() != drawn_pose_version_;
+    drawn_pose_version_ = chain_->pose_version();
+
+    bool animating = camera_->animating || chain_->dragging() || ImGui::IsAnyItemActive() || input_.want_text_input() || player_ || bvh_ || timeline.playing() ||
+        (simulation_ ? !simulation_->settled() : animated);
+    if (!headless_) {
+        if (pose_changed) { scheduler_.invalidate(1); }
+        scheduler_.end_frame(animating);
+    }
 
-    ImGui::Render();
-    ImGui_ImplOpenGL3_RenderDrawData(ImGui::GetDrawData());
-    glutSwapBuffers();
+    // Transient frame data is released; debug builds check that steady-state frames stay off the heap
+    FrameArena::frame().reset();
+    MemoryTracker::end_frame();
+    if (MemoryTracker::enabled && frame_count_ >= heap_check_warmup_frames && !scene_generated_ && heap_reports_ < max_heap_reports) {
+        uint64_t allocations = MemoryTracker::thread_allocations() - heap_start;
+        if (allocations > 0) {
+            fprintf(stderr, "Frame %llu: %llu heap allocations on the render thread\n", 
+                static_cast<unsigned long long>(frame_count_), static_cast<unsigned long long>(allocations));
+            ++heap_reports_;
+        }
+    }
+    ++frame_count_;
+
+    if (startup_) {
+        startup_->end_phase();
+        startup_->report(log_stream());
+        startup_.reset();
+    }
 }
 
 void Renderer::reshape(int w, int h)
 {
+    width_ = w;
+    height_ = h;
     glViewport(0, 0, w, h);
+    if (camera_) { camera_->set_viewport(w, h); }
     ImGuiIO& io = ImGui::GetIO();
     io.DisplaySize = ImVec2((float)w, (float)h);
 }
 
+void Renderer::generate_scene(const SceneSpec& scene)
+{
+    MemoryTracker::Scope memory(MemoryTag::Kinematics);
+
+    std::vector<std::shared_ptr<Chain>> chains;
+    for (const ChainSpec& spec : SceneGenerator::layout(scene)) {
+        chains.push_back(std::make_shared<Chain>(camera_, chain_shader_, spec));
+    }
+    if (chains.empty()) {
+        chains.push_back(std::make_shared<Chain>(camera_, chain_shader_, ChainSpec{}));
+    }
+
+    overlay_->set_scene(scene);
+    animation_ = SceneGenerator::animation(scene);
+    set_chains(std::move(chains));
+
+    fprintf(log_stream(), "Scene: %zu chains, %zu joints\n", chains_.size(), scene.total_joints());
+}
+
+bool Renderer::load_scene(const std::string& path)
+{
+    MemoryTracker::Scope memory(MemoryTag::IO);
+    Trace::Scope trace("Load scene");
+
+    std::vector<std::shared_ptr<Chain>> chains;
+    size_t joints = 0;
+
+    if (is_text_scene(path)) {
+        SceneTextReader reader;
+        bool ok = reader.read(path, [&](SceneChain&& chain) {
+            joints += chain.joints.size();
+            chains.push_back(std::make_shared<Chain>(camera_, chain_shader_, chain.root_pos, chain.root_quat, std::move(chain.joints), std::move(chain.tendons)));
+        });
+        if (!ok) { return false; }
+    }
+    else {
+        SceneReader reader;
+        if (!reader.open(path)) { return false; }
+        for (size_t i = 0; i < reader.chain_count(); ++i) {
+            SceneChainView chain = reader.chain(i);
+            chains.push_back(std::make_shared<Chain>(camera_, chain_shader_, chain.root_pos, chain.root_quat,
+                std::vector<Joint>(chain.joints.begin(), chain.joints.end()), std::vector<Tendon>(chain.tendons.begin(), chain.tendons.end())));
+            joints += chain.joints.size();
+        }
+    }
+
+    if (chains.empty()) {
+        fprintf(stderr, "Scene file %s holds no chains\n", path.c_str());
+        return false;
+    }
+
+    animation_ = AnimationSpec{};
+    set_chains(std::move(chains));
+
+    fprintf(log_stream(), "Loaded %s: %zu chains, %zu joints\n", path.c_str(), chains_.size(), joints);
+    return true;
+}
+
+bool Renderer::save_scene(const std::string& path) const
+{
+    MemoryTracker::Scope memory(MemoryTag::IO);
+    Trace::Scope trace("Save scene");
+
+    bool ok = false;
+    if (is_text_scene(path)) {
+        SceneTextWriter writer;
+        if (!writer.open(path)) { return false; }
+        for (const auto& chain : chains_) {
+            writer.write_chain(chain->root_pos(), chain->root_quat(), chain->joints(), chain->tendons());
+        }
+        ok = writer.finish();
+    }
+    else {
+        SceneWriter writer;
+        if (!writer.open(path)) { return false; }
+        for (const auto& chain : chains_) {
+            writer.write_chain(chain->root_pos(), chain->root_quat(), chain->joints(), chain->tendons());
+        }
+        ok = writer.finish();
+    }
+    if (!ok) { return false; }
+
+    fprintf(log_stream(), "Saved %s: %zu chains\n", path.c_str(), chains_.size());
+    return true;
+}
+
+bool Renderer::is_text_scene(const std::string& path)
+{
+    // Text scenes are told apart by extension, so either format can be saved anywhere
+    return std::filesystem::path(path).extension() == ".txt";
+}
+
+bool Renderer::import_bvh(const std::string& path)
+{
+    MemoryTracker::Scope memory(MemoryTag::IO);
+    Trace::Scope trace("Import BVH");
+
+    auto stream = std::make_unique<BvhStream>();
+    if (!stream->open(path)) { return false; }
+
+    const BvhFrame& rest = stream->rest_pose();
+    set_chains({ std::make_shared<Chain>(camera_, chain_shader_, rest.root_pos, rest.root_quat, rest.joints, std::vector<Tendon>{}) });
+    animation_ = AnimationSpec{};
+
+    bvh_ = std::move(stream);
+    bvh_frame_ = 0;
+    bvh_start_ = session_time();
+    fprintf(log_stream(), "Imported %s: %zu joints, %llu frames at %.1f fps\n", path.c_str(), rest.joints.size(),
+        static_cast<unsigned long long>(bvh_->frame_count()), 1.0 / bvh_->frame_time());
+    return true;
+}
+
+bool Renderer::export_gltf(const std::string& path)
+{
+    MemoryTracker::Scope memory(MemoryTag::IO);
+    Trace::Scope trace("Export glTF");
+
+    // The animation starts from the recording's first pose
+    PosePlayer recording;
+    if (!options_.play_file.empty()) {
+        if (!recording.open(options_.play_file) || !recording.seek(recording.start_time())) { return false; }
+        chain_->set_pose(recording.root_pos(), recording.root_quat(), recording.joints());
+    }
+
+    GltfWriter writer;
+    if (!writer.open(path)) { return false; }
+    for (const auto& chain : chains_) {
+        writer.write_chain(chain->root_pos(), chain->root_quat(), chain->joints(), chain->tendons());
+    }
+    if (recording.is_open()) { writer.set_animation(&recording); }
+    if (!writer.finish()) { return false; }
+
+    fprintf(log_stream(), "Exported %s: %zu chains%s\n", path.c_str(), chains_.size(), recording.is_open() ? " with animation" : "");
+    return true;
+}
+
+bool Renderer::compress_recording()
+{
+    MemoryTracker::Scope memory(MemoryTag::IO);
+    Trace::Scope trace("Compress recording");
+
+    // Frame f is the recording's pose f frames after playback starts, as playback will ask for it
+    float frame_time = 1.0f / options_.animation_fps;
+    AnimationCompressor compressor(frame_time);
+    PosePlayer recording;
+    if (!recording.open(options_.play_file)) { return false; }
+
+    size_t frames = static_cast<size_t>(std::ceil(recording.duration() / frame_time)) + 1;
+    for (size_t f = 0; f < frames; ++f) {
+        if (!recording.seek(f * static_cast<double>(frame_time))) { return false; }
+        compressor.add_frame(recording.root_pos(), recording.root_quat(), recording.joints());
+    }
+
+    CompressionReport report;
+    compressed_ = std::make_unique<CompressedClip>(compressor.compress(options_.compress_tolerance, report));
+
+    constexpr double mb = 1.0 / (1024.0 * 1024.0);
+    fprintf(log_stream(), "Compressed %s: %zu frames, %zu keys, %.2f MB to %.2f MB (%.1f:1), max error %.4f at joint %zu\n",
+        options_.play_file.c_str(), report.frames, report.keys, report.raw_bytes * mb, report.compressed_bytes * mb, report.ratio(),
+        report.worst_error(), report.worst_joint());
+    // Per joint for chains short enough to read through
+    constexpr size_t max_listed_joints = 64;
+    for (size_t i = 0; report.max_error.size() <= max_listed_joints && i < report.max_error.size(); ++i) {
+        fprintf(log_stream(), "  joint %zu: max error %.4f\n", i, report.max_error[i]);
+    }
+    return true;
+}
+
+void Renderer::set_chains(std::vector<std::shared_ptr<Chain>> chains)
+{
+    chains_ = std::move(chains);
+    chain_ = chains_.front();
+    chain_->view_plane = camera_->view_plane;
+    overlay_->set_chain(chain_);
+
+    // Frame the current pose of all chains
+    glm::vec3 lo(FLT_MAX), hi(-FLT_MAX);
+    for (const auto& chain : chains_) {
+        for (const Joint& joint : chain->joints()) {
+            lo = glm::min(lo, joint.pos);
+            hi = glm::max(hi, joint.pos);
+        }
+    }
+    camera_->fit(lo, hi);
+
+    // Fresh chains restart their pose versions (loaded ones at 0), so force a resubmit
+    submitted_pose_version_ = UINT64_MAX;
+    drawn_pose_version_ = UINT64_MAX;
+    recorded_pose_version_ = UINT64_MAX;
+    scheduler_.invalidate();
+    scene_generated_ = true;
+}
+
+FILE* Renderer::log_stream() const
+{
+    // Keep stdout clean when frames are streamed through it
+    return options_.capture == "-" ? stderr : stdout;
+}
+
+double Renderer::session_time() const
+{
+    return headless_ ? frame_count_ / static_cast<double>(options_.animation_fps) : ImGui::GetTime();
+}
+
 void Renderer::delete_buffers()
 {
     main_buffer_.destroy();
@@ -1,7 +1,10 @@
 #pragma once
 
+#include <cstdio>
 #include <memory>
 #include <string>
+#include <vector>
+#include <cstdint>
 
 #include <GL/glew.h>
 #include <glm/glm.hpp>
@@ -9,23 +12,44 @@
 #include "Input.hpp"
 #include "Buffer.hpp"
 #include "Shader.hpp"
+#include "Main.hpp"
+#include "Options.hpp"
+#include "FrameScheduler.hpp"
+#include "Animation.hpp"
+#include "PoseScript.hpp"
+#include "SceneGenerator.hpp"
 
 
 class Grid;
 class Chain;
 class Camera;
 class Overlay;
+class Startup;
+class Headless;
+class FrameCapture;
+class Profiler;
+class Simulation;
+class PoseRecorder;
+class PosePlayer;
+class CompressedClip;
+class BvhStream;
+class JointSeriesWriter;
+struct ImFontAtlas;
 
 
 class Renderer
 {
 public:
-    Renderer(int argc, char** argv);
+    Renderer(const Options& options, int argc, char** argv);
     ~Renderer();
 
     void run();
 
-    // Main display and reshape callbacks
+    // Finishes the recording and capture and releases GL resources while the context is current;
+    // runs once, from the window's close callback or, when headless, the destructor
+    void close();
+
+    // Main display and reshape callbacks (called directly in headless mode)
     void display();
     void reshape(int w, int h);
 
@@ -34,7 +58,50 @@ public:
     void create_axis_buffer();
 
 private:
+    // Input callbacks forward to ImGui and invalidate the view
+    void install_input_callbacks();
+
+    // Replaces all chains with a generated scene and frames it
+    void generate_scene(const SceneSpec& scene);
+
+    // Scene files, binary (see SceneFile) or text (see SceneText); errors are reported and leave the scene as it was
+    bool load_scene(const std::string& path);
+    bool save_scene(const std::string& path) const;
+    static bool is_text_scene(const std::string& path);
+
+    // Replaces the scene with the chain of a BVH capture and starts streaming its frames
+    bool import_bvh(const std::string& path);
+
+    // All chains as a binary glTF file; the --play recording, if any, animates the edited chain
+    bool export_gltf(const std::string& path);
+
+    // Samples the --play recording at the animation frame rate and compresses it; playback then samples the clip
+    bool compress_recording();
+
+    // Makes chains the scene: the first one becomes editable and the camera frames them all
+    void set_chains(std::vector<std::shared_ptr<Chain>> chains);
+
+    // Stream for status output
+    FILE* log_stream() const;
+
+    // Seconds since startup; frames at the animation rate when headless, so runs are reproducible
+    double session_time() const;
+
+private:
+    Options options_;
+
+    // Offscreen context and target when running headless; destroyed after all other GL objects
+    std::unique_ptr<Headless> headless_;
+    PoseScript pose_script_;
+
+    // Frame capture (--capture) and the size of the default framebuffer
+    std::unique_ptr<FrameCapture> capture_;
+    int width_{ static_cast<int>(WINDOW_WIDTH) };
+    int height_{ static_cast<int>(WINDOW_HEIGHT) };
+
     Input input_;
+    FrameScheduler scheduler_;
+    uint64_t drawn_pose_version_{ 0 };
 
     // Shader program
     Shader shader_;
@@ -43,11 +110,54 @@ private:
     Buffer main_buffer_;
     Buffer axis_buffer_;
 
-    // Articulated chain and camera
+    // Articulated chains and camera; the first chain is the one being edited
     std::unique_ptr<Grid> grid_;
+    std::shared_ptr<Shader> chain_shader_;
+    std::vector<std::shared_ptr<Chain>> chains_;
     std::shared_ptr<Chain> chain_;
+    AnimationSpec animation_;
+    uint64_t frame_count_{ 0 };
+    bool scene_generated_{ false };
+    int heap_reports_{ 0 };
     std::shared_ptr<Camera> camera_;
     std::unique_ptr<Overlay> overlay_;
+    std::shared_ptr<Profiler> profiler_;
+
+    // Fixed-rate simulation thread and the interpolated poses drawn from it
+    std::unique_ptr<Simulation> simulation_;
+    std::vector<std::vector<Joint>> display_poses_;
+    uint64_t display_pose_version_{ 0 };
+    std::vector<ChainAnimation> display_animations_;   // Per chain, when the render thread animates
+    uint64_t submitted_pose_version_{ 0 };
+
+    // Recording of the edit pose and playback of one, each timed from when it started
+    std::unique_ptr<PoseRecorder> recorder_;
+    uint64_t recorded_pose_version_{ 0 };
+    double record_start_{ 0.0 };
+    std::unique_ptr<PosePlayer> player_;
+    uint64_t played_version_{ 0 };
+    double play_start_{ 0.0 };
+    std::unique_ptr<CompressedClip> compressed_;
+    AnimationCursor compressed_cursor_;
+
+    // Motion capture playback; frames are read ahead on the stream's thread
+    std::unique_ptr<BvhStream> bvh_;
+    uint64_t bvh_frame_{ 0 };           // Index of the stream's front frame
+    double bvh_start_{ 0.0 };
+
+    // Edit pose with a clip applied: the overlay timeline's, or the compressed recording's
+    std::vector<Joint> sampled_pose_;
+
+    // Joint and tendon state of the edited chain every frame, written on the series' thread
+    std::unique_ptr<JointSeriesWriter> series_;
+    double series_start_{ 0.0 };
+
+    // Font atlas shared with the ImGui context (baked during startup)
+    std::unique_ptr<ImFontAtlas> font_atlas_;
+
+    // Startup pipeline, released after the first full frame
+    std::unique_ptr<Startup> startup_;
+    bool closed_{ false };
 
     // Singleton instance
     static Renderer*& instance();
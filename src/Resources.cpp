@@ -0,0 +1,47 @@
+#include "Resources.hpp"
+
+#include <cstdlib>
+#include <cstring>
+#include <iostream>
+#include <filesystem>
+
+#include <imgui.h>
+
+#include "Shader.hpp"
+
+
+const std::string& Resources::override_dir()
+{
+    static const std::string dir = []() -> std::string {
+        const char* env = std::getenv("ARTICHOKE_RESOURCE_DIR");
+        return (env && *env) ? env : "";
+    }();
+    return dir;
+}
+
+std::string Resources::read_text(const char* name)
+{
+    if (!override_dir().empty()) {
+        std::string path = (std::filesystem::path(override_dir()) / name).string();
+        return Shader::load_file(path.c_str());
+    }
+
+    for (size_t i = 0; i < embedded_file_count; ++i) {
+        if (std::strcmp(embedded_files[i].name, name) == 0) {
+            return std::string(reinterpret_cast<const char*>(embedded_files[i].data), embedded_files[i].size);
+        }
+    }
+
+    std::cerr << "Resource not embedded: " << name << std::endl;
+    return {};
+}
+
+std::unique_ptr<ImFontAtlas> Resources::load_font_atlas()
+{
+    if (!override_dir().empty()) {
+        auto atlas = std::make_unique<ImFontAtlas>();
+        FontAtlas::rasterize(*atlas, override_dir());
+        return atlas;
+    }
+    return FontAtlas::restore(embedded_atlas);
+}
@@ -0,0 +1,39 @@
+#pragma once
+
+#include <cstddef>
+#include <memory>
+#include <string>
+
+#include "FontAtlas.hpp"
+
+
+struct ImFontAtlas;
+
+
+struct EmbeddedFile
+{
+    const char* name;
+    const unsigned char* data;
+    size_t size;
+};
+
+
+// Resources compiled into the executable, with a filesystem override for development:
+// set ARTICHOKE_RESOURCE_DIR to a directory (e.g. the source res/) to load from disk instead.
+class Resources
+{
+public:
+    // Override directory, empty when the embedded resources are used
+    static const std::string& override_dir();
+
+    // Text resource (shader source) by file name
+    static std::string read_text(const char* name);
+
+    // Pre-baked font atlas, or rasterized from the override directory
+    static std::unique_ptr<ImFontAtlas> load_font_atlas();
+
+    // Generated at build time by artichoke_bake
+    static const EmbeddedFile embedded_files[];
+    static const size_t embedded_file_count;
+    static const BakedAtlas embedded_atlas;
+};
@@ -0,0 +1,136 @@
+#include "SceneFile.hpp"
+
+#include <bit>
+#include <cmath>
+#include <cstdio>
+#include <cstddef>
+#include <cstring>
+
+
+// The format is the in-memory layout of a little-endian 64-bit build
+static_assert(std::endian::native == std::endian::little, "Scene files are little-endian");
+static_assert(sizeof(Joint) == 48 && offsetof(Joint, rot) == 12 && offsetof(Joint, local_rot) == 28 && offsetof(Joint, length) == 44);
+static_assert(sizeof(glm::quat) == 16 && offsetof(glm::quat, x) == 0 && offsetof(glm::quat, w) == 12);
+static_assert(sizeof(Tendon) == 32 && sizeof(size_t) == 8 && offsetof(Tendon, t) == 8 && offsetof(Tendon, local_offset) == 12 && offsetof(Tendon, up) == 20);
+
+
+namespace
+{
+    // Whether count records of the given size fit at offset, without overflow
+    bool in_bounds(uint64_t offset, uint64_t count, uint64_t record, uint64_t size)
+    {
+        return offset % SceneFormat::alignment == 0 && offset <= size && count <= (size - offset) / record;
+    }
+}
+
+
+bool SceneReader::open(const std::string& path)
+{
+    using namespace SceneFormat;
+    close();
+
+    if (!file_.open(path)) { return false; }
+
+    const std::byte* data = file_.data();
+    uint64_t size = file_.size();
+    if (size < sizeof(Header)) { return fail(path, "too small for a scene header"); }
+
+    Header header;
+    std::memcpy(&header, data, sizeof(Header));
+    if (std::memcmp(header.magic, magic, sizeof(magic)) != 0) { return fail(path, "not a scene file (or not finished)"); }
+    if (header.version != version) { return fail(path, "unsupported version"); }
+    if (header.header_size != sizeof(Header)) { return fail(path, "unexpected header size"); }
+    if (header.file_size != size) { return fail(path, "truncated"); }
+    if (!in_bounds(header.chain_table, header.chain_count, sizeof(ChainRecord), size)) { return fail(path, "chain table out of bounds"); }
+
+    std::span<const ChainRecord> chains(reinterpret_cast<const ChainRecord*>(data + header.chain_table), header.chain_count);
+    for (const ChainRecord& chain : chains) {
+        if (chain.joint_count < 2) { return fail(path, "chain with fewer than two joints"); }
+        if (!in_bounds(chain.joints, chain.joint_count, sizeof(Joint), size)) { return fail(path, "joints out of bounds"); }
+        if (!in_bounds(chain.tendons, chain.tendon_count, sizeof(Tendon), size)) { return fail(path, "tendons out of bounds"); }
+
+        // Tendon bones index joints; everything else is plain floats
+        const Tendon* tendons = reinterpret_cast<const Tendon*>(data + chain.tendons);
+        for (uint64_t i = 0; i < chain.tendon_count; ++i) {
+            if (tendons[i].bone_idx >= chain.joint_count - 1 || !std::isfinite(tendons[i].t)) { return fail(path, "tendon on a missing bone"); }
+        }
+    }
+
+    chains_ = chains;
+    return true;
+}
+
+void SceneReader::close()
+{
+    chains_ = {};
+    file_.close();
+}
+
+SceneChainView SceneReader::chain(size_t index) const
+{
+    const SceneFormat::ChainRecord& record = chains_[index];
+    const std::byte* data = file_.data();
+
+    SceneChainView view;
+    view.root_pos = glm::vec3(record.root_pos[0], record.root_pos[1], record.root_pos[2]);
+    view.root_quat = glm::quat(record.root_quat[3], record.root_quat[0], record.root_quat[1], record.root_quat[2]);
+    view.joints = { reinterpret_cast<const Joint*>(data + record.joints), record.joint_count };
+    view.tendons = { reinterpret_cast<const Tendon*>(data + record.tendons), record.tendon_count };
+    return view;
+}
+
+bool SceneReader::fail(const std::string& path, const char* reason)
+{
+    std::fprintf(stderr, "Invalid scene file %s: %s\n", path.c_str(), reason);
+    close();
+    return false;
+}
+
+
+bool SceneWriter::open(const std::string& path)
+{
+    chains_.clear();
+    if (!file_.open(path)) { return false; }
+
+    // Zeroed header until finish(), so an interrupted write is rejected by readers
+    SceneFormat::Header header{};
+    return file_.write(&header, sizeof(header));
+}
+
+bool SceneWriter::write_chain(const glm::vec3& root_pos, const glm::quat& root_quat, std::span<const Joint> joints, std::span<const Tendon> tendons)
+{
+    SceneFormat::ChainRecord record{};
+    record.joint_count = joints.size();
+    record.tendon_count = tendons.size();
+    record.root_pos[0] = root_pos.x; record.root_pos[1] = root_pos.y; record.root_pos[2] = root_pos.z;
+    record.root_quat[0] = root_quat.x; record.root_quat[1] = root_quat.y; record.root_quat[2] = root_quat.z; record.root_quat[3] = root_quat.w;
+
+    file_.pad(SceneFormat::alignment);
+    record.joints = file_.offset();
+    file_.write(joints.data(), joints.size_bytes());
+
+    file_.pad(SceneFormat::alignment);
+    record.tendons = file_.offset();
+    file_.write(tendons.data(), tendons.size_bytes());
+
+    chains_.push_back(record);
+    return file_.ok();
+}
+
+bool SceneWriter::finish()
+{
+    if (!file_.is_open()) { return false; }
+
+    file_.pad(SceneFormat::alignment);
+    SceneFormat::Header header{};
+    std::memcpy(header.magic, SceneFormat::magic, sizeof(header.magic));
+    header.version = SceneFormat::version;
+    header.header_size = sizeof(header);
+    header.chain_count = chains_.size();
+    header.chain_table = file_.offset();
+    file_.write(chains_.data(), chains_.size() * sizeof(SceneFormat::ChainRecord));
+    header.file_size = file_.offset();
+
+    file_.write_at(0, &header, sizeof(header));
+    return file_.close();
+}
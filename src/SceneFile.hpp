@@ -0,0 +1,102 @@
+#pragma once
+
+#include <span>
+#include <string>
+#include <vector>
+#include <cstdint>
+
+#include <glm/glm.hpp>
+#include <glm/gtc/quaternion.hpp>
+
+#include "Main.hpp"
+#include "MappedFile.hpp"
+#include "OutputFile.hpp"
+
+
+// Binary scene file, version 1. Little-endian; every section starts on a 64-byte boundary.
+//
+//   Header          64 bytes at offset 0
+//   Joints          per chain: joint_count records of 48 bytes (pos, rot, local_rot, length)
+//   Tendons         per chain: tendon_count records of 32 bytes (bone, t, offset, up)
+//   Chain table     chain_count records of 64 bytes, after all arrays
+//
+// Quaternions are stored x, y, z, w. The records match Joint and Tendon in memory, so a
+// reader hands out views of the mapped arrays, and loading a chain is one bulk copy of each
+// into its pose. The header is written last; a file that was not finished fails validation.
+namespace SceneFormat
+{
+    constexpr char magic[8] = { 'A', 'R', 'T', 'I', 'S', 'C', 'N', '\0' };
+    constexpr uint32_t version = 1;
+    constexpr size_t alignment = 64;
+
+    struct Header
+    {
+        char magic[8];
+        uint32_t version;
+        uint32_t header_size;
+        uint64_t file_size;
+        uint64_t chain_count;
+        uint64_t chain_table;       // Offset of the chain table
+        uint8_t reserved[24];
+    };
+
+    struct ChainRecord
+    {
+        uint64_t joint_count;
+        uint64_t joints;            // Offsets of the arrays
+        uint64_t tendon_count;
+        uint64_t tendons;
+        float root_pos[3];
+        float root_quat[4];         // x, y, z, w
+        uint32_t reserved;
+    };
+
+    static_assert(sizeof(Header) == 64 && sizeof(ChainRecord) == 64);
+}
+
+
+// A chain of a mapped scene file; the spans point into the mapping
+struct SceneChainView
+{
+    glm::vec3 root_pos;
+    glm::quat root_quat;
+    std::span<const Joint> joints;
+    std::span<const Tendon> tendons;
+};
+
+
+// Maps a scene file and validates its structure. Nothing is parsed or copied; arrays are
+// read straight from the page cache when accessed.
+class SceneReader
+{
+public:
+    // False for files that cannot be mapped or fail validation; errors go to stderr
+    bool open(const std::string& path);
+    void close();
+
+    size_t chain_count() const { return chains_.size(); }
+    SceneChainView chain(size_t index) const;
+
+private:
+    bool fail(const std::string& path, const char* reason);
+
+private:
+    MappedFile file_;
+    std::span<const SceneFormat::ChainRecord> chains_;
+};
+
+
+// Writes a scene file one chain at a time, so scenes need not be held in memory at once
+class SceneWriter
+{
+public:
+    bool open(const std::string& path);
+    bool write_chain(const glm::vec3& root_pos, const glm::quat& root_quat, std::span<const Joint> joints, std::span<const Tendon> tendons);
+
+    // Writes the chain table and the header; false if any write failed
+    bool finish();
+
+private:
+    OutputFile file_;
+    std::vector<SceneFormat::ChainRecord> chains_;
+};
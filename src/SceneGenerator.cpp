@@ -0,0 +1,219 @@
+#include "SceneGenerator.hpp"
+
+#include <cmath>
+#include <random>
+#include <algorithm>
+
+#include <glm/gtc/constants.hpp>
+
+#include "Animation.hpp"
+#include "Kinematics.hpp"
+
+
+namespace
+{
+    // Stateless per-joint randomness, so animation needs no stored parameters
+    uint32_t hash(uint32_t a, uint32_t b, uint32_t c)
+    {
+        uint32_t h = a * 0x9e3779b1u ^ (b + 0x7f4a7c15u) * 0x85ebca6bu ^ (c + 0x165667b1u) * 0xc2b2ae35u;
+        h ^= h >> 16;
+        h *= 0x7feb352du;
+        h ^= h >> 15;
+        h *= 0x846ca68bu;
+        h ^= h >> 16;
+        return h;
+    }
+
+    float unit(uint32_t h)
+    {
+        return (h >> 8) * (1.0f / 16777216.0f);
+    }
+}
+
+
+std::vector<ChainSpec> SceneGenerator::layout(const SceneSpec& scene)
+{
+    std::vector<ChainSpec> specs(scene.chains);
+
+    size_t columns = static_cast<size_t>(std::ceil(std::sqrt(static_cast<double>(scene.chains))));
+    float spacing = scene.bone_length * 2.0f;
+
+    for (size_t i = 0; i < scene.chains; ++i) {
+        size_t column = i % columns;
+        size_t row = i / columns;
+
+        ChainSpec& spec = specs[i];
+        spec.joints = std::max<size_t>(scene.joints, 2);
+        spec.bone_length = scene.bone_length;
+        spec.tendons_per_bone = scene.tendons_per_bone;
+
+        // Rows are staggered so chains do not hide each other in the XY view
+        float x = (column + static_cast<float>(row) / columns) * spacing;
+        spec.root_pos = glm::vec3(x, 0.0f, row * spacing);
+        spec.root_quat = Math::axis_angle_quat(glm::vec3(1, 0, 0), -90.0f);
+
+        spec.seed = hash(scene.seed, static_cast<uint32_t>(i), 0) | 1u;
+        spec.bend_degrees = 10.0f;
+    }
+    return specs;
+}
+
+std::vector<Tendon> SceneGenerator::tendons(const std::vector<Joint>& joints, size_t per_bone)
+{
+    std::vector<Tendon> result;
+    if (per_bone == 0 || joints.size() < 2) return result;
+    result.reserve((joints.size() - 1) * per_bone);
+
+    for (size_t i = 0; i + 1 < joints.size(); ++i) {
+        Bone bone(joints, i);
+        glm::vec3 up = std::abs(bone.ab_dir.z) < 0.99f ? glm::vec3(0, 0, 1) : glm::vec3(0, 1, 0);
+        float offset = 0.1f * joints[i].length;
+
+        for (size_t k = 0; k < per_bone; ++k) {
+            float t = (k + 1.0f) / (per_bone + 1.0f);
+            float side = (k % 2) ? -offset : offset;
+            result.push_back({ i, t, glm::vec2(side, 0.0f), up });
+        }
+    }
+    return result;
+}
+
+AnimationSpec SceneGenerator::animation(const SceneSpec& scene)
+{
+    AnimationSpec spec;
+    spec.mode = scene.animation;
+    spec.seed = scene.seed;
+    spec.amplitude = scene.amplitude;
+    spec.frequency = scene.frequency;
+    if (scene.animation != AnimationMode::Keyframes && scene.animation != AnimationMode::Layered) return spec;
+
+    // Squad keys four times per period, each joint bent about a seeded axis; the last key repeats the first so the clip loops
+    constexpr uint32_t keys = 4;
+    size_t joints = std::max<size_t>(scene.joints, 2);
+    float interval = 1.0f / (keys * std::max(scene.frequency, 0.01f));
+    const float two_pi = glm::two_pi<float>();
+
+    auto clip = std::make_shared<AnimationClip>(joints);
+    std::vector<Joint> pose(joints);
+    for (uint32_t key = 0; key <= keys; ++key) {
+        for (size_t i = 1; i < joints; ++i) {
+            uint32_t h = hash(scene.seed, key % keys, static_cast<uint32_t>(i));
+            float azimuth = two_pi * unit(h);
+            float angle = scene.amplitude * (2.0f * unit(hash(h, 1, 0)) - 1.0f);
+            pose[i].local_rot = Math::axis_angle_quat(glm::vec3(std::cos(azimuth), std::sin(azimuth), 0.0f), angle);
+        }
+        clip->set_pose_key(key * interval, glm::vec3(0.0f), glm::quat(1, 0, 0, 0), pose);
+    }
+    clip->set_interpolation(Interpolation::Squad);
+
+    // Layered: the base pose, rotated by the clip at two points faded from root to tip, then by the wave
+    if (scene.animation == AnimationMode::Layered) {
+        auto tree = std::make_shared<BlendTree>(joints);
+        std::vector<float> ramp(joints);
+        for (size_t i = 0; i < joints; ++i) {
+            ramp[i] = static_cast<float>(i) / (joints - 1);
+        }
+        uint32_t base = tree->input(0);
+        uint32_t mix = tree->blend(tree->input(1), tree->input(2), 1.0f, tree->add_mask(ramp));
+        tree->add(tree->add(base, mix, 1.0f), tree->input(3), 1.0f);
+        spec.blend = std::move(tree);
+    }
+
+    spec.clip = std::move(clip);
+    return spec;
+}
+
+void SceneGenerator::animate(const AnimationSpec& animation, double time, size_t chain_index, 
+    const glm::vec3& root_pos, const glm::quat& root_quat, const std::vector<Joint>& base, std::vector<Joint>& out,
+    ChainAnimation* state)
+{
+    out.resize(base.size());
+    std::copy(base.begin(), base.end(), out.begin());
+
+    const float two_pi = glm::two_pi<float>();
+    uint32_t chain = static_cast<uint32_t>(chain_index);
+
+    // The clip's rotations are relative to the base pose, like the procedural modes' bends
+    if (animation.mode == AnimationMode::Keyframes) {
+        const AnimationClip* clip = animation.clip.get();
+        if (clip && state && clip->duration() > 0.0f) {
+            double duration = clip->duration();
+            double phase = duration * unit(hash(animation.seed, chain, 3));
+            clip->sample(static_cast<float>(std::fmod(time + phase, duration)), state->cursor);
+
+            size_t count = std::min(out.size(), clip->joint_count());
+            for (size_t i = 1; i < count; ++i) {
+                out[i].local_rot = base[i].local_rot * state->cursor.rotations[i];
+            }
+        }
+        Kinematics::forward_kinematics(out, root_pos, root_quat);
+        return;
+    }
+
+    // The blend tree writes the local rotations; chains with fewer joints than the tree keep the base pose
+    if (animation.mode == AnimationMode::Layered) {
+        const AnimationClip* clip = animation.clip.get();
+        const BlendTree* tree = animation.blend.get();
+        if (clip && tree && state && clip->duration() > 0.0f) {
+            double duration = clip->duration();
+            double phase = duration * unit(hash(animation.seed, chain, 3));
+            clip->sample(static_cast<float>(std::fmod(time + phase, duration)), state->cursor);
+            clip->sample(static_cast<float>(std::fmod(time + phase + 0.5 * duration, duration)), state->layer);
+
+            size_t count = std::min(out.size(), tree->joint_count());
+            state->base.resize(tree->joint_count());
+            state->wave.resize(tree->joint_count());
+            for (size_t i = 0; i < count; ++i) {
+                state->base[i] = base[i].local_rot;
+            }
+            state->wave[0] = glm::quat(1, 0, 0, 0);
+            for (size_t i = 1; i < state->wave.size(); ++i) {
+                float angle = 0.5f * animation.amplitude * std::sin(two_pi * animation.frequency * static_cast<float>(time) - 0.5f * i - 0.7f * chain);
+                state->wave[i] = Math::axis_angle_quat(glm::vec3(1, 0, 0), angle);
+            }
+
+            const std::span<const glm::quat> inputs[] = { state->base, state->cursor.rotations, state->layer.rotations, state->wave };
+            tree->evaluate(inputs, state->blend, std::span<Joint>(out));
+        }
+        Kinematics::forward_kinematics(out, root_pos, root_quat);
+        return;
+    }
+
+    for (size_t i = 1; i < out.size(); ++i) {
+        float angle = 0.0f;
+        glm::vec3 axis(1, 0, 0);
+
+        switch (animation.mode) {
+            case AnimationMode::Random: {
+                uint32_t h = hash(animation.seed, chain, static_cast<uint32_t>(i));
+                float rate = animation.frequency * (0.5f + unit(h));
+                float phase = two_pi * unit(hash(h, 1, 0));
+                float azimuth = two_pi * unit(hash(h, 2, 0));
+                axis = glm::vec3(std::cos(azimuth), std::sin(azimuth), 0.0f);
+                angle = animation.amplitude * std::sin(two_pi * rate * static_cast<float>(time) + phase);
+                break;
+            }
+            case AnimationMode::Sine: {
+                float phase = 0.5f * i + 0.7f * chain;
+                angle = animation.amplitude * std::sin(two_pi * animation.frequency * static_cast<float>(time) - phase);
+                break;
+            }
+            case AnimationMode::None:
+            case AnimationMode::Keyframes:
+            case AnimationMode::Layered:
+            default:
+                break;
+        }
+
+        if (angle != 0.0f) {
+            out[i].local_rot = base[i].local_rot * Math::axis_angle_quat(axis, angle);
+        }
+    }
+
+    Kinematics::forward_kinematics(out, root_pos, root_quat);
+}
+
+size_t SceneGenerator::chain_grain(size_t joints_per_chain)
+{
+    return std::max<size_t>(1, 4096 / std::max<size_t>(joints_per_chain, 1));
+}
@@ -0,0 +1,94 @@
+#pragma once
+
+#include <memory>
+#include <vector>
+#include <cstdint>
+
+#include <glm/glm.hpp>
+#include <glm/gtc/quaternion.hpp>
+
+#include "Main.hpp"
+#include "Math.hpp"
+#include "Animation.hpp"
+#include "PoseBlend.hpp"
+
+
+enum class AnimationMode
+{
+    None,
+    Random,                 // Every joint swings about its own seeded axis, rate and phase
+    Sine,                   // A wave travelling down each chain
+    Keyframes,              // A seeded looping clip, each chain at its own point in it
+    Layered                 // Two points of the clip blended down each chain, with a wave added on top
+};
+
+// Layout of a single chain
+struct ChainSpec
+{
+    size_t joints = 5;
+    float bone_length = 100.0f;
+    glm::vec3 root_pos{ 0.0f };
+    glm::quat root_quat = Math::axis_angle_quat(glm::vec3(0, 1, 0), 45.0f) * Math::axis_angle_quat(glm::vec3(1, 0, 0), -45.0f);
+    size_t tendons_per_bone = 0;
+    uint32_t seed = 0;      // Seeds the initial bends; 0 keeps the chain straight
+    float bend_degrees = 0.0f;
+};
+
+// Procedural scene for scaling tests
+struct SceneSpec
+{
+    size_t chains = 1;
+    size_t joints = 5;      // Per chain
+    float bone_length = 100.0f;
+    size_t tendons_per_bone = 0;
+    uint32_t seed = 1;
+
+    AnimationMode animation = AnimationMode::None;
+    float amplitude = 15.0f;    // Degrees
+    float frequency = 0.5f;     // Hz
+
+    size_t total_joints() const { return chains * joints; }
+};
+
+// Animation parameters, handed to whichever thread advances the pose
+struct AnimationSpec
+{
+    AnimationMode mode = AnimationMode::None;
+    uint32_t seed = 1;
+    float amplitude = 15.0f;
+    float frequency = 0.5f;
+    std::shared_ptr<const AnimationClip> clip;  // Keyframes and layered; one clip shared by every chain
+    std::shared_ptr<const BlendTree> blend;     // Layered only
+};
+
+// Per-chain state of the keyframed modes, kept from one animate() call to the next
+struct ChainAnimation
+{
+    AnimationCursor cursor;
+    AnimationCursor layer;              // Layered: the clip half a loop further on
+    std::vector<glm::quat> base;        // Layered: the base pose's local rotations
+    std::vector<glm::quat> wave;        // Layered: the additive wave
+    BlendScratch blend;
+};
+
+
+class SceneGenerator
+{
+public:
+    // Chains standing upright (+Y) on a staggered grid in the XZ plane
+    static std::vector<ChainSpec> layout(const SceneSpec& scene);
+
+    // Tendons spread evenly over every bone, alternating sides
+    static std::vector<Tendon> tendons(const std::vector<Joint>& joints, size_t per_bone);
+
+    static AnimationSpec animation(const SceneSpec& scene);
+
+    // Base pose with the animation at the given time applied to the local rotations, followed by FK.
+    // Keyframed modes need the chain's state, which keeps its place in the clip from one call to the next.
+    static void animate(const AnimationSpec& animation, double time, size_t chain_index, 
+        const glm::vec3& root_pos, const glm::quat& root_quat, const std::vector<Joint>& base, std::vector<Joint>& out,
+        ChainAnimation* state = nullptr);
+
+    // Joints per job when posing many chains in parallel
+    static size_t chain_grain(size_t joints_per_chain);
+};
@@ -0,0 +1,269 @@
+#include "SceneText.hpp"
+
+#include <charconv>
+#include <cstring>
+#include <algorithm>
+#include <string_view>
+
+
+namespace
+{
+    constexpr size_t block_size = 1 << 20;
+    constexpr size_t max_reserve = 1 << 24;     // Counts come from the file, so trust them only so far
+
+    bool blank(char c) { return c == ' ' || c == '\t' || c == '\r'; }
+
+    // Fields of one line
+    struct Fields
+    {
+        const char* p;
+        const char* end;
+
+        void skip() { while (p < end && blank(*p)) ++p; }
+        bool done() { skip(); return p == end; }
+
+        std::string_view word()
+        {
+            skip();
+            const char* begin = p;
+            while (p < end && !blank(*p)) ++p;
+            return { begin, static_cast<size_t>(p - begin) };
+        }
+
+        template <typename T>
+        bool number(T& value)
+        {
+            skip();
+            auto [ptr, ec] = std::from_chars(p, end, value);
+            if (ec != std::errc() || (ptr < end && !blank(*ptr))) { return false; }
+            p = ptr;
+            return true;
+        }
+
+        bool vec2(glm::vec2& v) { return number(v.x) && number(v.y); }
+        bool vec3(glm::vec3& v) { return number(v.x) && number(v.y) && number(v.z); }
+        bool quat(glm::quat& q) { return number(q.w) && number(q.x) && number(q.y) && number(q.z); }
+    };
+}
+
+
+bool SceneTextReader::read(const std::string& path, const std::function<void(SceneChain&&)>& on_chain)
+{
+    path_ = path;
+    line_ = 0;
+    header_ = false;
+    in_chain_ = false;
+    chain_ = {};
+    on_chain_ = &on_chain;
+
+    FILE* file = std::fopen(path.c_str(), "rb");
+    if (!file) {
+        std::fprintf(stderr, "Cannot open %s\n", path.c_str());
+        return false;
+    }
+
+    // Lines are parsed in place; only a partial line at the end of a block is carried over
+    std::vector<char> buffer(block_size);
+    size_t carry = 0;
+    bool ok = true;
+
+    while (ok) {
+        if (carry == buffer.size()) { buffer.resize(buffer.size() * 2); }
+
+        size_t requested = buffer.size() - carry;
+        size_t read = std::fread(buffer.data() + carry, 1, requested, file);
+        bool eof = read < requested;
+
+        const char* line = buffer.data();
+        const char* end = line + carry + read;
+        while (ok) {
+            const char* newline = static_cast<const char*>(std::memchr(line, '\n', end - line));
+            if (!newline) {
+                if (eof && line < end) { ok = parse_line(line, end); line = end; }
+                break;
+            }
+            ok = parse_line(line, newline);
+            line = newline + 1;
+        }
+
+        carry = end - line;
+        std::memmove(buffer.data(), line, carry);
+        if (eof) { break; }
+    }
+
+    bool io_error = std::ferror(file) != 0;
+    std::fclose(file);
+    if (ok && io_error) {
+        std::fprintf(stderr, "Failed reading %s\n", path.c_str());
+        ok = false;
+    }
+
+    if (ok && !header_) { ok = fail("missing artichoke-scene header"); }
+    if (ok && in_chain_) { ok = finish_chain(); }
+    chain_ = {};
+    return ok;
+}
+
+bool SceneTextReader::parse_line(const char* begin, const char* end)
+{
+    ++line_;
+    Fields fields{ begin, end };
+    if (fields.done() || *fields.p == '#') { return true; }
+
+    std::string_view record = fields.word();
+
+    if (!header_) {
+        uint32_t version = 0;
+        if (record != "artichoke-scene" || !fields.number(version) || !fields.done()) { return fail("expected artichoke-scene <version>"); }
+        if (version != 1) { return fail("unsupported version"); }
+        header_ = true;
+        return true;
+    }
+
+    if (record == "chain") {
+        if (in_chain_ && !finish_chain()) { return false; }
+        if (!fields.number(expected_joints_) || !fields.number(expected_tendons_) || !fields.done()) { return fail("expected chain <joints> <tendons>"); }
+        chain_.joints.reserve(std::min(expected_joints_, max_reserve));
+        chain_.tendons.reserve(std::min(expected_tendons_, max_reserve));
+        in_chain_ = true;
+        return true;
+    }
+
+    if (!in_chain_) { return fail("record before the first chain"); }
+
+    if (record == "j") {
+        Joint joint;
+        if (!fields.vec3(joint.pos) || !fields.quat(joint.rot) || !fields.quat(joint.local_rot) || !fields.number(joint.length) || !fields.done()) {
+            return fail("expected j <pos x y z> <rot w x y z> <local_rot w x y z> <length>");
+        }
+        chain_.joints.push_back(joint);
+    }
+    else if (record == "t") {
+        Tendon tendon;
+        if (!fields.number(tendon.bone_idx) || !fields.number(tendon.t) || !fields.vec2(tendon.local_offset) || !fields.vec3(tendon.up) || !fields.done()) {
+            return fail("expected t <bone> <t> <offset x y> <up x y z>");
+        }
+        chain_.tendons.push_back(tendon);
+    }
+    else if (record == "root") {
+        if (!fields.vec3(chain_.root_pos) || !fields.quat(chain_.root_quat) || !fields.done()) { return fail("expected root <x y z> <w x y z>"); }
+    }
+    else {
+        return fail("unknown record");
+    }
+    return true;
+}
+
+bool SceneTextReader::finish_chain()
+{
+    if (chain_.joints.size() != expected_joints_) { return fail("joint count differs from its chain line"); }
+    if (chain_.tendons.size() != expected_tendons_) { return fail("tendon count differs from its chain line"); }
+    if (chain_.joints.size() < 2) { return fail("chain with fewer than two joints"); }
+    for (const Tendon& tendon : chain_.tendons) {
+        if (tendon.bone_idx >= chain_.joints.size() - 1) { return fail("tendon on a missing bone"); }
+    }
+
+    (*on_chain_)(std::move(chain_));
+    chain_ = {};
+    in_chain_ = false;
+    return true;
+}
+
+bool SceneTextReader::fail(const char* reason)
+{
+    std::fprintf(stderr, "%s:%zu: %s\n", path_.c_str(), line_, reason);
+    return false;
+}
+
+
+SceneTextWriter::~SceneTextWriter()
+{
+    if (file_) { std::fclose(file_); }
+}
+
+bool SceneTextWriter::open(const std::string& path)
+{
+    if (file_) { std::fclose(file_); }
+
+    path_ = path;
+    file_ = std::fopen(path.c_str(), "wb");
+    if (!file_) {
+        std::fprintf(stderr, "Cannot write %s\n", path.c_str());
+        return ok_ = false;
+    }
+
+    buffer_.resize(block_size);
+    used_ = 0;
+    ok_ = true;
+    put("# Artichoke scene\nartichoke-scene 1\n");
+    return ok_;
+}
+
+bool SceneTextWriter::write_chain(const glm::vec3& root_pos, const glm::quat& root_quat, std::span<const Joint> joints, std::span<const Tendon> tendons)
+{
+    if (!ok_) { return false; }
+
+    auto put_vec3 = [&](const glm::vec3& v) { put(v.x); put(v.y); put(v.z); };
+    auto put_quat = [&](const glm::quat& q) { put(q.w); put(q.x); put(q.y); put(q.z); };
+
+    put("chain"); put(static_cast<uint64_t>(joints.size())); put(static_cast<uint64_t>(tendons.size()));
+    put("\nroot"); put_vec3(root_pos); put_quat(root_quat);
+    put("\n");
+
+    for (const Joint& joint : joints) {
+        put("j"); put_vec3(joint.pos); put_quat(joint.rot); put_quat(joint.local_rot); put(joint.length);
+        put("\n");
+    }
+    for (const Tendon& tendon : tendons) {
+        put("t"); put(static_cast<uint64_t>(tendon.bone_idx)); put(tendon.t); put(tendon.local_offset.x); put(tendon.local_offset.y); put_vec3(tendon.up);
+        put("\n");
+    }
+    return ok_;
+}
+
+bool SceneTextWriter::finish()
+{
+    if (!file_) { return false; }
+
+    flush();
+    if (std::fclose(file_) != 0) { ok_ = false; }
+    file_ = nullptr;
+
+    if (!ok_) { std::fprintf(stderr, "Failed writing %s\n", path_.c_str()); }
+    return ok_;
+}
+
+// The buffer exists only after a successful open(), and nothing is written after a failure
+void SceneTextWriter::put(const char* text)
+{
+    if (!ok_) { return; }
+    size_t length = std::strlen(text);
+    if (used_ + length > buffer_.size()) { flush(); }
+    std::memcpy(buffer_.data() + used_, text, length);
+    used_ += length;
+}
+
+void SceneTextWriter::put(float value)
+{
+    // Shortest form that reads back to the same float
+    if (!ok_) { return; }
+    if (used_ + 32 > buffer_.size()) { flush(); }
+    buffer_[used_++] = ' ';
+    used_ = std::to_chars(buffer_.data() + used_, buffer_.data() + buffer_.size(), value).ptr - buffer_.data();
+}
+
+void SceneTextWriter::put(uint64_t value)
+{
+    if (!ok_) { return; }
+    if (used_ + 32 > buffer_.size()) { flush(); }
+    buffer_[used_++] = ' ';
+    used_ = std::to_chars(buffer_.data() + used_, buffer_.data() + buffer_.size(), value).ptr - buffer_.data();
+}
+
+void SceneTextWriter::flush()
+{
+    if (ok_ && used_ > 0) {
+        ok_ = std::fwrite(buffer_.data(), 1, used_, file_) == used_;
+    }
+    used_ = 0;
+}
@@ -0,0 +1,79 @@
+#pragma once
+
+#include <span>
+#include <string>
+#include <vector>
+#include <cstdio>
+#include <functional>
+
+#include <glm/glm.hpp>
+#include <glm/gtc/quaternion.hpp>
+
+#include "Main.hpp"
+
+
+// Text scene file for diffing and hand-editing; holds the same data as a binary scene file.
+// One record per line, fields separated by blanks, quaternions as w x y z:
+//   artichoke-scene 1
+//   chain <joints> <tendons>
+//   root <x> <y> <z> <qw> <qx> <qy> <qz>
+//   j <px> <py> <pz> <rot qw qx qy qz> <local_rot qw qx qy qz> <length>
+//   t <bone> <t> <normal offset> <binormal offset> <up x y z>
+// Joints and tendons belong to the chain line above them. Blank lines and lines
+// starting with '#' are ignored.
+struct SceneChain
+{
+    glm::vec3 root_pos{ 0.0f };
+    glm::quat root_quat{ 1, 0, 0, 0 };
+    std::vector<Joint> joints;
+    std::vector<Tendon> tendons;
+};
+
+
+// Single-pass reader over fixed-size blocks of the file; builds no document, only the chains
+class SceneTextReader
+{
+public:
+    // Hands each chain over as soon as it is complete. Errors go to stderr with their line.
+    bool read(const std::string& path, const std::function<void(SceneChain&&)>& on_chain);
+
+private:
+    bool parse_line(const char* begin, const char* end);
+    bool finish_chain();
+    bool fail(const char* reason);
+
+private:
+    std::string path_;
+    size_t line_{ 0 };
+    bool header_{ false };
+    bool in_chain_{ false };
+    size_t expected_joints_{ 0 };
+    size_t expected_tendons_{ 0 };
+    SceneChain chain_;
+    const std::function<void(SceneChain&&)>* on_chain_{ nullptr };
+};
+
+
+// Writes a text scene file one chain at a time
+class SceneTextWriter
+{
+public:
+    ~SceneTextWriter();
+
+    bool open(const std::string& path);
+    bool write_chain(const glm::vec3& root_pos, const glm::quat& root_quat, std::span<const Joint> joints, std::span<const Tendon> tendons);
+    bool finish();
+
+private:
+    void put(const char* text);
+    void put(float value);
+    void put(uint64_t value);
+    void flush();
+
+private:
+    FILE* file_{ nullptr };
+    std::string path_;
+    std::vector<char> buffer_;
+    size_t used_{ 0 };
+    bool ok_{ false };
+};
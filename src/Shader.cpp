@@ -30,14 +30,17 @@ std::string Shader::load_file(const char* path)
 }
 
 bool Shader::load(const char* vertexPath, const char* fragmentPath)
+{
+    return load(ShaderSource{ load_file(vertexPath), load_file(fragmentPath) });
+}
+
+bool Shader::load(const ShaderSource& source)
 {
     cleanup();
-    std::string vertSrc = load_file(vertexPath);
-    std::string fragSrc = load_file(fragmentPath);
-    if (vertSrc.empty() || fragSrc.empty()) return false;
+    if (source.vertex.empty() || source.fragment.empty()) return false;
 
-    GLuint vs = compile(GL_VERTEX_SHADER, vertSrc.c_str());
-    GLuint fs = compile(GL_FRAGMENT_SHADER, fragSrc.c_str());
+    GLuint vs = compile(GL_VERTEX_SHADER, source.vertex.c_str());
+    GLuint fs = compile(GL_FRAGMENT_SHADER, source.fragment.c_str());
     if (!vs || !fs) {
         if (vs) glDeleteShader(vs);
         if (fs) glDeleteShader(fs);
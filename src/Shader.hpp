@@ -6,6 +6,13 @@
 #include <glm/glm.hpp>
 
 
+struct ShaderSource
+{
+    std::string vertex;
+    std::string fragment;
+};
+
+
 class Shader
 {
 public:
@@ -14,6 +21,7 @@ public:
     ~Shader();
 
     bool load(const char* vertexPath, const char* fragmentPath);
+    bool load(const ShaderSource& source);
     void use() const { glUseProgram(program_); }
     void unuse() const { glUseProgram(0); }
 
@@ -27,9 +35,10 @@ public:
     GLuint id() const { return program_; }
     void destroy();
 
+    static std::string load_file(const char* path);
+
 private:
     GLuint program_ = 0;
     void cleanup();
     GLuint compile(GLenum type, const char* src);
-    std::string load_file(const char* path);
 };
@@ -0,0 +1,190 @@
+#include "Simulation.hpp"
+
+#include <algorithm>
+
+#include "Chain.hpp"
+#include "Trace.hpp"
+#include "JobSystem.hpp"
+#include "MemoryTracker.hpp"
+
+
+namespace {
+    // Ticks to keep running after the last input, so the last two snapshots agree and interpolation settles
+    constexpr int settle_ticks = 2;
+}
+
+
+Simulation::Simulation(float rate_hz) : 
+    rate_{ std::max(1.0f, rate_hz) }, dt_{ 1.0 / std::max(1.0f, rate_hz) }, start_time_{ Clock::now() }
+{
+}
+
+Simulation::~Simulation()
+{
+    stop();
+}
+
+void Simulation::start()
+{
+    if (running_) return;
+    running_ = true;
+    thread_ = std::thread([this]() { run(); });
+}
+
+void Simulation::stop()
+{
+    if (!running_) return;
+    {
+        std::lock_guard<std::mutex> lock(wake_mutex_);
+        running_ = false;
+    }
+    wake_.notify_one();
+    if (thread_.joinable()) { thread_.join(); }
+}
+
+double Simulation::now() const
+{
+    return std::chrono::duration<double>(Clock::now() - start_time_).count();
+}
+
+void Simulation::submit(const std::vector<std::shared_ptr<Chain>>& chains, const AnimationSpec& animation)
+{
+    PoseInput& in = input_.back();
+    in.serial = ++submitted_serial_;
+    in.animation = animation;
+
+    // Assigning into the recycled buffer keeps its capacity
+    in.chains.resize(chains.size());
+    for (size_t i = 0; i < chains.size(); ++i) {
+        in.chains[i].root_pos = chains[i]->root_pos();
+        in.chains[i].root_quat = chains[i]->root_quat();
+        in.chains[i].joints = chains[i]->joints();
+    }
+    input_.publish();
+    animating_ = animation.mode != AnimationMode::None;
+
+    {
+        std::lock_guard<std::mutex> lock(wake_mutex_);
+        input_pending_ = true;
+    }
+    wake_.notify_one();
+}
+
+void Simulation::run()
+{
+    Trace::set_thread_name("Simulation");
+    MemoryTracker::Scope memory(MemoryTag::Kinematics);
+
+    auto next = Clock::now();
+    int idle_ticks = settle_ticks;
+
+    while (running_) {
+        if (input_pending_.exchange(false)) {
+            idle_ticks = 0;
+        }
+
+        // Nothing to advance: sleep until new input arrives
+        if (idle_ticks >= settle_ticks && animation_.mode == AnimationMode::None) {
+            std::unique_lock<std::mutex> lock(wake_mutex_);
+            wake_.wait(lock, [this]() { return input_pending_ || !running_; });
+            next = Clock::now();
+            continue;
+        }
+
+        auto start = Clock::now();
+        {
+            Trace::Scope trace("Simulation step");
+            step(dt_);
+        }
+        step_ms_.store(std::chrono::duration<double, std::milli>(Clock::now() - start).count(), std::memory_order_relaxed);
+        ++idle_ticks;
+
+        // Fixed rate; if a step overran, resynchronize instead of trying to catch up
+        next += std::chrono::duration_cast<Clock::duration>(std::chrono::duration<double>(dt_));
+        auto current = Clock::now();
+        if (next < current) { next = current; }
+        std::this_thread::sleep_until(next);
+    }
+}
+
+void Simulation::step(double dt)
+{
+    if (input_.update()) {
+        const PoseInput& in = input_.front();
+        input_serial_ = in.serial;
+        animation_ = in.animation;
+        state_ = in.chains;
+    }
+
+    PoseSnapshot& out = output_.back();
+    out.tick = ++tick_;
+    out.input_serial = input_serial_;
+    out.time = now();
+    out.chains.resize(state_.size());
+    chain_animations_.resize(state_.size());
+
+    // Animation on the fixed timestep, then FK; chains are independent and run in parallel
+    double time = tick_ * dt;
+    size_t joints_per_chain = state_.empty() ? 1 : state_[0].joints.size();
+    JobSystem::instance().parallel_for("Chain FK", state_.size(), SceneGenerator::chain_grain(joints_per_chain), [&](size_t begin, size_t end) {
+        for (size_t c = begin; c < end; ++c) {
+            const ChainPose& base = state_[c];
+            ChainPose& pose = out.chains[c];
+            pose.root_pos = base.root_pos;
+            pose.root_quat = base.root_quat;
+            SceneGenerator::animate(animation_, time, c, base.root_pos, base.root_quat, base.joints, pose.joints, &chain_animations_[c]);
+        }
+    });
+    output_.publish();
+}
+
+bool Simulation::interpolate(std::vector<std::vector<Joint>>& out)
+{
+    // The outgoing front slot is swapped into prev_ rather than copied; the writer overwrites what it gets back
+    bool updated = output_.pending();
+    if (updated) {
+        std::swap(prev_, output_.front());
+        output_.update();
+        if (!has_snapshot_) {
+            prev_ = output_.front();
+            has_snapshot_ = true;
+        }
+    }
+    if (!has_snapshot_) return false;
+    const PoseSnapshot& curr = output_.front();
+
+    // Displayed one tick behind, so there is always a pair of snapshots to interpolate between
+    double t = now() - dt_;
+    double span = curr.time - prev_.time;
+    float alpha = (span > 0.0) ? static_cast<float>(std::clamp((t - prev_.time) / span, 0.0, 1.0)) : 1.0f;
+
+    bool matching = prev_.chains.size() == curr.chains.size();
+    out.resize(curr.chains.size());
+
+    size_t joints_per_chain = curr.chains.empty() ? 1 : curr.chains[0].joints.size();
+    JobSystem::instance().parallel_for("Interpolate", curr.chains.size(), SceneGenerator::chain_grain(joints_per_chain), [&](size_t begin, size_t end) {
+        for (size_t c = begin; c < end; ++c) {
+            const auto& b = curr.chains[c].joints;
+            out[c].resize(b.size());
+
+            if (!matching || prev_.chains[c].joints.size() != b.size()) {
+                std::copy(b.begin(), b.end(), out[c].begin());
+                continue;
+            }
+
+            const auto& a = prev_.chains[c].joints;
+            for (size_t i = 0; i < b.size(); ++i) {
+                out[c][i].pos = glm::mix(a[i].pos, b[i].pos, alpha);
+                out[c][i].rot = glm::slerp(a[i].rot, b[i].rot, alpha);
+                out[c][i].local_rot = b[i].local_rot;
+                out[c][i].length = b[i].length;
+            }
+        }
+    });
+
+    if (!matching) { alpha = 1.0f; }
+    if (updated || alpha != alpha_) { ++pose_version_; }
+    alpha_ = alpha;
+    settled_ = alpha >= 1.0f && curr.input_serial == submitted_serial_;
+    return true;
+}
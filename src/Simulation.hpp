@@ -0,0 +1,114 @@
+#pragma once
+
+#include <mutex>
+#include <memory>
+#include <atomic>
+#include <chrono>
+#include <thread>
+#include <vector>
+#include <cstdint>
+#include <condition_variable>
+
+#include <glm/glm.hpp>
+#include <glm/gtc/quaternion.hpp>
+
+#include "Main.hpp"
+#include "Animation.hpp"
+#include "TripleBuffer.hpp"
+#include "SceneGenerator.hpp"
+
+
+class Chain;
+
+
+struct ChainPose
+{
+    glm::vec3 root_pos{ 0.0f };
+    glm::quat root_quat{ 1, 0, 0, 0 };
+    std::vector<Joint> joints;
+};
+
+// Edit poses of all chains, handed from the render thread to the simulation
+struct PoseInput
+{
+    uint64_t serial = 0;
+    std::vector<ChainPose> chains;
+    AnimationSpec animation;
+};
+
+// Immutable result of one simulation tick
+struct PoseSnapshot
+{
+    uint64_t tick = 0;
+    uint64_t input_serial = 0;  // Last input reflected in this snapshot
+    double time = 0.0;          // Simulation time of this tick, in seconds since start
+    std::vector<ChainPose> chains;
+};
+
+
+// Advances the state of all chains (animation, FK) on its own thread at a fixed rate.
+// The render thread submits edited poses and reads interpolated snapshots.
+class Simulation
+{
+public:
+    explicit Simulation(float rate_hz);
+    ~Simulation();
+
+    void start();
+    void stop();
+
+    // Render thread: hands the current edit poses (local rotations, lengths, roots) to the simulation
+    void submit(const std::vector<std::shared_ptr<Chain>>& chains, const AnimationSpec& animation);
+
+    // Render thread: poses interpolated between the two latest snapshots, one per chain; false until the first tick
+    bool interpolate(std::vector<std::vector<Joint>>& out);
+
+    // Render thread: changes whenever interpolate() produces different poses
+    uint64_t pose_version() const { return pose_version_; }
+
+    // Render thread: true once the displayed pose has caught up with the latest input and nothing animates
+    bool settled() const { return settled_ && !animating_ && output_.front().input_serial == submitted_serial_; }
+
+    float rate() const { return rate_; }
+    double step_ms() const { return step_ms_.load(std::memory_order_relaxed); }
+
+private:
+    using Clock = std::chrono::steady_clock;
+
+    void run();
+    void step(double dt);
+    double now() const;
+
+private:
+    float rate_;
+    double dt_;
+    Clock::time_point start_time_;
+
+    std::thread thread_;
+    std::atomic<bool> running_{ false };
+    std::atomic<double> step_ms_{ 0.0 };
+
+    // Wakes the thread when new input arrives; it sleeps while there is nothing to advance
+    std::mutex wake_mutex_;
+    std::condition_variable wake_;
+    std::atomic<bool> input_pending_{ false };
+
+    // Simulation thread state
+    std::vector<ChainPose> state_;
+    AnimationSpec animation_;
+    std::vector<ChainAnimation> chain_animations_;     // Per chain
+    uint64_t tick_{ 0 };
+    uint64_t input_serial_{ 0 };
+
+    TripleBuffer<PoseInput> input_;
+    TripleBuffer<PoseSnapshot> output_;
+
+    // Render thread state; the current snapshot is read in place from the output's front slot
+    PoseSnapshot prev_;
+    uint64_t submitted_serial_{ 0 };
+    bool has_snapshot_{ false };
+    float alpha_{ -1.0f };              // Of the last interpolation
+    uint64_t pose_version_{ 0 };
+    bool settled_{ true };
+    bool animating_{ false };
+};
@@ -0,0 +1,89 @@
+#include "Startup.hpp"
+
+#include <cstdio>
+#include <algorithm>
+
+#include <imgui.h>
+
+#include "Resources.hpp"
+#include "MemoryTracker.hpp"
+
+
+Startup::Startup() : origin_{ Clock::now() }
+{
+    shader_task_ = std::async(std::launch::async, [this]() {
+        MemoryTracker::Scope memory(MemoryTag::IO);
+        auto start = Clock::now();
+        ShaderSource source{ Resources::read_text("color.vert"), Resources::read_text("color.frag") };
+        record("Read shaders", true, start);
+        return source;
+    });
+
+    // The atlas is built without an ImGui context, which is created on the main thread only after this finishes
+    font_task_ = std::async(std::launch::async, [this]() {
+        MemoryTracker::Scope memory(MemoryTag::IO);
+        auto start = Clock::now();
+        auto atlas = Resources::load_font_atlas();
+        record(Resources::override_dir().empty() ? "Restore font atlas" : "Bake font atlas", true, start);
+        return atlas;
+    });
+}
+
+Startup::~Startup()
+{
+    // Never leave a worker running past the pipeline's lifetime
+    if (shader_task_.valid()) { shader_task_.wait(); }
+    if (font_task_.valid()) { font_task_.wait(); }
+}
+
+void Startup::begin_phase(const char* name)
+{
+    current_phase_ = name;
+    current_start_ = Clock::now();
+}
+
+void Startup::end_phase()
+{
+    record(current_phase_.c_str(), false, current_start_);
+}
+
+const ShaderSource& Startup::shader_source()
+{
+    if (!shader_ready_) {
+        shader_source_ = shader_task_.get();
+        shader_ready_ = true;
+    }
+    return shader_source_;
+}
+
+std::unique_ptr<ImFontAtlas> Startup::take_font_atlas()
+{
+    return font_task_.valid() ? font_task_.get() : nullptr;
+}
+
+void Startup::record(const char* name, bool worker, Clock::time_point start)
+{
+    std::lock_guard<std::mutex> lock(mutex_);
+    phases_.push_back({ name, worker, start, Clock::now() });
+}
+
+void Startup::report(std::FILE* out) const
+{
+    auto ms = [this](Clock::time_point t) {
+        return std::chrono::duration<double, std::milli>(t - origin_).count();
+    };
+
+    std::lock_guard<std::mutex> lock(mutex_);
+
+    std::vector<Phase> phases = phases_;
+    std::sort(phases.begin(), phases.end(), [](const Phase& a, const Phase& b) { return a.start < b.start; });
+
+    double total = 0.0;
+    std::fprintf(out, "Startup timing (ms):\n");
+    for (const auto& p : phases) {
+        std::fprintf(out, "  %-6s %-18s %8.2f  [%8.2f .. %8.2f]\n",
+            p.worker ? "worker" : "main", p.name.c_str(), ms(p.end) - ms(p.start), ms(p.start), ms(p.end));
+        total = std::max(total, ms(p.end));
+    }
+    std::fprintf(out, "  %-25s %8.2f\n", "Total", total);
+}
@@ -0,0 +1,60 @@
+#pragma once
+
+#include <cstdio>
+#include <mutex>
+#include <chrono>
+#include <future>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "Shader.hpp"
+
+
+struct ImFontAtlas;
+
+
+// Startup pipeline: file I/O and font atlas baking run on worker threads while the GL context comes up
+class Startup
+{
+public:
+    Startup();
+    ~Startup();
+
+    // Main-thread phase timing
+    void begin_phase(const char* name);
+    void end_phase();
+
+    // Resources produced by the workers (block until ready)
+    const ShaderSource& shader_source();
+    std::unique_ptr<ImFontAtlas> take_font_atlas();
+
+    // Prints the per-phase timing report
+    void report(std::FILE* out = stdout) const;
+
+private:
+    using Clock = std::chrono::steady_clock;
+
+    struct Phase
+    {
+        std::string name;
+        bool worker;
+        Clock::time_point start;
+        Clock::time_point end;
+    };
+
+    void record(const char* name, bool worker, Clock::time_point start);
+
+private:
+    Clock::time_point origin_;
+
+    mutable std::mutex mutex_;
+    std::vector<Phase> phases_;
+    std::string current_phase_;
+    Clock::time_point current_start_;
+
+    std::future<ShaderSource> shader_task_;
+    std::future<std::unique_ptr<ImFontAtlas>> font_task_;
+    ShaderSource shader_source_;
+    bool shader_ready_{ false };
+};
@@ -0,0 +1,232 @@
+#include "Trace.hpp"
+
+#include <mutex>
+#include <chrono>
+#include <cstdio>
+#include <memory>
+#include <thread>
+#include <vector>
+#include <iostream>
+
+#include "MemoryTracker.hpp"
+
+
+namespace
+{
+    using Clock = std::chrono::steady_clock;
+
+    struct Event
+    {
+        const char* name;
+        uint64_t start_ns;
+        uint64_t end_ns;
+    };
+
+    // Single producer (the owning thread), single consumer (the flush thread)
+    struct ThreadBuffer
+    {
+        static constexpr uint64_t capacity = 1 << 15;
+
+        uint32_t tid = 0;
+        std::string name;
+        std::vector<Event> events;              // The ring, allocated by the first event
+        std::atomic<uint64_t> write{ 0 };
+        std::atomic<uint64_t> read{ 0 };
+        std::atomic<uint64_t> dropped{ 0 };
+        std::atomic<bool> exited{ false };
+    };
+
+    // Registers the thread's buffer when it records its first event, and marks it exited with the thread
+    struct LocalBuffer
+    {
+        std::string name;
+        std::shared_ptr<ThreadBuffer> buffer;
+
+        ~LocalBuffer()
+        {
+            if (buffer) { buffer->exited.store(true, std::memory_order_release); }
+        }
+    };
+
+    thread_local LocalBuffer local;
+
+    const Clock::time_point epoch = Clock::now();
+
+    // Buffers stay registered after their thread exits until their last events are written
+    std::mutex registry_mutex;
+    std::vector<std::shared_ptr<ThreadBuffer>> registry;
+    uint32_t next_tid = 1;
+    uint64_t retired_dropped = 0;               // Of buffers no longer registered
+
+    std::mutex control_mutex;
+    std::thread flush_thread;
+    std::atomic<bool> stop_requested{ false };
+    std::FILE* file = nullptr;
+    bool first_event = true;
+
+    ThreadBuffer& local_buffer()
+    {
+        if (!local.buffer) {
+            auto created = std::make_shared<ThreadBuffer>();
+            created->events.resize(ThreadBuffer::capacity);
+            std::lock_guard<std::mutex> lock(registry_mutex);
+            created->tid = next_tid++;
+            created->name = local.name;
+            registry.push_back(created);
+            local.buffer = std::move(created);
+        }
+        return *local.buffer;
+    }
+
+    void write_thread_name(const ThreadBuffer& buffer);
+
+    void write_event(const char* name, const char* phase, uint32_t tid, double ts_us, double dur_us)
+    {
+        std::fprintf(file, "%s\n{\"name\":\"%s\",\"cat\":\"artichoke\",\"ph\":\"%s\",\"ts\":%.3f,\"dur\":%.3f,\"pid\":1,\"tid\":%u}",
+            first_event ? "" : ",", name, phase, ts_us, dur_us, tid);
+        first_event = false;
+    }
+
+    void drain()
+    {
+        std::vector<std::shared_ptr<ThreadBuffer>> buffers;
+        {
+            std::lock_guard<std::mutex> lock(registry_mutex);
+            buffers = registry;
+        }
+
+        for (auto& buffer : buffers) {
+            uint64_t read = buffer->read.load(std::memory_order_relaxed);
+            uint64_t write = buffer->write.load(std::memory_order_acquire);
+            for (; read < write; ++read) {
+                const Event& e = buffer->events[read % ThreadBuffer::capacity];
+                write_event(e.name, "X", buffer->tid, e.start_ns / 1e3, (e.end_ns - e.start_ns) / 1e3);
+            }
+            buffer->read.store(read, std::memory_order_release);
+        }
+
+        // Buffers of exited threads go once drained; their names are written now, as they will not be at the end
+        std::lock_guard<std::mutex> lock(registry_mutex);
+        std::erase_if(registry, [](const std::shared_ptr<ThreadBuffer>& buffer) {
+            if (!buffer->exited.load(std::memory_order_acquire) || 
+                buffer->read.load(std::memory_order_relaxed) != buffer->write.load(std::memory_order_acquire)) return false;
+            retired_dropped += buffer->dropped.load(std::memory_order_relaxed);
+            write_thread_name(*buffer);
+            return true;
+        });
+    }
+
+    void write_thread_name(const ThreadBuffer& buffer)
+    {
+        if (buffer.name.empty()) return;
+        std::fprintf(file, "%s\n{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":%u,\"args\":{\"name\":\"%s\"}}", 
+            first_event ? "" : ",", buffer.tid, buffer.name.c_str());
+        first_event = false;
+    }
+}
+
+
+std::atomic<bool> Trace::active_{ false };
+
+bool Trace::start(const std::string& path, double seconds)
+{
+    std::lock_guard<std::mutex> lock(control_mutex);
+    if (active()) return false;
+    if (flush_thread.joinable()) { flush_thread.join(); }
+
+    file = std::fopen(path.c_str(), "w");
+    if (!file) {
+        std::cerr << "Failed to open trace file: " << path << std::endl;
+        return false;
+    }
+
+    // Drop whatever was recorded after the previous trace ended
+    {
+        std::lock_guard<std::mutex> registry_lock(registry_mutex);
+        for (auto& buffer : registry) {
+            buffer->read.store(buffer->write.load(std::memory_order_acquire), std::memory_order_release);
+            buffer->dropped.store(0, std::memory_order_relaxed);
+        }
+        std::erase_if(registry, [](const std::shared_ptr<ThreadBuffer>& buffer) { return buffer->exited.load(std::memory_order_acquire); });
+        retired_dropped = 0;
+    }
+
+    std::fprintf(file, "{\"displayTimeUnit\":\"ms\",\"traceEvents\":[");
+    first_event = true;
+
+    std::cerr << "Tracing for " << seconds << " s to " << path << std::endl;
+    stop_requested = false;
+    active_.store(true, std::memory_order_relaxed);
+    flush_thread = std::thread(&Trace::flush_main, seconds);
+    return true;
+}
+
+void Trace::stop()
+{
+    std::lock_guard<std::mutex> lock(control_mutex);
+    stop_requested = true;
+    if (flush_thread.joinable()) { flush_thread.join(); }
+}
+
+void Trace::set_thread_name(const std::string& name)
+{
+    // Kept until the thread records an event; threads that never do cost no ring
+    local.name = name;
+    if (local.buffer) {
+        std::lock_guard<std::mutex> lock(registry_mutex);
+        local.buffer->name = name;
+    }
+}
+
+uint64_t Trace::now()
+{
+    return static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(Clock::now() - epoch).count());
+}
+
+void Trace::record(const char* name, uint64_t start_ns, uint64_t end_ns)
+{
+    // Scopes that began during a trace may end just after it; they only fill rings that exist
+    if (!local.buffer && !active()) return;
+    ThreadBuffer& buffer = local_buffer();
+
+    uint64_t write = buffer.write.load(std::memory_order_relaxed);
+    if (write - buffer.read.load(std::memory_order_acquire) >= ThreadBuffer::capacity) {
+        buffer.dropped.fetch_add(1, std::memory_order_relaxed);
+        return;
+    }
+
+    buffer.events[write % ThreadBuffer::capacity] = { name, start_ns, end_ns };
+    buffer.write.store(write + 1, std::memory_order_release);
+}
+
+void Trace::flush_main(double seconds)
+{
+    MemoryTracker::Scope memory(MemoryTag::IO);
+    auto deadline = Clock::now() + std::chrono::duration_cast<Clock::duration>(std::chrono::duration<double>(seconds));
+
+    while (!stop_requested && Clock::now() < deadline) {
+        std::this_thread::sleep_for(std::chrono::milliseconds(20));
+        drain();
+    }
+    active_.store(false, std::memory_order_relaxed);
+
+    // Let scopes that started before the stop finish
+    std::this_thread::sleep_for(std::chrono::milliseconds(20));
+    drain();
+
+    uint64_t dropped = 0;
+    {
+        std::lock_guard<std::mutex> lock(registry_mutex);
+        dropped = retired_dropped;
+        for (auto& buffer : registry) {
+            dropped += buffer->dropped.load(std::memory_order_relaxed);
+            write_thread_name(*buffer);
+        }
+    }
+
+    std::fprintf(file, "\n]}\n");
+    std::fclose(file);
+    file = nullptr;
+
+    std::cerr << "Trace written" << (dropped ? " (" + std::to_string(dropped) + " events dropped)" : std::string()) << std::endl;
+}
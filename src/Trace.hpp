@@ -0,0 +1,53 @@
+#pragma once
+
+#include <atomic>
+#include <string>
+#include <cstdint>
+
+
+// Timeline capture in Chrome trace_event format (chrome://tracing, ui.perfetto.dev).
+// Every thread records complete events into its own lock-free ring; a flush thread
+// drains the rings into the JSON file while tracing, off the hot path. Scopes cost a
+// single relaxed load while no trace is running.
+class Trace
+{
+public:
+    // Records the enclosing block. Names must outlive the trace (string literals).
+    class Scope
+    {
+    public:
+        explicit Scope(const char* name) : name_{ Trace::active() ? name : nullptr }, start_{ name_ ? Trace::now() : 0 } {}
+        ~Scope()
+        {
+            if (name_) { Trace::record(name_, start_, Trace::now()); }
+        }
+
+        Scope(const Scope&) = delete;
+        Scope& operator=(const Scope&) = delete;
+
+    private:
+        const char* name_;
+        uint64_t start_;
+    };
+
+    // Traces for the given duration into path; false if a trace is running or the file fails
+    static bool start(const std::string& path, double seconds);
+
+    // Ends a running trace early and finishes the file
+    static void stop();
+
+    static bool active() { return active_.load(std::memory_order_relaxed); }
+
+    // Names the calling thread in the trace
+    static void set_thread_name(const std::string& name);
+
+    // Nanoseconds since the trace clock epoch
+    static uint64_t now();
+    static void record(const char* name, uint64_t start_ns, uint64_t end_ns);
+
+private:
+    static void flush_main(double seconds);
+
+private:
+    static std::atomic<bool> active_;
+};
@@ -0,0 +1,47 @@
+#pragma once
+
+#include <array>
+#include <atomic>
+#include <cstdint>
+
+
+// Lock-free single-producer/single-consumer triple buffer. The writer fills the
+// back slot and publishes it; the reader picks up the most recently published
+// slot. Neither side ever waits, and slots keep their capacity between uses.
+template <typename T>
+class TripleBuffer
+{
+public:
+    TripleBuffer() : back_{ 0 }, middle_{ 1 }, front_{ 2 } {}
+
+    // Writer side
+    T& back() { return slots_[back_]; }
+    void publish() {
+        uint8_t prev = middle_.exchange(static_cast<uint8_t>(back_ | dirty_bit), std::memory_order_acq_rel);
+        back_ = prev & index_mask;
+    }
+
+    // Reader side: true if a newer slot was published since the last update()
+    bool pending() const { return middle_.load(std::memory_order_relaxed) & dirty_bit; }
+
+    // Reader side: returns true if a newer slot was published since the last call
+    bool update() {
+        if (!(middle_.load(std::memory_order_relaxed) & dirty_bit)) return false;
+        uint8_t prev = middle_.exchange(front_, std::memory_order_acq_rel);
+        front_ = prev & index_mask;
+        return true;
+    }
+    const T& front() const { return slots_[front_]; }
+
+    // The reader may swap the front slot's contents out before update() hands it back; the writer refills it
+    T& front() { return slots_[front_]; }
+
+private:
+    static constexpr uint8_t dirty_bit = 0x4;
+    static constexpr uint8_t index_mask = 0x3;
+
+    std::array<T, 3> slots_;
+    uint8_t back_;
+    std::atomic<uint8_t> middle_;
+    uint8_t front_;
+};
@@ -0,0 +1,140 @@
+// Build-time resource baker: writes a C++ source that embeds the shaders and a
+// pre-rasterized font atlas into the Artichoke executable.
+//
+// Usage: artichoke_bake <res_dir> <output.cpp>
+
+#include <cstdio>
+#include <string>
+#include <vector>
+#include <fstream>
+#include <iostream>
+#include <iterator>
+#include <algorithm>
+#include <filesystem>
+
+#include <imgui.h>
+
+#include "FontAtlas.hpp"
+
+
+namespace {
+    void write_bytes(FILE* out, const char* name, const unsigned char* data, size_t size) {
+        std::fprintf(out, "static const unsigned char %s[] = {", name);
+        for (size_t i = 0; i < size; ++i) {
+            std::fprintf(out, "%s%u,", (i % 32 == 0) ? "\n    " : "", data[i]);
+        }
+        // Zero-sized arrays are not allowed
+        std::fprintf(out, "%s0\n};\n\n", size == 0 ? "\n    " : "");
+    }
+
+    void write_float(FILE* out, float v) {
+        // Hex floats round-trip exactly
+        std::fprintf(out, "%af", v);
+    }
+}
+
+int main(int argc, char* argv[])
+{
+    if (argc != 3) {
+        std::cerr << "Usage: " << argv[0] << " <res_dir> <output.cpp>" << std::endl;
+        return 1;
+    }
+
+    const std::filesystem::path res_dir = argv[1];
+    const std::filesystem::path out_path = argv[2];
+
+    // Shader sources, in a stable order
+    std::vector<std::filesystem::path> shaders;
+    for (const auto& entry : std::filesystem::directory_iterator(res_dir)) {
+        auto ext = entry.path().extension();
+        if (ext == ".vert" || ext == ".frag" || ext == ".glsl") {
+            shaders.push_back(entry.path());
+        }
+    }
+    std::sort(shaders.begin(), shaders.end());
+
+    // Font atlas, rasterized exactly as the application would at runtime
+    ImFontAtlas atlas;
+    if (!FontAtlas::rasterize(atlas, res_dir.string())) {
+        std::cerr << "Failed to rasterize fonts from " << res_dir << std::endl;
+        return 1;
+    }
+    unsigned char* pixels = nullptr;
+    int width = 0, height = 0;
+    atlas.GetTexDataAsAlpha8(&pixels, &width, &height);
+
+    std::filesystem::create_directories(out_path.parent_path());
+    FILE* out = std::fopen(out_path.string().c_str(), "w");
+    if (!out) {
+        std::cerr << "Cannot write " << out_path << std::endl;
+        return 1;
+    }
+
+    std::fprintf(out, "// Generated by artichoke_bake from %s. Do not edit.\n\n", res_dir.filename().string().c_str());
+    std::fprintf(out, "#include \"Resources.hpp\"\n\n\n");
+
+    // Embedded files
+    for (size_t i = 0; i < shaders.size(); ++i) {
+        std::ifstream file(shaders[i], std::ios::binary);
+        std::vector<unsigned char> data((std::istreambuf_iterator<char>(file)), std::istreambuf_iterator<char>());
+        write_bytes(out, ("file_" + std::to_string(i)).c_str(), data.data(), data.size());
+    }
+    std::fprintf(out, "const EmbeddedFile Resources::embedded_files[] = {\n");
+    for (size_t i = 0; i < shaders.size(); ++i) {
+        std::fprintf(out, "    { \"%s\", file_%zu, sizeof(file_%zu) - 1 },\n", shaders[i].filename().string().c_str(), i, i);
+    }
+    if (shaders.empty()) {
+        std::fprintf(out, "    { \"\", nullptr, 0 },\n");
+    }
+    std::fprintf(out, "};\n\nconst size_t Resources::embedded_file_count = %zu;\n\n\n", shaders.size());
+
+    // Atlas texture and custom rects
+    write_bytes(out, "atlas_pixels", pixels, static_cast<size_t>(width) * height);
+
+    const int line_count = IM_ARRAYSIZE(atlas.TexUvLines);
+    std::fprintf(out, "static const float atlas_line_uvs[] = {");
+    for (int i = 0; i < line_count; ++i) {
+        const ImVec4& uv = atlas.TexUvLines[i];
+        std::fprintf(out, "\n    ");
+        for (float v : { uv.x, uv.y, uv.z, uv.w }) { write_float(out, v); std::fprintf(out, ", "); }
+    }
+    std::fprintf(out, "\n};\n\n");
+
+    std::fprintf(out, "static const BakedRect atlas_rects[] = {\n");
+    for (const auto& r : atlas.CustomRects) {
+        std::fprintf(out, "    { %u, %u, %u, %u },\n", r.X, r.Y, r.Width, r.Height);
+    }
+    std::fprintf(out, "};\n\n");
+
+    // Fonts and their glyphs
+    for (int f = 0; f < atlas.Fonts.Size; ++f) {
+        const ImFont* font = atlas.Fonts[f];
+        std::fprintf(out, "static const BakedGlyph font_%d_glyphs[] = {\n", f);
+        for (const ImFontGlyph& g : font->Glyphs) {
+            std::fprintf(out, "    { %u, %u, ", (unsigned)g.Codepoint, (unsigned)g.Visible);
+            for (float v : { g.AdvanceX, g.X0, g.Y0, g.X1, g.Y1, g.U0, g.V0, g.U1, g.V1 }) { write_float(out, v); std::fprintf(out, ", "); }
+            std::fprintf(out, "},\n");
+        }
+        std::fprintf(out, "};\n\n");
+    }
+
+    std::fprintf(out, "static const BakedFont atlas_fonts[] = {\n");
+    for (int f = 0; f < atlas.Fonts.Size; ++f) {
+        const ImFont* font = atlas.Fonts[f];
+        std::fprintf(out, "    { \"%s\", ", font->GetDebugName());
+        for (float v : { font->FontSize, font->Ascent, font->Descent }) { write_float(out, v); std::fprintf(out, ", "); }
+        std::fprintf(out, "font_%d_glyphs, %d },\n", f, font->Glyphs.Size);
+    }
+    std::fprintf(out, "};\n\n");
+
+    std::fprintf(out, "const BakedAtlas Resources::embedded_atlas = {\n");
+    std::fprintf(out, "    %d, %d, atlas_pixels,\n    { ", width, height);
+    write_float(out, atlas.TexUvWhitePixel.x); std::fprintf(out, ", ");
+    write_float(out, atlas.TexUvWhitePixel.y);
+    std::fprintf(out, " },\n    atlas_line_uvs, %d,\n", line_count);
+    std::fprintf(out, "    atlas_rects, %d, %d, %d, %d,\n", atlas.CustomRects.Size, atlas.PackIdMouseCursors, atlas.PackIdLines, atlas.Flags);
+    std::fprintf(out, "    atlas_fonts, %d,\n};\n", atlas.Fonts.Size);
+
+    std::fclose(out);
+    return 0;
+}